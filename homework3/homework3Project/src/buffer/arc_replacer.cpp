@@ -0,0 +1,156 @@
+/**
+ * arc_replacer.cpp
+ */
+
+#include <algorithm>
+
+#include "buffer/arc_replacer.h"
+#include "page/page.h"
+
+namespace scudb {
+
+template <typename T>
+ARCReplacer<T>::ARCReplacer(size_t capacity)
+    : capacity_(std::max<size_t>(capacity, 1)), target_(0), size_(0) {}
+
+template <typename T> ARCReplacer<T>::~ARCReplacer() {}
+
+/*
+ * A resident value moves to the most recently used end of T2. A new value
+ * found in a ghost list adapts the target and joins T2, any other new value
+ * joins T1
+ */
+template <typename T> void ARCReplacer<T>::Insert(const T &value) {
+  std::lock_guard<std::mutex> lck(latch_);
+  int64_t key = ReplacerKey(value);
+  auto it = entries_.find(value);
+  if (it != entries_.end() && it->second.key_ != key) {
+    (it->second.frequent_ ? t2_ : t1_).erase(it->second.pos_);
+    if (it->second.evictable_) {
+      --size_;
+    }
+    entries_.erase(it);
+    it = entries_.end();
+  }
+  if (it != entries_.end()) {
+    Entry &entry = it->second;
+    t2_.splice(t2_.end(), entry.frequent_ ? t2_ : t1_, entry.pos_);
+    entry.frequent_ = true;
+    if (!entry.evictable_) {
+      entry.evictable_ = true;
+      ++size_;
+    }
+    return;
+  }
+  bool frequent = true;
+  if (b1_.Contains(key)) {
+    size_t delta = std::max<size_t>(b2_.Size() / b1_.Size(), 1);
+    target_ = std::min(capacity_, target_ + delta);
+    b1_.Erase(key);
+  } else if (b2_.Contains(key)) {
+    size_t delta = std::max<size_t>(b1_.Size() / b2_.Size(), 1);
+    target_ -= std::min(target_, delta);
+    b2_.Erase(key);
+  } else {
+    frequent = false;
+  }
+  std::list<T> &list = frequent ? t2_ : t1_;
+  entries_[value] = Entry{key, frequent, true, list.insert(list.end(), value)};
+  ++size_;
+  TrimGhosts();
+}
+
+/*
+ * Evict the least recently used eligible value of T1 while T1 is larger
+ * than the target, else of T2, falling back to the other list
+ */
+template <typename T> bool ARCReplacer<T>::Victim(T &value) {
+  std::lock_guard<std::mutex> lck(latch_);
+  if (size_ == 0) {
+    return false;
+  }
+  std::list<T> *list = t1_.size() > target_ ? &t1_ : &t2_;
+  auto it = NextEvictable(*list, list->begin());
+  if (it == list->end()) {
+    list = list == &t1_ ? &t2_ : &t1_;
+    it = NextEvictable(*list, list->begin());
+  }
+  value = *it;
+  list->erase(it);
+  auto entry = entries_.find(value);
+  (list == &t1_ ? b1_ : b2_).PushBack(entry->second.key_);
+  entries_.erase(entry);
+  --size_;
+  TrimGhosts();
+  return true;
+}
+
+template <typename T> bool ARCReplacer<T>::Erase(const T &value) {
+  std::lock_guard<std::mutex> lck(latch_);
+  auto it = entries_.find(value);
+  if (it == entries_.end() || !it->second.evictable_) {
+    return false;
+  }
+  it->second.evictable_ = false;
+  --size_;
+  return true;
+}
+
+template <typename T> size_t ARCReplacer<T>::Size() {
+  std::lock_guard<std::mutex> lck(latch_);
+  return size_;
+}
+
+/*
+ * Replay Victim's choices without evicting: T1 shrinks with every value
+ * taken from it
+ */
+template <typename T>
+void ARCReplacer<T>::PeekVictims(std::vector<T> &values, size_t max_count) {
+  std::lock_guard<std::mutex> lck(latch_);
+  size_t t1_size = t1_.size();
+  auto recent = NextEvictable(t1_, t1_.begin());
+  auto frequent = NextEvictable(t2_, t2_.begin());
+  for (; max_count > 0 && (recent != t1_.end() || frequent != t2_.end());
+       --max_count) {
+    if (recent != t1_.end() && (t1_size > target_ || frequent == t2_.end())) {
+      values.push_back(*recent);
+      --t1_size;
+      recent = NextEvictable(t1_, ++recent);
+    } else {
+      values.push_back(*frequent);
+      frequent = NextEvictable(t2_, ++frequent);
+    }
+  }
+}
+
+template <typename T> size_t ARCReplacer<T>::GetTarget() {
+  std::lock_guard<std::mutex> lck(latch_);
+  return target_;
+}
+
+template <typename T>
+typename std::list<T>::iterator
+ARCReplacer<T>::NextEvictable(std::list<T> &list,
+                              typename std::list<T>::iterator it) {
+  while (it != list.end() && !entries_.find(*it)->second.evictable_) {
+    ++it;
+  }
+  return it;
+}
+
+template <typename T> void ARCReplacer<T>::TrimGhosts() {
+  while (t1_.size() + b1_.Size() > capacity_ && !b1_.Empty()) {
+    b1_.PopFront();
+  }
+  while (t1_.size() + t2_.size() + b1_.Size() + b2_.Size() > 2 * capacity_ &&
+         !b2_.Empty()) {
+    b2_.PopFront();
+  }
+}
+
+template class ARCReplacer<Page *>;
+// test only
+template class ARCReplacer<int>;
+
+} // namespace scudb
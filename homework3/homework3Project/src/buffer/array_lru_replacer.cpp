@@ -0,0 +1,88 @@
+/**
+ * array_lru_replacer.cpp
+ */
+
+#include <cassert>
+
+#include "buffer/array_lru_replacer.h"
+#include "page/page.h"
+
+namespace scudb {
+
+template <typename T>
+ArrayLRUReplacer<T>::ArrayLRUReplacer(size_t capacity, T first)
+    : first_(first), head_(static_cast<uint32_t>(capacity)), size_(0),
+      nodes_(capacity + 1, Node{0, 0, false}) {
+  nodes_[head_].prev_ = nodes_[head_].next_ = head_;
+}
+
+template <typename T> ArrayLRUReplacer<T>::~ArrayLRUReplacer() {}
+
+/*
+ * Move value to the most recently used end
+ */
+template <typename T> void ArrayLRUReplacer<T>::Insert(const T &value) {
+  std::lock_guard<std::mutex> lck(latch_);
+  uint32_t index = IndexOf(value);
+  assert(index < head_);
+  if (nodes_[index].linked_) {
+    Unlink(index);
+  }
+  Node &node = nodes_[index];
+  node.prev_ = head_;
+  node.next_ = nodes_[head_].next_;
+  node.linked_ = true;
+  nodes_[node.next_].prev_ = index;
+  nodes_[head_].next_ = index;
+  ++size_;
+}
+
+template <typename T> bool ArrayLRUReplacer<T>::Victim(T &value) {
+  std::lock_guard<std::mutex> lck(latch_);
+  uint32_t index = nodes_[head_].prev_;
+  if (index == head_) {
+    return false;
+  }
+  Unlink(index);
+  value = first_ + index;
+  return true;
+}
+
+template <typename T> bool ArrayLRUReplacer<T>::Erase(const T &value) {
+  std::lock_guard<std::mutex> lck(latch_);
+  uint32_t index = IndexOf(value);
+  if (index >= head_ || !nodes_[index].linked_) {
+    return false;
+  }
+  Unlink(index);
+  return true;
+}
+
+template <typename T> size_t ArrayLRUReplacer<T>::Size() {
+  std::lock_guard<std::mutex> lck(latch_);
+  return size_;
+}
+
+template <typename T>
+void ArrayLRUReplacer<T>::PeekVictims(std::vector<T> &values,
+                                      size_t max_count) {
+  std::lock_guard<std::mutex> lck(latch_);
+  for (uint32_t index = nodes_[head_].prev_; index != head_ && max_count > 0;
+       index = nodes_[index].prev_, --max_count) {
+    values.push_back(first_ + index);
+  }
+}
+
+template <typename T> void ArrayLRUReplacer<T>::Unlink(uint32_t index) {
+  Node &node = nodes_[index];
+  nodes_[node.prev_].next_ = node.next_;
+  nodes_[node.next_].prev_ = node.prev_;
+  node.linked_ = false;
+  --size_;
+}
+
+template class ArrayLRUReplacer<Page *>;
+// test only
+template class ArrayLRUReplacer<int>;
+
+} // namespace scudb
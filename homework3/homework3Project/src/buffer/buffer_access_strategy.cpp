@@ -0,0 +1,19 @@
+/**
+ * buffer_access_strategy.cpp
+ */
+
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_manager.h"
+
+namespace scudb {
+
+BufferAccessStrategy::BufferAccessStrategy(size_t ring_size)
+    : ring_size_(ring_size == 0 ? 1 : ring_size), num_reused_(0) {}
+
+BufferAccessStrategy::~BufferAccessStrategy() {
+  for (auto &ring : rings_) {
+    ring.first->ReleaseRing(this, ring.second.frames_);
+  }
+}
+
+} // namespace scudb
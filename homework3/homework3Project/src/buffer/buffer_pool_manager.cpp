@@ -1,38 +1,82 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
 #include "buffer/buffer_pool_manager.h"
 
 namespace scudb {
 
 /*
  * BufferPoolManager Constructor
- * When log_manager is nullptr, logging is disabled (for test purpose)
- * WARNING: Do Not Edit This Function
+ * When log_manager is nullptr, logging is disabled (for test purpose). The
+ * frames of the largest pool are claimed up front, only pool_size are free
  */
 BufferPoolManager::BufferPoolManager(size_t pool_size,
-                                                 DiskManager *disk_manager,
-                                                 LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager),
+                                     DiskManager *disk_manager,
+                                     LogManager *log_manager,
+                                     ReplacerPolicy policy, FrameMemory memory,
+                                     bool numa_aware, size_t max_pool_size)
+    : pool_size_(pool_size), max_pool_size_(std::max(pool_size, max_pool_size)),
+      page_size_(disk_manager->GetPageSize()), disk_manager_(disk_manager),
       log_manager_(log_manager) {
-  // a consecutive memory space for buffer pool
-  pages_ = new Page[pool_size_];
-  page_table_ = new ExtendibleHash<page_id_t, Page *>(BUCKET_SIZE);
-  replacer_ = new LRUReplacer<Page *>;
-  free_list_ = new std::list<Page *>;
+  // a consecutive memory space for buffer pool, reserved for its largest
+  // size
+  frame_arena_ =
+      new FrameArena(max_pool_size_, page_size_, memory, numa_aware);
+  frames_ = frame_arena_->GetFrame(0);
+  pages_ = new Page[max_pool_size_];
+  page_table_ = new LockFreeHash<page_id_t, Page *>(
+      max_pool_size_, INVALID_PAGE_ID, INVALID_PAGE_ID - 1);
+  // LRU over the frames needs no allocation per unpin
+  Replacer<Page *> *replacer;
+  if (policy == ReplacerPolicy::LRU) {
+    replacer = new ArrayLRUReplacer<Page *>(max_pool_size_, pages_);
+  } else {
+    replacer = CreateReplacer<Page *>(policy, pool_size_);
+  }
+  // unpins reach the policy in batches, by which time a frame may be pinned
+  // or reused again
+  replacer_ = new BufferedReplacer<Page *>(replacer, IsReplaceable);
+  free_lists_.resize(frame_arena_->GetNumNodes());
 
-  // put all the pages into free list
-  for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_->push_back(&pages_[i]);
+  // put all the pages into free list; the frames past the pool stay claimed
+  // and untouched until it grows
+  for (size_t i = 0; i < max_pool_size_; ++i) {
+    pages_[i].data_ = frame_arena_->GetFrame(i);
+    if (i < pool_size_) {
+      pages_[i].ResetMemory(page_size_);
+      free_lists_[frame_arena_->GetNode(i)].push_back(&pages_[i]);
+    } else {
+      pages_[i].pin_count_ = Page::FRAME_CLAIMED;
+    }
   }
 }
 
+/*
+ * Constructor for subclasses that manage frames themselves, this instance
+ * owns no frames
+ */
+BufferPoolManager::BufferPoolManager(DiskManager *disk_manager,
+                                     LogManager *log_manager)
+    : pool_size_(0), max_pool_size_(0), page_size_(disk_manager->GetPageSize()),
+      pages_(nullptr), frames_(nullptr), frame_arena_(nullptr),
+      disk_manager_(disk_manager), log_manager_(log_manager),
+      page_table_(nullptr), replacer_(nullptr) {}
+
 /*
  * BufferPoolManager Deconstructor
- * WARNING: Do Not Edit This Function
+ * Background workers stop before the frames they use are released
  */
 BufferPoolManager::~BufferPoolManager() {
+  StopPrefetchWorker();
+  StopCleaner();
+  free(cleaner_buffer_);
   delete[] pages_;
+  delete frame_arena_;
   delete page_table_;
   delete replacer_;
-  delete free_list_;
+  delete compressed_cache_.load();
 }
 
 /**
@@ -47,32 +91,213 @@ BufferPoolManager::~BufferPoolManager() {
  * pointer
  *
  * This function must mark the Page as pinned and remove its entry from LRUReplacer before it is returned to the caller.
+ *
+ * The latch is only held while metadata changes: the frame is claimed for
+ * the new page and marked as in I/O, the write-back and the read happen
+ * without the latch. Threads fetching the same page meanwhile pin the frame
+ * and wait for that frame alone; a page still being written back is waited
+ * for before it is read again.
+ *
+ * Resident pages are first tried without the latch, see TryPinResident.
+ * With a strategy, a missing page is loaded into a frame of its ring. A page
+ * that fails its checksum or does not decompress is not kept, nullptr is
+ * returned instead.
  */
-Page *BufferPoolManager::FetchPage(page_id_t page_id) {
-  lock_guard<mutex> lck(latch_);
-  Page *tar = nullptr;
-  if (page_table_->Find(page_id,tar)) { //1.1
+Page *BufferPoolManager::FetchPage(page_id_t page_id,
+                                   BufferAccessStrategy *strategy) {
+  Page *tar = TryPinResident(page_id, strategy);
+  if (tar != nullptr) {
+    return tar;
+  }
+  unique_lock<mutex> lck(latch_);
+  while (true) {
+    // a page left in a frame a shrink gives up moves to another frame when
+    // it is unpinned, so that hot pages do not hold the shrink up
+    while (WaitForEviction(page_id, lck) ||
+           (page_table_->Find(page_id, tar) && !InPool(tar) &&
+            RetireFrame(tar, lck))) {
+    }
+    if (!page_table_->Find(page_id,tar)) {
+      break;
+    }
+    //1.1
     tar->pin_count_++;
     replacer_->Erase(tar);
-    return tar;
+    if (tar->ring_owner_ != strategy) {
+      tar->ring_owner_ = nullptr;
+    }
+    WaitForIO(tar, lck);
+    if (tar->page_id_ == page_id) {
+      return tar;
+    }
+    // the read into the frame failed, try it once more ourselves
+    ReleasePin(tar);
   }
   //1.2
-  tar = GetVictimPage();
+  tar = GetVictimPage(strategy);
   if (tar == nullptr) return tar;
-  //2
-  if (tar->is_dirty_) {
-    disk_manager_->WritePage(tar->GetPageId(),tar->data_);
-  }
   //3
-  page_table_->Remove(tar->GetPageId());
+  page_id_t old_page_id = tar->GetPageId();
+  bool write_back = tar->is_dirty_;
+  bool stash = IsStashed(old_page_id);
+  page_table_->Remove(old_page_id);
+  Unswizzle(tar);
+  tar->page_id_= page_id;
+  tar->is_dirty_ = false;
+  tar->io_in_progress_ = true;
+  tar->pin_count_ = 1;
   page_table_->Insert(page_id,tar);
+  if (write_back || stash) {
+    evicting_[old_page_id] = tar;
+  }
+  if (write_back) {
+    ++num_dirty_evictions_;
+    cleaner_cv_.notify_one();
+    WaitForCleaning(old_page_id, lck);
+  }
+  lck.unlock();
+  //2
+  if (write_back) {
+    disk_manager_->WritePage(old_page_id,tar->data_);
+  }
+  StashPage(old_page_id, tar->data_);
   //4
-  disk_manager_->ReadPage(page_id,tar->data_);
-  tar->pin_count_ = 1;
+  bool intact = ReadPageData(page_id, tar->data_);
+  lck.lock();
+  if (write_back || stash) {
+    evicting_.erase(old_page_id);
+  }
+  if (!intact) {
+    DropFailedFrame(tar);
+    return nullptr;
+  }
+  tar->io_in_progress_ = false;
+  tar->io_cv_.notify_all();
+  return tar;
+}
+
+/*
+ * If the cleaner is writing page_id, wait until the write is done and return
+ * true. Keeps reads and newer write-backs from overtaking the cleaner
+ */
+bool BufferPoolManager::WaitForCleaning(page_id_t page_id,
+                                        unique_lock<mutex> &lck) {
+  if (cleaning_.count(page_id) == 0) {
+    return false;
+  }
+  clean_cv_.wait(lck, [&] { return cleaning_.count(page_id) == 0; });
+  return true;
+}
+
+/*
+ * Fast path of FetchPage: pin a resident page with atomic operations only.
+ * The pin count is raised unless the frame is claimed for reassignment, then
+ * the frame is checked to still hold the page and not be loading. Returns
+ * nullptr if that fails or the page is not resident; the caller then takes
+ * the latch. The page stays in the replacer, which skips pinned frames. A
+ * page in the ring of another scan becomes an ordinary page
+ */
+Page *BufferPoolManager::TryPinResident(page_id_t page_id,
+                                        BufferAccessStrategy *strategy) {
+  Page *tar = nullptr;
+  if (!page_table_->Find(page_id, tar)) {
+    return nullptr;
+  }
+  return TryPinFrame(tar, page_id, strategy);
+}
+
+/*
+ * Pin tar if it holds page_id, with atomic operations only. tar is a frame
+ * of this instance that may meanwhile have been given to another page.
+ * Frames a shrink gives up are left to the latched path, which moves their
+ * pages out
+ */
+Page *BufferPoolManager::TryPinFrame(Page *tar, page_id_t page_id,
+                                     BufferAccessStrategy *strategy) {
+  if (!InPool(tar)) {
+    return nullptr;
+  }
+  int pins = tar->pin_count_.load();
+  do {
+    if (pins == Page::FRAME_CLAIMED) {
+      return nullptr;
+    }
+  } while (!tar->pin_count_.compare_exchange_weak(pins, pins + 1));
+  if (tar->page_id_ == page_id && !tar->io_in_progress_) {
+    if (tar->ring_owner_ != nullptr && tar->ring_owner_ != strategy) {
+      tar->ring_owner_ = nullptr;
+    }
+    return tar;
+  }
+  // the frame was given to another page before it was pinned
+  lock_guard<mutex> lck(latch_);
+  ReleasePin(tar);
+  return nullptr;
+}
+
+/*
+ * Drop one pin of tar, a resident page whose last pin goes is handed back to
+ * the replacer unless a scan's ring holds it. Caller holds latch_
+ */
+void BufferPoolManager::ReleasePin(Page *tar) {
+  if (--tar->pin_count_ == 0 && IsReplaceable(tar)) {
+    replacer_->Insert(tar);
+  }
+}
+
+/*
+ * Give up frame tar, whose page could not be read intact: the page leaves the
+ * page table, so a later fetch reads it again, and the frame goes back to the
+ * free list with the caller's pin dropped. Threads waiting for the read see
+ * the frame hold another page and retry; the free list skips the frame while
+ * they still pin it. Caller holds latch_
+ */
+void BufferPoolManager::DropFailedFrame(Page *tar) {
+  page_table_->Remove(tar->GetPageId());
+  Unswizzle(tar);
+  tar->ResetMemory(page_size_);
+  tar->ring_owner_ = nullptr;
   tar->is_dirty_ = false;
-  tar->page_id_= page_id;
+  tar->page_id_ = INVALID_PAGE_ID;
+  tar->io_in_progress_ = false;
+  tar->io_cv_.notify_all();
+  --tar->pin_count_;
+  free_lists_[GetFrameNode(tar)].push_back(tar);
+}
 
-  return tar;
+/*
+ * Whether the frame belongs in the replacer: unpinned, holding a page that
+ * is not being read, and not kept in a strategy's ring
+ */
+bool BufferPoolManager::IsReplaceable(Page *tar) {
+  return tar->pin_count_ == 0 && tar->page_id_ != INVALID_PAGE_ID &&
+         !tar->io_in_progress_ && tar->ring_owner_ == nullptr;
+}
+
+/*
+ * Block until the frame's pending I/O is done. Caller holds latch_ through
+ * lck and keeps the frame pinned or otherwise out of the replacer
+ */
+void BufferPoolManager::WaitForIO(Page *tar, unique_lock<mutex> &lck) {
+  tar->io_cv_.wait(lck, [tar] { return !tar->io_in_progress_; });
+}
+
+/*
+ * If page_id is still being written back from a frame that was taken for
+ * another page, wait for that frame and return true; the caller must look
+ * the page up again
+ */
+bool BufferPoolManager::WaitForEviction(page_id_t page_id,
+                                        unique_lock<mutex> &lck) {
+  if (WaitForCleaning(page_id, lck)) {
+    return true;
+  }
+  auto it = evicting_.find(page_id);
+  if (it == evicting_.end()) {
+    return false;
+  }
+  WaitForIO(it->second, lck);
+  return true;
 }
 //Page *BufferPoolManager::find
 
@@ -83,13 +308,20 @@ Page *BufferPoolManager::FetchPage(page_id_t page_id) {
  * dirty flag of this page
  */
 bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-  lock_guard<mutex> lck(latch_);
   Page *tar = nullptr;
+  if (page_table_->Find(page_id, tar) && tar->page_id_ == page_id &&
+      UnpinFrame(tar, is_dirty)) {
+    return true;
+  }
+  lock_guard<mutex> lck(latch_);
+  tar = nullptr;
   page_table_->Find(page_id,tar);
   if (tar == nullptr) {
     return false;
   }
-  tar->is_dirty_ |= is_dirty;
+  if (is_dirty) {
+    tar->is_dirty_ = true;
+  }
 
   if (tar->GetPinCount() <= 0) {
 //    cout<<"error "<<tar->GetPageId()<<endl;
@@ -98,12 +330,36 @@ bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
   }
   ;
   //std::cout<<"page id :"<<page_id<<"pin count"<<tar->pin_count_<<endl;
-  if (--tar->pin_count_ == 0) {
-    replacer_->Insert(tar);
-  }
+  ReleasePin(tar);
   return true;
 }
 
+bool BufferPoolManager::UnpinPage(Page *page, bool is_dirty) {
+  return page != nullptr && UnpinFrame(page, is_dirty);
+}
+
+/*
+ * Drop one pin of the frame tar. The frame stays put while pinned, so no
+ * latch is needed; the last unpin only queues the frame for the replacer,
+ * unless its buffer is full. Returns false if tar was not pinned
+ */
+bool BufferPoolManager::UnpinFrame(Page *tar, bool is_dirty) {
+  if (is_dirty) {
+    tar->is_dirty_ = true;
+  }
+  int pins = tar->pin_count_.load();
+  while (pins > 0) {
+    if (tar->pin_count_.compare_exchange_weak(pins, pins - 1)) {
+      if (pins == 1 && IsReplaceable(tar) && !replacer_->TryInsert(tar)) {
+        lock_guard<mutex> lck(latch_);
+        replacer_->Insert(tar);
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
 /*
  * Used to flush a particular page of the buffer pool to disk. Should call the
  * write_page method of the disk manager
@@ -111,18 +367,293 @@ bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
  * NOTE: make sure page_id != INVALID_PAGE_ID
  */
 bool BufferPoolManager::FlushPage(page_id_t page_id) {
-  lock_guard<mutex> lck(latch_);
+  unique_lock<mutex> lck(latch_);
   Page *tar = nullptr;
   page_table_->Find(page_id,tar);
   if (tar == nullptr || tar->page_id_ == INVALID_PAGE_ID) {
     return false;
   }
+  // pinned for the write so the frame cannot be reused meanwhile
+  tar->pin_count_++;
+  replacer_->Erase(tar);
+  WaitForIO(tar, lck);
+  WaitForCleaning(page_id, lck);
   if (tar->is_dirty_) {
+    tar->is_dirty_ = false;
+    lck.unlock();
     disk_manager_->WritePage(page_id,tar->GetData());
+    lck.lock();
+  }
+  ReleasePin(tar);
+  return true;
+}
+
+/*
+ * Flush every dirty page of the buffer pool and sync the db file, e.g. for a
+ * checkpoint, see FlushInstances
+ */
+FlushStats BufferPoolManager::FlushAllPages() {
+  return FlushInstances({this});
+}
+
+/*
+ * Checkpoint writer over instances, which hold the pages whose id modulo
+ * their number is their index. The ids of the dirty pages are snapshot and
+ * sorted, then written in batches of CHECKPOINT_BATCH_SIZE: each page still
+ * dirty is pinned, copied under its read latch and unpinned, and the copies
+ * go to the disk manager in one call, which merges adjacent pages into one
+ * write. The pool latch is only taken to pin a page, so fetches and
+ * evictions go on; a page is kept in cleaning_ from its pin until its copy
+ * is written, so that no other write-back of it overtakes the copy. Pages
+ * dirtied again during the flush stay dirty
+ */
+FlushStats BufferPoolManager::FlushInstances(
+    const std::vector<BufferPoolManager *> &instances) {
+  auto start = std::chrono::steady_clock::now();
+  FlushStats stats;
+  std::vector<page_id_t> page_ids;
+  for (auto instance : instances) {
+    instance->CollectDirtyPages(page_ids);
+  }
+  std::sort(page_ids.begin(), page_ids.end());
+
+  void *buffer = nullptr;
+  if (posix_memalign(&buffer, DIRECT_IO_ALIGNMENT,
+                     CHECKPOINT_BATCH_SIZE * page_size_) != 0) {
+    throw std::bad_alloc();
+  }
+  std::vector<std::pair<page_id_t, char *>> writes;
+  for (size_t begin = 0; begin < page_ids.size();
+       begin += CHECKPOINT_BATCH_SIZE) {
+    size_t end = std::min(page_ids.size(), begin + CHECKPOINT_BATCH_SIZE);
+    writes.clear();
+    for (size_t i = begin; i < end; ++i) {
+      auto instance =
+          instances[static_cast<uint32_t>(page_ids[i]) % instances.size()];
+      Page *tar = instance->PinForFlush(page_ids[i]);
+      if (tar == nullptr) {
+        continue;
+      }
+      char *copy = static_cast<char *>(buffer) + writes.size() * page_size_;
+      tar->RLatch();
+      tar->is_dirty_ = false;
+      memcpy(copy, tar->data_, page_size_);
+      tar->RUnlatch();
+      instance->UnpinPage(tar, false);
+      writes.emplace_back(page_ids[i], copy);
+    }
+    disk_manager_->WritePages(writes);
+    for (size_t i = 0; i < writes.size(); ++i) {
+      if (i == 0 || writes[i].first != writes[i - 1].first + 1) {
+        ++stats.num_runs_;
+      }
+      instances[static_cast<uint32_t>(writes[i].first) % instances.size()]
+          ->EndFlush(writes[i].first);
+    }
+    stats.num_pages_ += writes.size();
+  }
+  free(buffer);
+  for (auto instance : instances) {
+    instance->WaitForWrites();
+  }
+  disk_manager_->Sync();
+  stats.num_bytes_ = stats.num_pages_ * page_size_;
+  stats.elapsed_ms_ = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+  return stats;
+}
+
+/*
+ * Add the ids of the resident dirty pages to page_ids
+ */
+void BufferPoolManager::CollectDirtyPages(std::vector<page_id_t> &page_ids) {
+  lock_guard<mutex> lck(latch_);
+  for (size_t i = 0; i < max_pool_size_; ++i) {
+    if (pages_[i].page_id_ != INVALID_PAGE_ID && pages_[i].is_dirty_) {
+      page_ids.push_back(pages_[i].page_id_);
+    }
+  }
+}
+
+/*
+ * Pin page_id for a flush if it is resident and dirty, and enter it into
+ * cleaning_. A write-back of the page under way is waited for first: the
+ * page may have been dirtied again after its copy was taken. Pages being
+ * loaded are clean and skipped
+ */
+Page *BufferPoolManager::PinForFlush(page_id_t page_id) {
+  unique_lock<mutex> lck(latch_);
+  while (WaitForEviction(page_id, lck)) {
+  }
+  Page *tar = nullptr;
+  if (!page_table_->Find(page_id, tar) || tar->page_id_ != page_id ||
+      !tar->is_dirty_ || tar->io_in_progress_) {
+    return nullptr;
+  }
+  int pins = tar->pin_count_.load();
+  do {
+    if (pins == Page::FRAME_CLAIMED) {
+      return nullptr;
+    }
+  } while (!tar->pin_count_.compare_exchange_weak(pins, pins + 1));
+  cleaning_.insert(page_id);
+  return tar;
+}
+
+// the copy of page_id is written, other write-backs may go ahead
+void BufferPoolManager::EndFlush(page_id_t page_id) {
+  lock_guard<mutex> lck(latch_);
+  cleaning_.erase(page_id);
+  clean_cv_.notify_all();
+}
+
+/*
+ * Wait for the write-backs under way at the call, so that a following sync
+ * covers them. Write-backs started meanwhile are not waited for, so steady
+ * eviction traffic cannot hold the caller up. An eviction ends with the I/O
+ * of its frame
+ */
+void BufferPoolManager::WaitForWrites() {
+  unique_lock<mutex> lck(latch_);
+  std::vector<std::pair<page_id_t, Page *>> evictions(evicting_.begin(),
+                                                      evicting_.end());
+  std::vector<page_id_t> cleanings(cleaning_.begin(), cleaning_.end());
+  for (auto &eviction : evictions) {
+    auto it = evicting_.find(eviction.first);
+    if (it != evicting_.end() && it->second == eviction.second) {
+      WaitForIO(eviction.second, lck);
+    }
+  }
+  for (page_id_t page_id : cleanings) {
+    WaitForCleaning(page_id, lck);
+  }
+}
+
+/*
+ * Bring the given pages into the buffer pool ahead of use. Resident pages and
+ * pages not allocated on disk are skipped, the others take free or victim
+ * frames and are read with one batch request; they stay unpinned in the
+ * replacer, or in the ring of the strategy if one is given. Stops early when
+ * every frame is pinned
+ */
+void BufferPoolManager::Prefetch(const std::vector<page_id_t> &page_ids,
+                                 BufferAccessStrategy *strategy) {
+  unique_lock<mutex> lck(latch_);
+  std::vector<std::pair<page_id_t, char *>> writes, reads, evicted;
+  std::vector<Page *> loaded;
+  for (page_id_t page_id : page_ids) {
+    Page *tar = nullptr;
+    // a page still being written back would be read in its old version
+    if (page_id == INVALID_PAGE_ID || evicting_.count(page_id) != 0 ||
+        cleaning_.count(page_id) != 0 || page_table_->Find(page_id, tar) ||
+        !disk_manager_->IsAllocated(page_id)) {
+      continue;
+    }
+    tar = GetVictimPage(strategy);
+    if (tar == nullptr) {
+      break;
+    }
+    if (tar->is_dirty_) {
+      writes.emplace_back(tar->GetPageId(), tar->data_);
+      evicting_[tar->GetPageId()] = tar;
+      ++num_dirty_evictions_;
+    }
+    if (IsStashed(tar->GetPageId())) {
+      evicted.emplace_back(tar->GetPageId(), tar->data_);
+      evicting_[tar->GetPageId()] = tar;
+    }
+    page_table_->Remove(tar->GetPageId());
+    Unswizzle(tar);
+    tar->page_id_ = page_id;
     tar->is_dirty_ = false;
+    tar->io_in_progress_ = true;
+    tar->pin_count_ = 0;
+    page_table_->Insert(page_id, tar);
+    reads.emplace_back(page_id, tar->data_);
+    loaded.push_back(tar);
+  }
+  for (auto &write : writes) {
+    WaitForCleaning(write.first, lck);
+  }
+  lck.unlock();
+  // victims go out before their frames are overwritten
+  disk_manager_->WritePages(writes);
+  for (auto &page : evicted) {
+    StashPage(page.first, page.second);
   }
+  bool intact = ReadPagesData(reads);
+  lck.lock();
+  for (auto &write : writes) {
+    evicting_.erase(write.first);
+  }
+  for (auto &page : evicted) {
+    evicting_.erase(page.first);
+  }
+  // pages fetched during the read are pinned and stay out of the replacer.
+  // If any page of the batch failed, none is kept: the fetches waiting for
+  // them read each page again by itself
+  for (Page *tar : loaded) {
+    if (!intact) {
+      ++tar->pin_count_;
+      DropFailedFrame(tar);
+      continue;
+    }
+    tar->io_in_progress_ = false;
+    tar->io_cv_.notify_all();
+    if (tar->pin_count_ == 0 && tar->ring_owner_ == nullptr) {
+      replacer_->Insert(tar);
+    }
+  }
+}
 
-  return true;
+/*
+ * Queue a Prefetch for the background worker, which is started on first use
+ */
+std::future<void> BufferPoolManager::PrefetchAsync(
+    std::vector<page_id_t> page_ids, BufferAccessStrategy *strategy) {
+  std::lock_guard<std::mutex> lck(prefetch_latch_);
+  if (!prefetch_worker_.joinable()) {
+    prefetch_shutdown_ = false;
+    prefetch_worker_ = std::thread(&BufferPoolManager::PrefetchLoop, this);
+  }
+  prefetch_queue_.push_back(
+      PrefetchRequest{std::move(page_ids), strategy, std::promise<void>()});
+  auto future = prefetch_queue_.back().done_.get_future();
+  prefetch_cv_.notify_one();
+  return future;
+}
+
+void BufferPoolManager::PrefetchLoop() {
+  std::unique_lock<std::mutex> lck(prefetch_latch_);
+  while (true) {
+    prefetch_cv_.wait(
+        lck, [this] { return prefetch_shutdown_ || !prefetch_queue_.empty(); });
+    if (prefetch_queue_.empty()) {
+      return;
+    }
+    auto request = std::move(prefetch_queue_.front());
+    prefetch_queue_.pop_front();
+    lck.unlock();
+    Prefetch(request.page_ids_, request.strategy_);
+    request.done_.set_value();
+    lck.lock();
+  }
+}
+
+/*
+ * Finish the queued requests and stop the worker
+ */
+void BufferPoolManager::StopPrefetchWorker() {
+  {
+    std::lock_guard<std::mutex> lck(prefetch_latch_);
+    if (!prefetch_worker_.joinable()) {
+      return;
+    }
+    prefetch_shutdown_ = true;
+    prefetch_cv_.notify_all();
+  }
+  prefetch_worker_.join();
 }
 
 /**
@@ -134,26 +665,180 @@ bool BufferPoolManager::FlushPage(page_id_t page_id) {
  * the page is found within page table, but pin_count != 0, return false
  */
 bool BufferPoolManager::DeletePage(page_id_t page_id) {
-  lock_guard<mutex> lck(latch_);
+  unique_lock<mutex> lck(latch_);
   Page *tar = nullptr;
+  while (WaitForEviction(page_id, lck)) {
+  }
   page_table_->Find(page_id,tar);
   if (tar != nullptr) {
-    if (tar->GetPinCount() > 0) {
+    WaitForIO(tar, lck);
+  }
+  // a failed read may have given the frame up meanwhile
+  if (tar != nullptr && tar->page_id_ == page_id) {
+    int pins = 0;
+    if (!tar->pin_count_.compare_exchange_strong(pins, Page::FRAME_CLAIMED)) {
  //     cout<<"DeletePage error"<<tar->page_id_<<endl;
 //      assert(false);
       return false;
     }
     replacer_->Erase(tar);
     page_table_->Remove(page_id);
+    tar->ring_owner_ = nullptr;
     tar->is_dirty_= false;
-    tar->ResetMemory();
+    tar->ResetMemory(page_size_);
+    Unswizzle(tar);
     tar->page_id_ = INVALID_PAGE_ID;
-    free_list_->push_back(tar);
+    tar->pin_count_ = 0;
+    free_lists_[GetFrameNode(tar)].push_back(tar);
+  }
+  if (compressed_cache_ != nullptr) {
+    compressed_cache_.load()->Erase(page_id);
   }
   disk_manager_->DeallocatePage(page_id);
   return true;
 }
 
+/*
+ * Guarded variants of FetchPage and NewPage. They go through the virtual
+ * methods, so a ParallelBufferPoolManager hands out guards as well
+ */
+BasicPageGuard BufferPoolManager::FetchPageBasic(page_id_t page_id) {
+  return BasicPageGuard(this, FetchPage(page_id));
+}
+
+ReadPageGuard BufferPoolManager::FetchPageRead(page_id_t page_id,
+                                               BufferAccessStrategy *strategy) {
+  return ReadPageGuard(this, FetchPage(page_id, strategy));
+}
+
+WritePageGuard BufferPoolManager::FetchPageWrite(page_id_t page_id) {
+  return WritePageGuard(this, FetchPage(page_id));
+}
+
+/*
+ * The cache is created on the first non-zero budget and kept until the pool
+ * goes away, so that I/O paths can use it without the latch
+ */
+void BufferPoolManager::SetCompressedCacheBudget(size_t budget_bytes) {
+  lock_guard<mutex> lck(latch_);
+  if (compressed_cache_ != nullptr) {
+    compressed_cache_.load()->SetBudget(budget_bytes);
+  } else if (budget_bytes > 0) {
+    compressed_cache_ = new CompressedPageCache(budget_bytes, page_size_);
+  }
+}
+
+CompressedCacheStats BufferPoolManager::GetCompressedCacheStats() {
+  CompressedPageCache *cache = compressed_cache_;
+  return cache == nullptr ? CompressedCacheStats() : cache->GetStats();
+}
+
+/*
+ * Whether a victim holding page_id goes to the compressed cache. Such a
+ * victim is entered in evicting_ like a dirty one, so a fetch of the page
+ * waits for it to be stored instead of finding it neither here nor there
+ */
+bool BufferPoolManager::IsStashed(page_id_t page_id) const {
+  return compressed_cache_ != nullptr && page_id != INVALID_PAGE_ID;
+}
+
+/*
+ * Keep the contents of page_id, which leaves its frame and equals its copy
+ * on disk, in the compressed cache if there is one
+ */
+void BufferPoolManager::StashPage(page_id_t page_id, const char *data) {
+  CompressedPageCache *cache = compressed_cache_;
+  if (cache != nullptr && page_id != INVALID_PAGE_ID) {
+    cache->Put(page_id, data);
+  }
+}
+
+// read page_id into data from the compressed cache, else from disk; false
+// if the disk copy failed its checksum or did not decompress
+bool BufferPoolManager::ReadPageData(page_id_t page_id, char *data) {
+  CompressedPageCache *cache = compressed_cache_;
+  if (cache != nullptr && cache->Take(page_id, data)) {
+    return true;
+  }
+  return disk_manager_->ReadPage(page_id, data);
+}
+
+// the same for a batch, the pages not in the cache are read together
+bool BufferPoolManager::ReadPagesData(
+    const std::vector<std::pair<page_id_t, char *>> &pages) {
+  CompressedPageCache *cache = compressed_cache_;
+  if (cache == nullptr) {
+    return disk_manager_->ReadPages(pages);
+  }
+  std::vector<std::pair<page_id_t, char *>> misses;
+  for (auto &page : pages) {
+    if (!cache->Take(page.first, page.second)) {
+      misses.push_back(page);
+    }
+  }
+  return disk_manager_->ReadPages(misses);
+}
+
+Page *BufferPoolManager::FetchSwizzled(page_id_t page_id,
+                                       std::atomic<Page *> *ref) {
+  if (ref == nullptr) {
+    return FetchPage(page_id);
+  }
+  Page *tar = ref->load();
+  // a ref may name a frame of another instance or a reused slot's child
+  if (tar != nullptr && OwnsFrame(tar) &&
+      (tar = TryPinFrame(tar, page_id, nullptr)) != nullptr) {
+    ++num_swizzled_hits_;
+    return tar;
+  }
+  tar = FetchPage(page_id);
+  if (tar != nullptr) {
+    ref->store(tar);
+  }
+  return tar;
+}
+
+ReadPageGuard BufferPoolManager::FetchSwizzledRead(page_id_t page_id,
+                                                   std::atomic<Page *> *ref) {
+  return ReadPageGuard(this, FetchSwizzled(page_id, ref));
+}
+
+/*
+ * The refs of a frame are allocated when it is first descended through.
+ * Slots move as the inner page changes; a ref left at a moved slot names the
+ * wrong child and fails the check in FetchSwizzled
+ */
+std::atomic<Page *> *BufferPoolManager::GetChildRef(Page *parent, int slot) {
+  size_t num_slots = page_size_ / sizeof(page_id_t);
+  if (parent == nullptr || slot < 0 ||
+      static_cast<size_t>(slot) >= num_slots) {
+    return nullptr;
+  }
+  std::atomic<Page *> *refs = parent->swizzled_.load();
+  if (refs == nullptr) {
+    auto fresh = new std::atomic<Page *>[num_slots]();
+    if (parent->swizzled_.compare_exchange_strong(refs, fresh)) {
+      refs = fresh;
+    } else {
+      delete[] fresh;
+    }
+  }
+  return &refs[slot];
+}
+
+/*
+ * Drop the child refs of a frame that is given to another page. The frame
+ * is claimed, so no thread descends through it
+ */
+void BufferPoolManager::Unswizzle(Page *tar) {
+  delete[] tar->swizzled_.exchange(nullptr);
+}
+
+BasicPageGuard BufferPoolManager::NewPageGuarded(page_id_t &page_id,
+                                                 page_id_t hint_page_id) {
+  return BasicPageGuard(this, NewPage(page_id, hint_page_id));
+}
+
 /**
  * User should call this method if needs to create a new page. This routine
  * will call disk manager to allocate a page.
@@ -161,51 +846,461 @@ bool BufferPoolManager::DeletePage(page_id_t page_id) {
  * from free list or lru replacer(NOTE: always choose from free list first),
  * update new page's metadata, zero out memory and add corresponding entry
  * into page table. return nullptr if all the pages in pool are pinned
+ * A valid hint_page_id asks for a page next to the hint's object on disk
  */
-Page *BufferPoolManager::NewPage(page_id_t &page_id) {
-  lock_guard<mutex> lck(latch_);
+Page *BufferPoolManager::NewPage(page_id_t &page_id, page_id_t hint_page_id) {
+  unique_lock<mutex> lck(latch_);
   Page *tar = nullptr;
   tar = GetVictimPage();
   if (tar == nullptr) {
     return tar;
   }
 
-  page_id = disk_manager_->AllocatePage();
-  //2
-  if (tar->is_dirty_) {
-    disk_manager_->WritePage(tar->GetPageId(),tar->data_);
+  page_id = disk_manager_->AllocatePage(hint_page_id);
+  InstallNewPage(tar, page_id, lck);
+  return tar;
+}
+
+/*
+ * Same as NewPage, but for a page id the caller already allocated from the
+ * disk manager. Used by the parallel buffer pool, which must know the id to
+ * pick the instance. return nullptr if all the pages in pool are pinned
+ */
+Page *BufferPoolManager::NewPageWithId(page_id_t page_id) {
+  unique_lock<mutex> lck(latch_);
+  Page *tar = GetVictimPage();
+  if (tar == nullptr) {
+    return tar;
   }
-  //3
-  page_table_->Remove(tar->GetPageId());
-  page_table_->Insert(page_id,tar);
+  InstallNewPage(tar, page_id, lck);
+  return tar;
+}
 
-  //4
+/*
+ * Turn victim frame tar into a new, pinned and zeroed page. Caller holds
+ * latch_ through lck, it is released while a dirty victim is written back
+ */
+void BufferPoolManager::InstallNewPage(Page *tar, page_id_t page_id,
+                                       unique_lock<mutex> &lck) {
+  page_id_t old_page_id = tar->GetPageId();
+  bool write_back = tar->is_dirty_;
+  bool stash = IsStashed(old_page_id);
+  //3
+  page_table_->Remove(old_page_id);
+  Unswizzle(tar);
   tar->page_id_ = page_id;
-  tar->ResetMemory();
   tar->is_dirty_ = false;
+  tar->io_in_progress_ = true;
   tar->pin_count_ = 1;
+  page_table_->Insert(page_id,tar);
 
-  return tar;
+  //2
+  if (write_back || stash) {
+    evicting_[old_page_id] = tar;
+  }
+  if (write_back) {
+    ++num_dirty_evictions_;
+    cleaner_cv_.notify_one();
+    WaitForCleaning(old_page_id, lck);
+  }
+  if (write_back || stash) {
+    lck.unlock();
+    if (write_back) {
+      disk_manager_->WritePage(old_page_id,tar->data_);
+    }
+    StashPage(old_page_id, tar->data_);
+    lck.lock();
+    evicting_.erase(old_page_id);
+  }
+  //4
+  tar->ResetMemory(page_size_);
+  tar->io_in_progress_ = false;
+  tar->io_cv_.notify_all();
+}
+
+/*
+ * Growing zeroes the frames taken into use and puts them on the free lists.
+ * Shrinking gives up the frames past new_size: from then on they are not
+ * handed out or pinned without the latch, and each is retired as soon as it
+ * is unpinned, its page evicted and written back if dirty. Pages pinned
+ * there are waited for, with the latch released, so other threads keep
+ * working meanwhile, but no longer than RESIZE_TIMEOUT_MS: then the pool
+ * keeps the frames up to the last one still pinned and false is returned.
+ * The memory of the retired frames goes back to the operating system
+ */
+bool BufferPoolManager::Resize(size_t new_size) {
+  lock_guard<mutex> resize_lck(resize_latch_);
+  if (new_size == 0 || new_size > max_pool_size_) {
+    return false;
+  }
+  unique_lock<mutex> lck(latch_);
+  size_t old_size = pool_size_;
+  if (new_size >= old_size) {
+    for (size_t i = old_size; i < new_size; ++i) {
+      Page *tar = &pages_[i];
+      tar->ResetMemory(page_size_);
+      tar->pin_count_ = 0;
+      free_lists_[GetFrameNode(tar)].push_back(tar);
+    }
+    pool_size_ = new_size;
+    return true;
+  }
+  pool_size_ = new_size;
+  std::vector<Page *> retiring;
+  for (size_t i = new_size; i < old_size; ++i) {
+    retiring.push_back(&pages_[i]);
+  }
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(RESIZE_TIMEOUT_MS);
+  while (!retiring.empty()) {
+    for (auto it = retiring.begin(); it != retiring.end();) {
+      it = RetireFrame(*it, lck) ? retiring.erase(it) : it + 1;
+    }
+    if (retiring.empty() || std::chrono::steady_clock::now() >= deadline) {
+      break;
+    }
+    lck.unlock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    lck.lock();
+  }
+  size_t kept_size =
+      retiring.empty() ? new_size
+                       : static_cast<size_t>(retiring.back() - pages_) + 1;
+  for (size_t i = new_size; i < kept_size; ++i) {
+    Page *tar = &pages_[i];
+    if (std::find(retiring.begin(), retiring.end(), tar) != retiring.end()) {
+      // victim searches dropped it from the replacer while it was retiring
+      if (IsReplaceable(tar)) {
+        replacer_->Insert(tar);
+      }
+    } else {
+      tar->ResetMemory(page_size_);
+      tar->pin_count_ = 0;
+      free_lists_[GetFrameNode(tar)].push_back(tar);
+    }
+  }
+  pool_size_ = kept_size;
+  lck.unlock();
+  frame_arena_->Release(kept_size, old_size);
+  return retiring.empty();
+}
+
+/*
+ * Claim frame tar, which a shrink gives up, and evict its page; false if it
+ * is pinned or loading. The frame stays claimed, so neither lock-free pins
+ * nor victim searches take it again. Caller holds latch_ through lck, it is
+ * released while a dirty page is written back
+ */
+bool BufferPoolManager::RetireFrame(Page *tar, unique_lock<mutex> &lck) {
+  // a fetch of its page may have retired it already
+  if (tar->pin_count_ == Page::FRAME_CLAIMED &&
+      tar->page_id_ == INVALID_PAGE_ID && !tar->io_in_progress_) {
+    return true;
+  }
+  int pins = 0;
+  if (tar->io_in_progress_ ||
+      !tar->pin_count_.compare_exchange_strong(pins, Page::FRAME_CLAIMED)) {
+    return false;
+  }
+  page_id_t old_page_id = tar->GetPageId();
+  if (old_page_id == INVALID_PAGE_ID) {
+    free_lists_[GetFrameNode(tar)].remove(tar);
+    return true;
+  }
+  replacer_->Erase(tar);
+  tar->ring_owner_ = nullptr;
+  page_table_->Remove(old_page_id);
+  Unswizzle(tar);
+  tar->page_id_ = INVALID_PAGE_ID;
+  bool write_back = tar->is_dirty_;
+  if (write_back || IsStashed(old_page_id)) {
+    tar->is_dirty_ = false;
+    tar->io_in_progress_ = true;
+    evicting_[old_page_id] = tar;
+    if (write_back) {
+      ++num_dirty_evictions_;
+    }
+    WaitForCleaning(old_page_id, lck);
+    lck.unlock();
+    if (write_back) {
+      disk_manager_->WritePage(old_page_id, tar->data_);
+    }
+    StashPage(old_page_id, tar->data_);
+    lck.lock();
+    evicting_.erase(old_page_id);
+    tar->io_in_progress_ = false;
+    tar->io_cv_.notify_all();
+  }
+  return true;
 }
 
-Page *BufferPoolManager::GetVictimPage() {
+/*
+ * Claim a frame for reassignment, from the free list first. The frame's pin
+ * count is set to FRAME_CLAIMED so lock-free pins keep off it; the caller
+ * stores the new pin count once the frame holds its new page. Frames pinned
+ * without the latch are skipped, pages among them leave the replacer and
+ * return to it when unpinned. With a strategy the oldest frame of its ring
+ * is reused if possible, else the frame found joins the ring. Caller holds
+ * latch_
+ */
+Page *BufferPoolManager::GetVictimPage(BufferAccessStrategy *strategy) {
   Page *tar = nullptr;
-  if (free_list_->empty()) {
-    if (replacer_->Size() == 0) {
-      return nullptr;
+  if (strategy != nullptr) {
+    tar = GetRingVictim(strategy, false);
+    if (tar == nullptr) {
+      tar = GetVictimPage();
+      if (tar != nullptr) {
+        AddToRing(strategy, tar);
+      } else {
+        tar = GetRingVictim(strategy, true);
+      }
     }
-    replacer_->Victim(tar);
-  } else {
-    tar = free_list_->front();
-    free_list_->pop_front();
-    assert(tar->GetPageId() == INVALID_PAGE_ID);
+    if (tar != nullptr) {
+      tar->ring_owner_ = strategy;
+    }
+    return tar;
   }
-  if (tar != nullptr) {
-    assert(tar->GetPinCount() == 0);
+  // free frames of the caller's node first, then those of the others
+  int node = free_lists_.size() > 1 ? GetCurrentNumaNode() : 0;
+  for (size_t i = 0; i < free_lists_.size(); ++i) {
+    auto &free_list = free_lists_[(node + i) % free_lists_.size()];
+    for (auto it = free_list.begin(); it != free_list.end(); ++it) {
+      int pins = 0;
+      if (InPool(*it) &&
+          (*it)->pin_count_.compare_exchange_strong(pins,
+                                                    Page::FRAME_CLAIMED)) {
+        tar = *it;
+        free_list.erase(it);
+        assert(tar->GetPageId() == INVALID_PAGE_ID);
+        return tar;
+      }
+    }
+  }
+  if (free_lists_.size() > 1 && (tar = GetLocalVictim(node)) != nullptr) {
+    return tar;
   }
+  while (replacer_->Victim(tar)) {
+    int pins = 0;
+    if (InPool(tar) &&
+        tar->pin_count_.compare_exchange_strong(pins, Page::FRAME_CLAIMED)) {
+      tar->ring_owner_ = nullptr;
+      return tar;
+    }
+  }
+  return nullptr;
+}
+
+/*
+ * Memory node the frame tar lives on
+ */
+int BufferPoolManager::GetFrameNode(Page *tar) const {
+  return frame_arena_->GetNode(tar - pages_);
+}
+
+/*
+ * Claim the coldest of the NUMA_VICTIM_LOOKAHEAD coldest pages that lives on
+ * node, if any; remote memory is only used when the local one is all hot.
+ * Caller holds latch_
+ */
+Page *BufferPoolManager::GetLocalVictim(int node) {
+  std::vector<Page *> candidates;
+  replacer_->PeekVictims(candidates, NUMA_VICTIM_LOOKAHEAD);
+  for (Page *tar : candidates) {
+    int pins = 0;
+    if (GetFrameNode(tar) == node && InPool(tar) &&
+        tar->pin_count_.compare_exchange_strong(pins, Page::FRAME_CLAIMED)) {
+      replacer_->Erase(tar);
+      tar->ring_owner_ = nullptr;
+      return tar;
+    }
+  }
+  return nullptr;
+}
+
+/*
+ * Number of frames the strategy may hold in this pool: its ring size, but
+ * never more than an eighth of the frames
+ */
+size_t BufferPoolManager::GetRingCapacity(BufferAccessStrategy *strategy) {
+  return std::max<size_t>(1,
+                          std::min(strategy->ring_size_, pool_size_ / 8));
+}
+
+/*
+ * Claim the oldest frame of the strategy's ring, if that frame is still the
+ * strategy's and unpinned. Unless the pool has no other victim, the ring must
+ * be full first. Caller holds latch_
+ */
+Page *BufferPoolManager::GetRingVictim(BufferAccessStrategy *strategy,
+                                       bool pool_exhausted) {
+  lock_guard<mutex> ring_lck(strategy->latch_);
+  auto &ring = strategy->rings_[this];
+  if (ring.frames_.empty() ||
+      (!pool_exhausted && ring.frames_.size() < GetRingCapacity(strategy))) {
+    return nullptr;
+  }
+  Page *tar = ring.frames_[ring.next_];
+  int pins = 0;
+  if (!InPool(tar) || tar->ring_owner_ != strategy || tar->io_in_progress_ ||
+      !tar->pin_count_.compare_exchange_strong(pins, Page::FRAME_CLAIMED)) {
+    return nullptr;
+  }
+  ring.next_ = (ring.next_ + 1) % ring.frames_.size();
+  ++strategy->num_reused_;
   return tar;
 }
 
+/*
+ * Put a newly claimed frame into the strategy's ring, in place of the oldest
+ * frame once the ring is full. Caller holds latch_
+ */
+void BufferPoolManager::AddToRing(BufferAccessStrategy *strategy, Page *tar) {
+  lock_guard<mutex> ring_lck(strategy->latch_);
+  auto &ring = strategy->rings_[this];
+  if (ring.frames_.size() < GetRingCapacity(strategy)) {
+    ring.frames_.push_back(tar);
+    return;
+  }
+  ReleaseRingFrame(strategy, ring.frames_[ring.next_]);
+  ring.frames_[ring.next_] = tar;
+  ring.next_ = (ring.next_ + 1) % ring.frames_.size();
+}
+
+/*
+ * A frame leaves the strategy's ring: if it is unpinned, its page goes to
+ * the replacer like any other. Caller holds latch_
+ */
+void BufferPoolManager::ReleaseRingFrame(BufferAccessStrategy *strategy,
+                                         Page *tar) {
+  if (tar->ring_owner_ != strategy) {
+    return;
+  }
+  tar->ring_owner_ = nullptr;
+  if (tar->pin_count_ == 0 && tar->page_id_ != INVALID_PAGE_ID &&
+      !tar->io_in_progress_) {
+    replacer_->Insert(tar);
+  }
+}
+
+/*
+ * Called when the strategy goes away
+ */
+void BufferPoolManager::ReleaseRing(BufferAccessStrategy *strategy,
+                                    const std::vector<Page *> &frames) {
+  lock_guard<mutex> lck(latch_);
+  for (Page *tar : frames) {
+    ReleaseRingFrame(strategy, tar);
+  }
+}
+
+/*
+ * Start the background cleaner, see CleanRound. Does nothing if it runs
+ */
+void BufferPoolManager::StartCleaner(double low_ratio, double high_ratio) {
+  lock_guard<mutex> lck(latch_);
+  if (cleaner_.joinable()) {
+    return;
+  }
+  if (cleaner_buffer_ == nullptr) {
+    void *buffer = nullptr;
+    if (posix_memalign(&buffer, DIRECT_IO_ALIGNMENT,
+                       CLEANER_BATCH_SIZE * page_size_) != 0) {
+      throw std::bad_alloc();
+    }
+    cleaner_buffer_ = static_cast<char *>(buffer);
+  }
+  cleaner_low_ratio_ = low_ratio;
+  cleaner_high_ratio_ = high_ratio;
+  cleaner_shutdown_ = false;
+  cleaner_ = std::thread(&BufferPoolManager::CleanerLoop, this);
+}
+
+void BufferPoolManager::StopCleaner() {
+  {
+    lock_guard<mutex> lck(latch_);
+    if (!cleaner_.joinable()) {
+      return;
+    }
+    cleaner_shutdown_ = true;
+    cleaner_cv_.notify_all();
+  }
+  cleaner_.join();
+}
+
+/*
+ * Cleaner thread: runs a round every CLEANER_INTERVAL_MS, or right away when
+ * a victim had to be written back or the last round wrote a full batch
+ */
+void BufferPoolManager::CleanerLoop() {
+  unique_lock<mutex> lck(latch_);
+  while (!cleaner_shutdown_) {
+    if (CleanRound(lck) < CLEANER_BATCH_SIZE) {
+      cleaner_cv_.wait_for(lck, std::chrono::milliseconds(CLEANER_INTERVAL_MS));
+    }
+  }
+}
+
+/*
+ * One cleaner pass: the dirty, unpinned pages among the CLEANER_LOOKAHEAD
+ * coldest ones of the replacer are copied and marked clean, and further
+ * pages down the replacer as well while more than the high ratio of frames
+ * are dirty, until the low ratio is reached. The copies are written in one
+ * batch without the latch; until then their ids are kept in cleaning_ so
+ * that the page is neither read back nor written again ahead of the copy.
+ * Returns the number of pages written. Caller holds latch_ through lck
+ */
+size_t BufferPoolManager::CleanRound(unique_lock<mutex> &lck) {
+  size_t num_dirty = 0;
+  for (size_t i = 0; i < pool_size_; ++i) {
+    if (pages_[i].page_id_ != INVALID_PAGE_ID && pages_[i].is_dirty_) {
+      ++num_dirty;
+    }
+  }
+  size_t scan = CLEANER_LOOKAHEAD, excess = 0;
+  if (num_dirty > cleaner_high_ratio_ * pool_size_) {
+    scan = pool_size_;
+    excess = num_dirty - static_cast<size_t>(cleaner_low_ratio_ * pool_size_);
+  }
+  std::vector<Page *> candidates;
+  replacer_->PeekVictims(candidates, scan);
+  std::vector<std::pair<page_id_t, char *>> writes;
+  for (size_t i = 0;
+       i < candidates.size() && writes.size() < CLEANER_BATCH_SIZE; ++i) {
+    if (i >= CLEANER_LOOKAHEAD && writes.size() >= excess) {
+      break;
+    }
+    Page *tar = candidates[i];
+    // a page in cleaning_ has an older copy still to be written
+    if (!tar->is_dirty_ || tar->io_in_progress_ ||
+        cleaning_.count(tar->GetPageId()) != 0) {
+      continue;
+    }
+    // claimed while copied, so that no lock-free pin changes it meanwhile
+    int pins = 0;
+    if (!tar->pin_count_.compare_exchange_strong(pins, Page::FRAME_CLAIMED)) {
+      continue;
+    }
+    char *copy = cleaner_buffer_ + writes.size() * page_size_;
+    memcpy(copy, tar->data_, page_size_);
+    tar->is_dirty_ = false;
+    tar->pin_count_ = 0;
+    writes.emplace_back(tar->GetPageId(), copy);
+    cleaning_.insert(tar->GetPageId());
+  }
+  if (writes.empty()) {
+    return 0;
+  }
+  lck.unlock();
+  disk_manager_->WritePages(writes);
+  lck.lock();
+  for (auto &write : writes) {
+    cleaning_.erase(write.first);
+  }
+  clean_cv_.notify_all();
+  num_pages_cleaned_ += writes.size();
+  return writes.size();
+}
+
 //DEBUG
 bool BufferPoolManager::CheckAllUnpined() {
   bool res = true;
@@ -0,0 +1,115 @@
+/**
+ * buffered_replacer.cpp
+ */
+
+#include <thread>
+
+#include "buffer/buffered_replacer.h"
+#include "page/page.h"
+
+namespace scudb {
+
+template <typename T>
+BufferedReplacer<T>::BufferedReplacer(Replacer<T> *replacer,
+                                      std::function<bool(const T &)> admit)
+    : replacer_(replacer), admit_(admit) {
+  for (auto &stripe : stripes_) {
+    stripe.head_ = 0;
+    stripe.tail_ = 0;
+    for (auto &slot : stripe.slots_) {
+      slot.full_ = false;
+    }
+  }
+}
+
+template <typename T> BufferedReplacer<T>::~BufferedReplacer() {}
+
+/*
+ * Reserve the next slot of the thread's stripe, then fill it. The drain
+ * waits for reserved slots to be filled, which takes no lock
+ */
+template <typename T> bool BufferedReplacer<T>::TryInsert(const T &value) {
+  static thread_local size_t index =
+      std::hash<std::thread::id>()(std::this_thread::get_id());
+  Stripe &stripe = stripes_[index % ACCESS_BUFFER_STRIPES];
+  uint32_t tail = stripe.tail_.load();
+  do {
+    if (tail - stripe.head_.load() >= ACCESS_BUFFER_SIZE) {
+      return false;
+    }
+  } while (!stripe.tail_.compare_exchange_weak(tail, tail + 1));
+  Slot &slot = stripe.slots_[tail % ACCESS_BUFFER_SIZE];
+  slot.value_ = value;
+  slot.full_ = true;
+  return true;
+}
+
+template <typename T> void BufferedReplacer<T>::Insert(const T &value) {
+  if (TryInsert(value)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lck(drain_latch_);
+  DrainLocked();
+  if (!admit_ || admit_(value)) {
+    replacer_->Insert(value);
+  }
+}
+
+template <typename T> bool BufferedReplacer<T>::Victim(T &value) {
+  std::lock_guard<std::mutex> lck(drain_latch_);
+  DrainLocked();
+  return replacer_->Victim(value);
+}
+
+template <typename T> bool BufferedReplacer<T>::Erase(const T &value) {
+  std::lock_guard<std::mutex> lck(drain_latch_);
+  DrainLocked();
+  return replacer_->Erase(value);
+}
+
+template <typename T> size_t BufferedReplacer<T>::Size() {
+  std::lock_guard<std::mutex> lck(drain_latch_);
+  DrainLocked();
+  return replacer_->Size();
+}
+
+template <typename T>
+void BufferedReplacer<T>::PeekVictims(std::vector<T> &values,
+                                      size_t max_count) {
+  std::lock_guard<std::mutex> lck(drain_latch_);
+  DrainLocked();
+  replacer_->PeekVictims(values, max_count);
+}
+
+template <typename T> void BufferedReplacer<T>::Drain() {
+  std::lock_guard<std::mutex> lck(drain_latch_);
+  DrainLocked();
+}
+
+/*
+ * Apply each stripe's inserts in the order their slots were reserved, and
+ * free the slots as they are read
+ */
+template <typename T> void BufferedReplacer<T>::DrainLocked() {
+  for (auto &stripe : stripes_) {
+    uint32_t tail = stripe.tail_.load();
+    for (uint32_t head = stripe.head_.load(); head != tail; ++head) {
+      Slot &slot = stripe.slots_[head % ACCESS_BUFFER_SIZE];
+      while (!slot.full_.load()) {
+        std::this_thread::yield();
+      }
+      T value = slot.value_;
+      slot.full_ = false;
+      stripe.head_ = head + 1;
+      if (!admit_ || admit_(value)) {
+        replacer_->Insert(value);
+      }
+    }
+  }
+}
+
+template class BufferedReplacer<Page *>;
+// test only
+template class BufferedReplacer<int>;
+
+} // namespace scudb
@@ -0,0 +1,106 @@
+/**
+ * clock_replacer.cpp
+ */
+
+#include "buffer/clock_replacer.h"
+#include "page/page.h"
+
+namespace scudb {
+
+template <typename T> ClockReplacer<T>::ClockReplacer() : hand_(ring_.end()) {}
+
+template <typename T> ClockReplacer<T>::~ClockReplacer() {}
+
+/*
+ * Set the reference bit of value; a new value goes in just behind the hand,
+ * so that it is the last one the hand reaches
+ */
+template <typename T> void ClockReplacer<T>::Insert(const T &value) {
+  std::lock_guard<std::mutex> lck(latch_);
+  auto it = map_.find(value);
+  if (it != map_.end()) {
+    it->second->referenced_ = true;
+    return;
+  }
+  map_[value] = ring_.insert(hand_, Entry{value, true});
+  if (hand_ == ring_.end()) {
+    hand_ = ring_.begin();
+  }
+}
+
+/*
+ * Sweep until an entry with a clear reference bit is under the hand. At most
+ * one full turn is needed, as the first turn clears every bit
+ */
+template <typename T> bool ClockReplacer<T>::Victim(T &value) {
+  std::lock_guard<std::mutex> lck(latch_);
+  if (ring_.empty()) {
+    return false;
+  }
+  while (hand_->referenced_) {
+    hand_->referenced_ = false;
+    Advance();
+  }
+  value = hand_->value_;
+  map_.erase(value);
+  hand_ = ring_.erase(hand_);
+  if (hand_ == ring_.end()) {
+    hand_ = ring_.begin();
+  }
+  return true;
+}
+
+template <typename T> bool ClockReplacer<T>::Erase(const T &value) {
+  std::lock_guard<std::mutex> lck(latch_);
+  auto it = map_.find(value);
+  if (it == map_.end()) {
+    return false;
+  }
+  if (it->second == hand_) {
+    Advance();
+  }
+  ring_.erase(it->second);
+  map_.erase(it);
+  if (ring_.empty()) {
+    hand_ = ring_.end();
+  }
+  return true;
+}
+
+template <typename T> size_t ClockReplacer<T>::Size() {
+  std::lock_guard<std::mutex> lck(latch_);
+  return map_.size();
+}
+
+/*
+ * The sweep takes unreferenced entries in hand order first, then, with all
+ * bits cleared, the referenced ones in the same order
+ */
+template <typename T>
+void ClockReplacer<T>::PeekVictims(std::vector<T> &values, size_t max_count) {
+  std::lock_guard<std::mutex> lck(latch_);
+  for (bool referenced : {false, true}) {
+    auto it = hand_;
+    for (size_t i = 0; i < ring_.size() && max_count > 0; ++i) {
+      if (it->referenced_ == referenced) {
+        values.push_back(it->value_);
+        --max_count;
+      }
+      if (++it == ring_.end()) {
+        it = ring_.begin();
+      }
+    }
+  }
+}
+
+template <typename T> void ClockReplacer<T>::Advance() {
+  if (++hand_ == ring_.end()) {
+    hand_ = ring_.begin();
+  }
+}
+
+template class ClockReplacer<Page *>;
+// test only
+template class ClockReplacer<int>;
+
+} // namespace scudb
@@ -0,0 +1,121 @@
+/**
+ * compressed_page_cache.cpp
+ */
+
+#include <cstring>
+
+#include "buffer/compressed_page_cache.h"
+#include "disk/page_codec.h"
+
+namespace scudb {
+
+CompressedPageCache::CompressedPageCache(size_t budget_bytes,
+                                         size_t page_size)
+    : page_size_(page_size), budget_bytes_(budget_bytes) {}
+
+/*
+ * Compression runs before the latch is taken; only a page that shrinks by at
+ * least a byte is kept
+ */
+bool CompressedPageCache::Put(page_id_t page_id, const char *data) {
+  if (budget_bytes_ == 0) {
+    Erase(page_id);
+    return false;
+  }
+  std::unique_ptr<char[]> buffer(new char[page_size_]);
+  size_t len = PageCodec::Compress(data, page_size_, buffer.get(),
+                                   page_size_ - 1);
+  std::unique_ptr<char[]> compressed;
+  if (len > 0 && len <= budget_bytes_) {
+    compressed.reset(new char[len]);
+    memcpy(compressed.get(), buffer.get(), len);
+  }
+  std::lock_guard<std::mutex> lck(latch_);
+  auto it = entries_.find(page_id);
+  if (it != entries_.end()) {
+    EraseEntry(it);
+  }
+  if (compressed == nullptr) {
+    ++num_rejected_;
+    return false;
+  }
+  lru_.push_front(page_id);
+  entries_[page_id] = Entry{std::move(compressed), len, lru_.begin()};
+  used_bytes_ += len;
+  ++num_stored_;
+  Shrink();
+  return true;
+}
+
+bool CompressedPageCache::Take(page_id_t page_id, char *data) {
+  std::unique_ptr<char[]> compressed;
+  size_t len;
+  {
+    std::lock_guard<std::mutex> lck(latch_);
+    auto it = entries_.find(page_id);
+    if (it == entries_.end()) {
+      ++num_misses_;
+      return false;
+    }
+    compressed = std::move(it->second.data_);
+    len = it->second.len_;
+    EraseEntry(it);
+  }
+  if (!PageCodec::Decompress(compressed.get(), len, data, page_size_)) {
+    ++num_misses_;
+    return false;
+  }
+  ++num_hits_;
+  return true;
+}
+
+void CompressedPageCache::Erase(page_id_t page_id) {
+  std::lock_guard<std::mutex> lck(latch_);
+  auto it = entries_.find(page_id);
+  if (it != entries_.end()) {
+    EraseEntry(it);
+  }
+}
+
+void CompressedPageCache::SetBudget(size_t budget_bytes) {
+  std::lock_guard<std::mutex> lck(latch_);
+  budget_bytes_ = budget_bytes;
+  Shrink();
+}
+
+CompressedCacheStats CompressedPageCache::GetStats() {
+  CompressedCacheStats stats;
+  {
+    std::lock_guard<std::mutex> lck(latch_);
+    stats.budget_bytes_ = budget_bytes_;
+    stats.used_bytes_ = used_bytes_;
+    stats.num_pages_ = entries_.size();
+  }
+  stats.num_hits_ = num_hits_;
+  stats.num_misses_ = num_misses_;
+  stats.num_stored_ = num_stored_;
+  stats.num_rejected_ = num_rejected_;
+  stats.num_dropped_ = num_dropped_;
+  return stats;
+}
+
+// caller holds latch_
+void CompressedPageCache::EraseEntry(
+    std::unordered_map<page_id_t, Entry>::iterator it) {
+  used_bytes_ -= it->second.len_;
+  lru_.erase(it->second.lru_);
+  entries_.erase(it);
+}
+
+/*
+ * Drop the least recently stored pages until the budget holds. Caller holds
+ * latch_
+ */
+void CompressedPageCache::Shrink() {
+  while (used_bytes_ > budget_bytes_) {
+    EraseEntry(entries_.find(lru_.back()));
+    ++num_dropped_;
+  }
+}
+
+} // namespace scudb
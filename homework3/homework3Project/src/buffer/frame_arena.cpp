@@ -0,0 +1,243 @@
+/**
+ * frame_arena.cpp
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "buffer/frame_arena.h"
+
+namespace scudb {
+
+static const char *const MEMORY_NAMES[] = {"default", "thp", "hugetlb"};
+
+// mbind mode preferring a node, from <numaif.h>, which needs libnuma
+static const int MPOL_PREFERRED_NODE = 1;
+
+const char *FrameMemoryName(FrameMemory memory) {
+  return MEMORY_NAMES[static_cast<int>(memory)];
+}
+
+bool ParseFrameMemory(const std::string &name, FrameMemory &memory) {
+  for (int i = 0; i <= static_cast<int>(FrameMemory::EXPLICIT_HUGE); ++i) {
+    if (name == MEMORY_NAMES[i]) {
+      memory = static_cast<FrameMemory>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Ids in a sysfs list such as "0-3,8,10-11"; empty if the file is missing
+ */
+static std::vector<int> ReadIdList(const std::string &path) {
+  std::vector<int> ids;
+  std::ifstream file(path);
+  std::string list;
+  if (!std::getline(file, list)) {
+    return ids;
+  }
+  const char *p = list.c_str();
+  while (*p != '\0') {
+    char *end;
+    long first = strtol(p, &end, 10);
+    if (end == p) {
+      break;
+    }
+    long last = first;
+    if (*end == '-') {
+      p = end + 1;
+      last = strtol(p, &end, 10);
+    }
+    for (long id = first; id <= last; ++id) {
+      ids.push_back(static_cast<int>(id));
+    }
+    p = *end == ',' ? end + 1 : end;
+    if (*end != ',') {
+      break;
+    }
+  }
+  return ids;
+}
+
+int GetNumNumaNodes() {
+  static const int num_nodes = [] {
+    std::vector<int> nodes = ReadIdList("/sys/devices/system/node/online");
+    return nodes.empty() ? 1
+                         : *std::max_element(nodes.begin(), nodes.end()) + 1;
+  }();
+  return num_nodes;
+}
+
+int GetCurrentNumaNode() {
+  // node of every cpu, read once
+  static const std::vector<int> cpu_nodes = [] {
+    std::vector<int> res;
+    for (int node = 0; node < GetNumNumaNodes(); ++node) {
+      for (int cpu : ReadIdList("/sys/devices/system/node/node" +
+                                std::to_string(node) + "/cpulist")) {
+        if (cpu >= static_cast<int>(res.size())) {
+          res.resize(cpu + 1, 0);
+        }
+        res[cpu] = node;
+      }
+    }
+    return res;
+  }();
+  int cpu = sched_getcpu();
+  if (cpu < 0 || cpu >= static_cast<int>(cpu_nodes.size())) {
+    return 0;
+  }
+  return cpu_nodes[cpu];
+}
+
+FrameArena::FrameArena(size_t num_frames, size_t frame_size,
+                       FrameMemory memory, bool numa_aware)
+    : data_(nullptr), frame_size_(frame_size), num_frames_(num_frames),
+      mapped_bytes_(0), memory_(memory) {
+  size_t bytes = std::max<size_t>(num_frames, 1) * frame_size;
+  int num_nodes = numa_aware ? GetNumNumaNodes() : 1;
+  size_t granularity = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  if (memory == FrameMemory::DEFAULT && num_nodes == 1) {
+    // aligned so that frames can be handed to a direct I/O disk manager
+    // without bouncing
+    void *frames = nullptr;
+    if (posix_memalign(&frames, DIRECT_IO_ALIGNMENT, bytes) != 0) {
+      throw std::bad_alloc();
+    }
+    data_ = static_cast<char *>(frames);
+  } else if (memory == FrameMemory::DEFAULT) {
+    // mapped, so that each node's part can be bound before it is touched
+    mapped_bytes_ = (bytes + granularity - 1) / granularity * granularity;
+    void *frames = mmap(nullptr, mapped_bytes_, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (frames == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    data_ = static_cast<char *>(frames);
+  } else {
+    data_ = MapHuge(bytes, memory == FrameMemory::EXPLICIT_HUGE);
+    granularity = HUGE_PAGE_SIZE;
+  }
+
+  // equal parts, cut at the granularity the memory is mapped with
+  for (int node = 0; node < num_nodes; ++node) {
+    size_t end = bytes;
+    if (node + 1 < num_nodes) {
+      end = bytes / num_nodes * (node + 1) / granularity * granularity;
+    }
+    node_ends_.push_back(
+        std::min(num_frames_, (end + frame_size - 1) / frame_size));
+  }
+  if (num_nodes > 1) {
+    BindToNodes(granularity);
+  }
+}
+
+FrameArena::~FrameArena() {
+  if (mapped_bytes_ > 0) {
+    munmap(data_, mapped_bytes_);
+  } else {
+    free(data_);
+  }
+}
+
+int FrameArena::GetNode(size_t frame) const {
+  auto it = std::upper_bound(node_ends_.begin(), node_ends_.end(), frame);
+  if (it == node_ends_.end()) {
+    return GetNumNodes() - 1;
+  }
+  return static_cast<int>(it - node_ends_.begin());
+}
+
+void FrameArena::Release(size_t first, size_t last) {
+  size_t granularity = memory_ == FrameMemory::EXPLICIT_HUGE
+                           ? HUGE_PAGE_SIZE
+                           : static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  uintptr_t start = reinterpret_cast<uintptr_t>(GetFrame(first));
+  uintptr_t end = reinterpret_cast<uintptr_t>(GetFrame(last));
+  start = (start + granularity - 1) / granularity * granularity;
+  end = end / granularity * granularity;
+  if (end > start) {
+    madvise(reinterpret_cast<void *>(start), end - start, MADV_DONTNEED);
+  }
+}
+
+/*
+ * Map bytes rounded up to huge pages, aligned to a huge page. Explicit huge
+ * pages fall back to transparent ones when the hugetlb pool cannot serve
+ * the request; memory_ records what was obtained
+ */
+char *FrameArena::MapHuge(size_t bytes, bool explicit_huge) {
+  size_t len = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+#ifdef MAP_HUGETLB
+  if (explicit_huge) {
+    void *frames = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (frames != MAP_FAILED) {
+      mapped_bytes_ = len;
+      return static_cast<char *>(frames);
+    }
+  }
+#endif
+  memory_ = FrameMemory::TRANSPARENT_HUGE;
+  // one huge page more than needed, so that an aligned range fits in it
+  size_t map_len = len + HUGE_PAGE_SIZE;
+  void *frames = mmap(nullptr, map_len, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (frames == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  char *start = static_cast<char *>(frames);
+  char *aligned = reinterpret_cast<char *>(
+      (reinterpret_cast<uintptr_t>(start) + HUGE_PAGE_SIZE - 1) /
+      HUGE_PAGE_SIZE * HUGE_PAGE_SIZE);
+  if (aligned > start) {
+    munmap(start, aligned - start);
+  }
+  if (start + map_len > aligned + len) {
+    munmap(aligned + len, start + map_len - (aligned + len));
+  }
+  mapped_bytes_ = len;
+#ifdef MADV_HUGEPAGE
+  if (madvise(aligned, len, MADV_HUGEPAGE) != 0) {
+    memory_ = FrameMemory::DEFAULT;
+  }
+#else
+  memory_ = FrameMemory::DEFAULT;
+#endif
+  return aligned;
+}
+
+/*
+ * Prefer each node for its part. Only pages not yet touched are placed, and
+ * a failing bind only costs locality
+ */
+void FrameArena::BindToNodes(size_t granularity) {
+#ifdef SYS_mbind
+  size_t start = 0;
+  for (int node = 0; node < GetNumNodes() && node < 64; ++node) {
+    size_t end = std::min(node_ends_[node] * frame_size_, mapped_bytes_);
+    end = node + 1 == GetNumNodes()
+              ? mapped_bytes_
+              : end / granularity * granularity;
+    if (end > start) {
+      unsigned long mask = 1UL << node;
+      syscall(SYS_mbind, data_ + start, end - start, MPOL_PREFERRED_NODE,
+              &mask, sizeof(mask) * 8 + 1, 0);
+      start = end;
+    }
+  }
+#endif
+}
+
+} // namespace scudb
@@ -0,0 +1,31 @@
+/**
+ * ghost_list.cpp
+ */
+
+#include "buffer/ghost_list.h"
+
+namespace scudb {
+
+void GhostList::PushBack(int64_t key) {
+  Erase(key);
+  map_[key] = keys_.insert(keys_.end(), key);
+}
+
+int64_t GhostList::PopFront() {
+  int64_t key = keys_.front();
+  keys_.pop_front();
+  map_.erase(key);
+  return key;
+}
+
+bool GhostList::Erase(int64_t key) {
+  auto it = map_.find(key);
+  if (it == map_.end()) {
+    return false;
+  }
+  keys_.erase(it->second);
+  map_.erase(it);
+  return true;
+}
+
+} // namespace scudb
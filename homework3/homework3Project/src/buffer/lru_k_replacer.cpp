@@ -0,0 +1,98 @@
+/**
+ * lru_k_replacer.cpp
+ */
+
+#include <algorithm>
+
+#include "buffer/lru_k_replacer.h"
+#include "page/page.h"
+
+namespace scudb {
+
+template <typename T>
+LRUKReplacer<T>::LRUKReplacer(size_t k, size_t history_size)
+    : k_(std::max<size_t>(k, 1)), history_size_(history_size),
+      current_time_(0) {}
+
+template <typename T> LRUKReplacer<T>::~LRUKReplacer() {}
+
+/*
+ * Record an access to value and (re)queue it by its new priority. A value
+ * that now stands for a different key held a page that went away without
+ * being evicted, so the old key's history is dropped
+ */
+template <typename T> void LRUKReplacer<T>::Insert(const T &value) {
+  std::lock_guard<std::mutex> lck(latch_);
+  int64_t key = ReplacerKey(value);
+  auto it = entries_.find(value);
+  if (it != entries_.end()) {
+    order_.erase(it->second.pos_);
+    if (it->second.key_ != key) {
+      history_.erase(it->second.key_);
+    }
+  }
+  remembered_.Erase(key);
+  std::deque<uint64_t> &accesses = history_[key];
+  accesses.push_back(++current_time_);
+  if (accesses.size() > k_) {
+    accesses.pop_front();
+  }
+  Priority priority(accesses.size() == k_, accesses.front());
+  entries_[value] = Entry{key, order_.emplace(priority, value).first};
+}
+
+template <typename T> bool LRUKReplacer<T>::Victim(T &value) {
+  std::lock_guard<std::mutex> lck(latch_);
+  if (order_.empty()) {
+    return false;
+  }
+  value = order_.begin()->second;
+  order_.erase(order_.begin());
+  auto it = entries_.find(value);
+  Remember(it->second.key_);
+  entries_.erase(it);
+  return true;
+}
+
+/*
+ * The value is pinned or gone; its history is kept like that of an evicted
+ * value, so a page that is pinned again and again keeps its accesses
+ */
+template <typename T> bool LRUKReplacer<T>::Erase(const T &value) {
+  std::lock_guard<std::mutex> lck(latch_);
+  auto it = entries_.find(value);
+  if (it == entries_.end()) {
+    return false;
+  }
+  order_.erase(it->second.pos_);
+  Remember(it->second.key_);
+  entries_.erase(it);
+  return true;
+}
+
+template <typename T> size_t LRUKReplacer<T>::Size() {
+  std::lock_guard<std::mutex> lck(latch_);
+  return entries_.size();
+}
+
+template <typename T>
+void LRUKReplacer<T>::PeekVictims(std::vector<T> &values, size_t max_count) {
+  std::lock_guard<std::mutex> lck(latch_);
+  for (auto it = order_.begin(); it != order_.end() && max_count > 0;
+       ++it, --max_count) {
+    values.push_back(it->second);
+  }
+}
+
+template <typename T> void LRUKReplacer<T>::Remember(int64_t key) {
+  remembered_.PushBack(key);
+  if (remembered_.Size() > history_size_) {
+    history_.erase(remembered_.PopFront());
+  }
+}
+
+template class LRUKReplacer<Page *>;
+// test only
+template class LRUKReplacer<int>;
+
+} // namespace scudb
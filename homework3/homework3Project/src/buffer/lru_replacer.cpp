@@ -83,7 +83,19 @@ template <typename T> bool LRUReplacer<T>::Erase(const T &value) {
 
 template <typename T> size_t LRUReplacer<T>::Size() {
   lock_guard<mutex> lck(latch);
-  return 1;//map.size();
+  return map.size();
+}
+
+/*
+ * Collect up to max_count values from the least recently used end
+ */
+template <typename T>
+void LRUReplacer<T>::PeekVictims(std::vector<T> &values, size_t max_count) {
+  lock_guard<mutex> lck(latch);
+  for (shared_ptr<Node> cur = tail->prev; cur != head && max_count > 0;
+       cur = cur->prev, --max_count) {
+    values.push_back(cur->val);
+  }
 }
 
 template class LRUReplacer<Page *>;
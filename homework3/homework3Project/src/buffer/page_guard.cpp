@@ -0,0 +1,89 @@
+/**
+ * page_guard.cpp
+ */
+
+#include <utility>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/page_guard.h"
+
+namespace scudb {
+
+BasicPageGuard::BasicPageGuard(BufferPoolManager *buffer_pool_manager,
+                               Page *page)
+    : buffer_pool_manager_(buffer_pool_manager), page_(page) {}
+
+BasicPageGuard::BasicPageGuard(BasicPageGuard &&that) noexcept
+    : buffer_pool_manager_(that.buffer_pool_manager_), page_(that.page_),
+      is_dirty_(that.is_dirty_) {
+  that.page_ = nullptr;
+  that.is_dirty_ = false;
+}
+
+BasicPageGuard &BasicPageGuard::operator=(BasicPageGuard &&that) noexcept {
+  if (this != &that) {
+    Release();
+    buffer_pool_manager_ = that.buffer_pool_manager_;
+    page_ = that.page_;
+    is_dirty_ = that.is_dirty_;
+    that.page_ = nullptr;
+    that.is_dirty_ = false;
+  }
+  return *this;
+}
+
+void BasicPageGuard::Release() {
+  if (page_ != nullptr) {
+    buffer_pool_manager_->UnpinPage(page_, is_dirty_);
+    page_ = nullptr;
+    is_dirty_ = false;
+  }
+}
+
+ReadPageGuard::ReadPageGuard(BufferPoolManager *buffer_pool_manager,
+                             Page *page)
+    : guard_(buffer_pool_manager, page) {
+  if (page != nullptr) {
+    page->RLatch();
+  }
+}
+
+ReadPageGuard &ReadPageGuard::operator=(ReadPageGuard &&that) noexcept {
+  if (this != &that) {
+    Release();
+    guard_ = std::move(that.guard_);
+  }
+  return *this;
+}
+
+void ReadPageGuard::Release() {
+  if (guard_.IsValid()) {
+    guard_.GetPage()->RUnlatch();
+    guard_.Release();
+  }
+}
+
+WritePageGuard::WritePageGuard(BufferPoolManager *buffer_pool_manager,
+                               Page *page)
+    : guard_(buffer_pool_manager, page) {
+  if (page != nullptr) {
+    page->WLatch();
+  }
+}
+
+WritePageGuard &WritePageGuard::operator=(WritePageGuard &&that) noexcept {
+  if (this != &that) {
+    Release();
+    guard_ = std::move(that.guard_);
+  }
+  return *this;
+}
+
+void WritePageGuard::Release() {
+  if (guard_.IsValid()) {
+    guard_.GetPage()->WUnlatch();
+    guard_.Release();
+  }
+}
+
+} // namespace scudb
@@ -0,0 +1,194 @@
+/**
+ * parallel_buffer_pool_manager.cpp
+ */
+
+#include <mutex>
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+namespace scudb {
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances,
+                                                     size_t pool_size,
+                                                     DiskManager *disk_manager,
+                                                     LogManager *log_manager,
+                                                     ReplacerPolicy policy,
+                                                     FrameMemory memory,
+                                                     bool numa_aware,
+                                                     size_t max_pool_size)
+    : BufferPoolManager(disk_manager, log_manager) {
+  if (num_instances == 0)
+    num_instances = 1;
+  instances_.resize(num_instances);
+  for (size_t i = 0; i < num_instances; ++i) {
+    instances_[i] = new BufferPoolManager(
+        GetShare(pool_size, i), disk_manager, log_manager, policy, memory,
+        numa_aware, GetShare(max_pool_size, i));
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  // the worker would still prefetch into the instances
+  StopPrefetchWorker();
+  for (auto instance : instances_)
+    delete instance;
+}
+
+Page *ParallelBufferPoolManager::FetchPage(page_id_t page_id,
+                                           BufferAccessStrategy *strategy) {
+  return GetInstance(page_id)->FetchPage(page_id, strategy);
+}
+
+// a ref to a frame of another instance is a miss there
+Page *ParallelBufferPoolManager::FetchSwizzled(page_id_t page_id,
+                                               std::atomic<Page *> *ref) {
+  return GetInstance(page_id)->FetchSwizzled(page_id, ref);
+}
+
+bool ParallelBufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
+  return GetInstance(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+// a pinned page keeps its id, which names its instance
+bool ParallelBufferPoolManager::UnpinPage(Page *page, bool is_dirty) {
+  return page != nullptr &&
+         GetInstance(page->GetPageId())->UnpinPage(page, is_dirty);
+}
+
+bool ParallelBufferPoolManager::FlushPage(page_id_t page_id) {
+  return GetInstance(page_id)->FlushPage(page_id);
+}
+
+/**
+ * Adjacent pages live in different instances, so dirty pages of all
+ * instances go out as one batch to keep them coalesced
+ */
+FlushStats ParallelBufferPoolManager::FlushAllPages() {
+  return FlushInstances(instances_);
+}
+
+void ParallelBufferPoolManager::Prefetch(
+    const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy) {
+  std::vector<std::vector<page_id_t>> by_instance(instances_.size());
+  for (page_id_t page_id : page_ids) {
+    if (page_id != INVALID_PAGE_ID)
+      by_instance[page_id % instances_.size()].push_back(page_id);
+  }
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    if (!by_instance[i].empty())
+      instances_[i]->Prefetch(by_instance[i], strategy);
+  }
+}
+
+/**
+ * The page id decides the instance, so it is allocated first and handed
+ * back to the disk manager if that instance has no frame to spare. The
+ * extent takes it back, so it is the next page allocated near the hint
+ */
+Page *ParallelBufferPoolManager::NewPage(page_id_t &page_id,
+                                         page_id_t hint_page_id) {
+  page_id = disk_manager_->AllocatePage(hint_page_id);
+  Page *page = GetInstance(page_id)->NewPageWithId(page_id);
+  if (page == nullptr)
+    disk_manager_->UnallocatePage(page_id);
+  return page;
+}
+
+bool ParallelBufferPoolManager::DeletePage(page_id_t page_id) {
+  return GetInstance(page_id)->DeletePage(page_id);
+}
+
+bool ParallelBufferPoolManager::CheckAllUnpined() {
+  bool res = true;
+  for (auto instance : instances_)
+    res = instance->CheckAllUnpined() && res;
+  return res;
+}
+
+// one cleaner per instance, each watches its own replacer
+void ParallelBufferPoolManager::StartCleaner(double low_ratio,
+                                             double high_ratio) {
+  for (auto instance : instances_)
+    instance->StartCleaner(low_ratio, high_ratio);
+}
+
+void ParallelBufferPoolManager::StopCleaner() {
+  for (auto instance : instances_)
+    instance->StopCleaner();
+}
+
+uint64_t ParallelBufferPoolManager::GetNumPagesCleaned() const {
+  uint64_t res = 0;
+  for (auto instance : instances_)
+    res += instance->GetNumPagesCleaned();
+  return res;
+}
+
+size_t ParallelBufferPoolManager::GetPoolSize() const {
+  size_t res = 0;
+  for (auto instance : instances_)
+    res += instance->GetPoolSize();
+  return res;
+}
+
+size_t ParallelBufferPoolManager::GetMaxPoolSize() const {
+  size_t res = 0;
+  for (auto instance : instances_)
+    res += instance->GetMaxPoolSize();
+  return res;
+}
+
+/*
+ * Shares grow with the total, so each fits its instance's maximum when the
+ * total fits the sum of them
+ */
+bool ParallelBufferPoolManager::Resize(size_t new_size) {
+  if (new_size < instances_.size() || new_size > GetMaxPoolSize())
+    return false;
+  bool res = true;
+  for (size_t i = 0; i < instances_.size(); ++i)
+    res = instances_[i]->Resize(GetShare(new_size, i)) && res;
+  return res;
+}
+
+// every instance asks for the same memory, the first tells what they got
+FrameMemory ParallelBufferPoolManager::GetFrameMemory() const {
+  return instances_[0]->GetFrameMemory();
+}
+
+uint64_t ParallelBufferPoolManager::GetNumDirtyEvictions() const {
+  uint64_t res = 0;
+  for (auto instance : instances_)
+    res += instance->GetNumDirtyEvictions();
+  return res;
+}
+
+uint64_t ParallelBufferPoolManager::GetNumSwizzledHits() const {
+  uint64_t res = 0;
+  for (auto instance : instances_)
+    res += instance->GetNumSwizzledHits();
+  return res;
+}
+
+void ParallelBufferPoolManager::SetCompressedCacheBudget(size_t budget_bytes) {
+  for (size_t i = 0; i < instances_.size(); ++i)
+    instances_[i]->SetCompressedCacheBudget(GetShare(budget_bytes, i));
+}
+
+CompressedCacheStats ParallelBufferPoolManager::GetCompressedCacheStats() {
+  CompressedCacheStats res;
+  for (auto instance : instances_) {
+    CompressedCacheStats stats = instance->GetCompressedCacheStats();
+    res.budget_bytes_ += stats.budget_bytes_;
+    res.used_bytes_ += stats.used_bytes_;
+    res.num_pages_ += stats.num_pages_;
+    res.num_hits_ += stats.num_hits_;
+    res.num_misses_ += stats.num_misses_;
+    res.num_stored_ += stats.num_stored_;
+    res.num_rejected_ += stats.num_rejected_;
+    res.num_dropped_ += stats.num_dropped_;
+  }
+  return res;
+}
+
+} // namespace scudb
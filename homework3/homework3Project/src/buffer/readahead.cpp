@@ -0,0 +1,67 @@
+/**
+ * readahead.cpp
+ */
+
+#include <algorithm>
+
+#include "buffer/readahead.h"
+
+namespace scudb {
+
+Readahead::Readahead(BufferPoolManager *buffer_pool_manager,
+                     BufferAccessStrategy *strategy)
+    : buffer_pool_manager_(buffer_pool_manager), strategy_(strategy),
+      last_page_id_(INVALID_PAGE_ID), sequential_moves_(0), window_(0),
+      prefetched_until_(INVALID_PAGE_ID) {}
+
+Readahead::~Readahead() {
+  if (pending_.valid()) {
+    pending_.wait();
+  }
+}
+
+/*
+ * Count sequential moves, and once the scan is at least half way through the
+ * pages requested so far, request the next window. Requests are served in
+ * order, so only the latest future has to be kept
+ */
+void Readahead::Advance(page_id_t page_id) {
+  if (last_page_id_ != INVALID_PAGE_ID && page_id == last_page_id_ + 1) {
+    ++sequential_moves_;
+  } else {
+    sequential_moves_ = 0;
+    window_ = 0;
+    prefetched_until_ = page_id;
+  }
+  last_page_id_ = page_id;
+  if (sequential_moves_ < READAHEAD_TRIGGER ||
+      !buffer_pool_manager_->IsReadaheadEnabled() ||
+      page_id + static_cast<page_id_t>(window_ / 2) < prefetched_until_) {
+    return;
+  }
+
+  // prefetched pages must not push each other out of the pool
+  size_t max_window = std::min<size_t>(
+      READAHEAD_MAX_PAGES, buffer_pool_manager_->GetPoolSize() / 4);
+  if (strategy_ != nullptr) {
+    size_t ring = std::min(strategy_->GetRingSize(),
+                           buffer_pool_manager_->GetPoolSize() / 8);
+    max_window = std::min(max_window, ring / 2);
+  }
+  max_window = std::max<size_t>(max_window, 1);
+  window_ = std::min(std::max<size_t>(window_ * 2, READAHEAD_MIN_PAGES),
+                     max_window);
+  std::vector<page_id_t> page_ids;
+  page_id_t end = page_id + static_cast<page_id_t>(window_);
+  for (page_id_t next = std::max(prefetched_until_, page_id) + 1; next <= end;
+       ++next) {
+    page_ids.push_back(next);
+  }
+  prefetched_until_ = std::max(prefetched_until_, end);
+  if (!page_ids.empty()) {
+    pending_ =
+        buffer_pool_manager_->PrefetchAsync(std::move(page_ids), strategy_);
+  }
+}
+
+} // namespace scudb
@@ -0,0 +1,58 @@
+/**
+ * replacer_factory.cpp
+ */
+
+#include "buffer/replacer_factory.h"
+#include "buffer/arc_replacer.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/two_q_replacer.h"
+#include "page/page.h"
+
+namespace scudb {
+
+static const char *const POLICY_NAMES[] = {"lru", "clock", "lru-k", "2q",
+                                           "arc"};
+
+/*
+ * Keys of a frame are those of its page, read at the time of the call
+ */
+int64_t ReplacerKey(Page *const &page) { return page->GetPageId(); }
+
+template <typename T>
+Replacer<T> *CreateReplacer(ReplacerPolicy policy, size_t capacity) {
+  switch (policy) {
+  case ReplacerPolicy::CLOCK:
+    return new ClockReplacer<T>;
+  case ReplacerPolicy::LRU_K:
+    return new LRUKReplacer<T>(LRUK_K, capacity);
+  case ReplacerPolicy::TWO_Q:
+    return new TwoQReplacer<T>(capacity);
+  case ReplacerPolicy::ARC:
+    return new ARCReplacer<T>(capacity);
+  default:
+    return new LRUReplacer<T>;
+  }
+}
+
+const char *ReplacerPolicyName(ReplacerPolicy policy) {
+  return POLICY_NAMES[static_cast<int>(policy)];
+}
+
+bool ParseReplacerPolicy(const std::string &name, ReplacerPolicy &policy) {
+  for (int i = 0; i <= static_cast<int>(ReplacerPolicy::ARC); ++i) {
+    if (name == POLICY_NAMES[i]) {
+      policy = static_cast<ReplacerPolicy>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+template Replacer<Page *> *CreateReplacer(ReplacerPolicy policy,
+                                          size_t capacity);
+// test only
+template Replacer<int> *CreateReplacer(ReplacerPolicy policy, size_t capacity);
+
+} // namespace scudb
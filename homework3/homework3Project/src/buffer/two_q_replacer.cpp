@@ -0,0 +1,135 @@
+/**
+ * two_q_replacer.cpp
+ */
+
+#include <algorithm>
+
+#include "buffer/two_q_replacer.h"
+#include "page/page.h"
+
+namespace scudb {
+
+template <typename T>
+TwoQReplacer<T>::TwoQReplacer(size_t capacity)
+    : kin_(std::max<size_t>(capacity / 4, 1)),
+      kout_(std::max<size_t>(capacity / 2, 1)), size_(0) {}
+
+template <typename T> TwoQReplacer<T>::~TwoQReplacer() {}
+
+/*
+ * A value in Am moves to its most recently used end, a value in A1in stays
+ * where it is. A new value goes to Am if A1out remembers its key, else to
+ * the end of A1in
+ */
+template <typename T> void TwoQReplacer<T>::Insert(const T &value) {
+  std::lock_guard<std::mutex> lck(latch_);
+  int64_t key = ReplacerKey(value);
+  auto it = entries_.find(value);
+  if (it != entries_.end() && it->second.key_ != key) {
+    (it->second.hot_ ? am_ : a1in_).erase(it->second.pos_);
+    if (it->second.evictable_) {
+      --size_;
+    }
+    entries_.erase(it);
+    it = entries_.end();
+  }
+  if (it != entries_.end()) {
+    Entry &entry = it->second;
+    if (entry.hot_) {
+      am_.splice(am_.end(), am_, entry.pos_);
+    }
+    if (!entry.evictable_) {
+      entry.evictable_ = true;
+      ++size_;
+    }
+    return;
+  }
+  bool hot = a1out_.Erase(key);
+  std::list<T> &queue = hot ? am_ : a1in_;
+  entries_[value] = Entry{key, hot, true, queue.insert(queue.end(), value)};
+  ++size_;
+}
+
+/*
+ * Evict from the head of A1in while it holds more than kin_ values, else
+ * from the least recently used end of Am; either way falling back to the
+ * other queue if the first has nothing eligible
+ */
+template <typename T> bool TwoQReplacer<T>::Victim(T &value) {
+  std::lock_guard<std::mutex> lck(latch_);
+  if (size_ == 0) {
+    return false;
+  }
+  std::list<T> *queue = a1in_.size() > kin_ ? &a1in_ : &am_;
+  auto it = NextEvictable(*queue, queue->begin());
+  if (it == queue->end()) {
+    queue = queue == &a1in_ ? &am_ : &a1in_;
+    it = NextEvictable(*queue, queue->begin());
+  }
+  value = *it;
+  queue->erase(it);
+  if (queue == &a1in_) {
+    a1out_.PushBack(entries_.find(value)->second.key_);
+    if (a1out_.Size() > kout_) {
+      a1out_.PopFront();
+    }
+  }
+  entries_.erase(value);
+  --size_;
+  return true;
+}
+
+template <typename T> bool TwoQReplacer<T>::Erase(const T &value) {
+  std::lock_guard<std::mutex> lck(latch_);
+  auto it = entries_.find(value);
+  if (it == entries_.end() || !it->second.evictable_) {
+    return false;
+  }
+  it->second.evictable_ = false;
+  --size_;
+  return true;
+}
+
+template <typename T> size_t TwoQReplacer<T>::Size() {
+  std::lock_guard<std::mutex> lck(latch_);
+  return size_;
+}
+
+/*
+ * Replay Victim's choices without evicting: A1in shrinks with every value
+ * taken from it
+ */
+template <typename T>
+void TwoQReplacer<T>::PeekVictims(std::vector<T> &values, size_t max_count) {
+  std::lock_guard<std::mutex> lck(latch_);
+  size_t a1in_size = a1in_.size();
+  auto in = NextEvictable(a1in_, a1in_.begin());
+  auto m = NextEvictable(am_, am_.begin());
+  for (; max_count > 0 && (in != a1in_.end() || m != am_.end());
+       --max_count) {
+    if (in != a1in_.end() && (a1in_size > kin_ || m == am_.end())) {
+      values.push_back(*in);
+      --a1in_size;
+      in = NextEvictable(a1in_, ++in);
+    } else {
+      values.push_back(*m);
+      m = NextEvictable(am_, ++m);
+    }
+  }
+}
+
+template <typename T>
+typename std::list<T>::iterator
+TwoQReplacer<T>::NextEvictable(std::list<T> &queue,
+                               typename std::list<T>::iterator it) {
+  while (it != queue.end() && !entries_.find(*it)->second.evictable_) {
+    ++it;
+  }
+  return it;
+}
+
+template class TwoQReplacer<Page *>;
+// test only
+template class TwoQReplacer<int>;
+
+} // namespace scudb
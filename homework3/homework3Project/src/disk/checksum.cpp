@@ -0,0 +1,163 @@
+/**
+ * checksum.cpp
+ */
+
+#include <cstring>
+#include <initializer_list>
+
+#include "disk/checksum.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define CRC32C_HAVE_SSE42
+#endif
+
+namespace scudb {
+
+static const uint32_t CRC32C_POLY = 0x82f63b78; // reversed Castagnoli
+
+/**
+ * Eight lookup tables, table[k][b] is the crc of byte b followed by k zeroes
+ */
+struct Crc32cTable {
+  Crc32cTable() {
+    for (uint32_t b = 0; b < 256; ++b) {
+      uint32_t crc = b;
+      for (int bit = 0; bit < 8; ++bit)
+        crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+      table_[0][b] = crc;
+    }
+    for (uint32_t b = 0; b < 256; ++b)
+      for (int k = 1; k < 8; ++k)
+        table_[k][b] =
+            (table_[k - 1][b] >> 8) ^ table_[0][table_[k - 1][b] & 0xff];
+  }
+  uint32_t table_[8][256];
+};
+
+uint32_t Crc32cPortable(const char *data, size_t len) {
+  static const Crc32cTable tables;
+  const uint32_t(*t)[256] = tables.table_;
+  const uint8_t *p = reinterpret_cast<const uint8_t *>(data);
+  uint32_t crc = 0xffffffff;
+  for (; len >= 8; len -= 8, p += 8) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    word ^= crc; // little endian
+    crc = t[7][word & 0xff] ^ t[6][(word >> 8) & 0xff] ^
+          t[5][(word >> 16) & 0xff] ^ t[4][(word >> 24) & 0xff] ^
+          t[3][(word >> 32) & 0xff] ^ t[2][(word >> 40) & 0xff] ^
+          t[1][(word >> 48) & 0xff] ^ t[0][word >> 56];
+  }
+  for (; len > 0; --len, ++p)
+    crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xff];
+  return ~crc;
+}
+
+#ifdef CRC32C_HAVE_SSE42
+static const size_t CRC32C_LONG = 4096; // stream lengths of the 3-way loops,
+static const size_t CRC32C_SHORT = 256; // both powers of two
+
+static uint32_t Gf2MatrixTimes(const uint32_t *mat, uint32_t vec) {
+  uint32_t sum = 0;
+  for (; vec != 0; vec >>= 1, ++mat)
+    if (vec & 1)
+      sum ^= *mat;
+  return sum;
+}
+
+static void Gf2MatrixSquare(uint32_t *square, const uint32_t *mat) {
+  for (int n = 0; n < 32; ++n)
+    square[n] = Gf2MatrixTimes(mat, mat[n]);
+}
+
+/**
+ * Tables that advance a crc register over len zero bytes (len a power of
+ * two) with four lookups, used to join crcs of adjacent blocks
+ */
+struct Crc32cZeros {
+  explicit Crc32cZeros(size_t len) {
+    // operator for one zero bit, squared up to len zero bytes
+    uint32_t odd[32], even[32];
+    odd[0] = CRC32C_POLY;
+    for (int n = 1; n < 32; ++n)
+      odd[n] = 1u << (n - 1);
+    Gf2MatrixSquare(even, odd); // 2 bits
+    Gf2MatrixSquare(odd, even); // 4 bits
+    uint32_t *op = odd;
+    for (size_t bytes = 1; bytes <= len; bytes <<= 1) {
+      uint32_t *next = (op == odd) ? even : odd;
+      Gf2MatrixSquare(next, op);
+      op = next;
+    }
+    for (uint32_t n = 0; n < 256; ++n)
+      for (int k = 0; k < 4; ++k)
+        table_[k][n] = Gf2MatrixTimes(op, n << (8 * k));
+  }
+  inline uint32_t Shift(uint32_t crc) const {
+    return table_[0][crc & 0xff] ^ table_[1][(crc >> 8) & 0xff] ^
+           table_[2][(crc >> 16) & 0xff] ^ table_[3][crc >> 24];
+  }
+  uint32_t table_[4][256];
+};
+
+/**
+ * The crc32 instruction has a latency of three cycles but a throughput of
+ * one, so three independent streams are run side by side and their crcs are
+ * joined afterwards
+ */
+__attribute__((target("sse4.2"))) static uint32_t
+Crc32cHardware(const char *data, size_t len) {
+  static const Crc32cZeros long_zeros(CRC32C_LONG);
+  static const Crc32cZeros short_zeros(CRC32C_SHORT);
+  const uint8_t *p = reinterpret_cast<const uint8_t *>(data);
+  uint64_t crc0 = 0xffffffff;
+#ifdef __x86_64__
+  for (size_t block : {CRC32C_LONG, CRC32C_SHORT}) {
+    const Crc32cZeros &zeros = (block == CRC32C_LONG) ? long_zeros : short_zeros;
+    for (; len >= 3 * block; len -= 3 * block, p += 3 * block) {
+      uint64_t crc1 = 0, crc2 = 0;
+      for (size_t i = 0; i < block; i += 8) {
+        uint64_t w0, w1, w2;
+        memcpy(&w0, p + i, sizeof(w0));
+        memcpy(&w1, p + block + i, sizeof(w1));
+        memcpy(&w2, p + 2 * block + i, sizeof(w2));
+        crc0 = _mm_crc32_u64(crc0, w0);
+        crc1 = _mm_crc32_u64(crc1, w1);
+        crc2 = _mm_crc32_u64(crc2, w2);
+      }
+      crc0 = zeros.Shift(static_cast<uint32_t>(crc0)) ^ crc1;
+      crc0 = zeros.Shift(static_cast<uint32_t>(crc0)) ^ crc2;
+    }
+  }
+  for (; len >= 8; len -= 8, p += 8) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    crc0 = _mm_crc32_u64(crc0, word);
+  }
+#endif
+  uint32_t crc = static_cast<uint32_t>(crc0);
+  for (; len > 0; --len, ++p)
+    crc = _mm_crc32_u8(crc, *p);
+  return ~crc;
+}
+#endif
+
+bool Crc32cHardwareAvailable() {
+#ifdef CRC32C_HAVE_SSE42
+  static const bool available = __builtin_cpu_supports("sse4.2");
+  return available;
+#else
+  return false;
+#endif
+}
+
+uint32_t Crc32c(const char *data, size_t len) {
+#ifdef CRC32C_HAVE_SSE42
+  if (Crc32cHardwareAvailable())
+    return Crc32cHardware(data, len);
+#endif
+  return Crc32cPortable(data, len);
+}
+
+} // namespace scudb
@@ -1,32 +1,92 @@
 /**
  * disk_manager.cpp
  */
+#include <algorithm>
 #include <assert.h>
+#include <cerrno>
+#include <climits>
 #include <cstring>
+#include <fcntl.h>
 #include <iostream>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <thread>
+#include <unistd.h>
 
 #include "common/logger.h"
+#include "disk/checksum.h"
 #include "disk/disk_manager.h"
+#include "disk/page_codec.h"
+#include "page/header_page.h"
 
 namespace scudb {
 
 static char *buffer_used = nullptr;
 
+/**
+ * Return an aligned scratch buffer of one page for the calling thread, used
+ * to bounce direct I/O of callers whose buffer is not suitably aligned
+ */
+static char *GetBounceBuffer() {
+  struct Buffer {
+    Buffer() {
+      if (posix_memalign(&data_, DIRECT_IO_ALIGNMENT, MAX_PAGE_SIZE) != 0)
+        data_ = nullptr;
+    }
+    ~Buffer() { free(data_); }
+    void *data_;
+  };
+  static thread_local Buffer buffer;
+  return static_cast<char *>(buffer.data_);
+}
+
+static inline bool IsAligned(const char *ptr) {
+  return reinterpret_cast<uintptr_t>(ptr) % DIRECT_IO_ALIGNMENT == 0;
+}
+
+static inline bool IsValidPageSize(size_t page_size) {
+  return page_size >= PAGE_SIZE && page_size <= MAX_PAGE_SIZE &&
+         (page_size & (page_size - 1)) == 0;
+}
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
+ * @input direct_io: bypass the kernel page cache with O_DIRECT
+ * @input page_size: page size of a newly created database, a power of two
+ * between PAGE_SIZE and MAX_PAGE_SIZE
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0), num_flushes_(0), flush_log_(false),
-      flush_log_f_(nullptr) {
+DiskManager::DiskManager(const std::string &db_file, bool direct_io,
+                         size_t page_size)
+    : DiskManager(page_size) {
+  file_name_ = db_file;
+  // an existing database keeps the page size recorded in its header page; one
+  // whose header has no magic predates it and used the default page size
+  std::ifstream header(db_file, std::ios::binary);
+  uint32_t magic = 0, recorded_size = 0;
+  if (header.seekg(HEADER_MAGIC_OFFSET) &&
+      header.read(reinterpret_cast<char *>(&magic), 4)) {
+    if (magic != HEADER_MAGIC) {
+      page_size_ = PAGE_SIZE;
+    } else if (header.seekg(HEADER_PAGE_SIZE_OFFSET) &&
+               header.read(reinterpret_cast<char *>(&recorded_size), 4) &&
+               IsValidPageSize(recorded_size)) {
+      page_size_ = recorded_size;
+    } else {
+      LOG_DEBUG("invalid page size in header page");
+    }
+  }
+  header.close();
+
   std::string::size_type n = file_name_.find(".");
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
     return;
   }
   log_name_ = file_name_.substr(0, n) + ".log";
+  fsm_name_ = file_name_.substr(0, n) + ".fsm";
+  ext_name_ = file_name_.substr(0, n) + ".ext";
+  pmap_name_ = file_name_.substr(0, n) + ".pmap";
 
   log_io_.open(log_name_,
                std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
@@ -42,61 +102,412 @@ DiskManager::DiskManager(const std::string &db_file)
                                 std::ios::out);
   }
 
-  db_io_.open(db_file,
-              std::ios::binary | std::ios::in | std::ios::out | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
+  if (direct_io && page_size_ % DIRECT_IO_ALIGNMENT != 0) {
+    LOG_DEBUG("page size is not aligned for direct I/O, fall back to buffered");
+    direct_io = false;
+  }
+  if (direct_io) {
+    // some file systems (e.g. tmpfs) reject O_DIRECT
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+    direct_io_ = (db_fd_ >= 0);
+    if (!direct_io_) {
+      LOG_DEBUG("O_DIRECT is not supported, fall back to buffered");
+    }
+  }
+  // create the file if it does not exist
+  if (db_fd_ < 0)
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  if (db_fd_ < 0) {
+    LOG_DEBUG("can't open db file");
+    return;
+  }
+  LoadFreeMap();
+  LoadExtentMap();
+  LoadPageMap();
+  StartIOWorkers();
+}
+
+/**
+ * Constructor shared by all backends: no files are opened, pages are
+ * allocated from zero
+ */
+DiskManager::DiskManager(size_t page_size)
+    : page_size_(page_size), num_write_calls_(0), num_read_calls_(0),
+      num_bytes_read_(0), num_bytes_written_(0), num_flushes_(0),
+      flush_log_(false), flush_log_f_(nullptr), db_fd_(-1), direct_io_(false),
+      next_page_id_(0), fsm_fd_(-1), punch_holes_(false), ext_fd_(-1),
+      compress_(false), pmap_fd_(-1), num_checksum_failures_(0),
+      durability_(DurabilityMode::CHECKPOINT_ONLY), num_syncs_(0),
+      num_vectored_ios_(0), io_shutdown_(false) {
+  if (!IsValidPageSize(page_size_)) {
+    LOG_DEBUG("invalid page size %zu, use default", page_size_);
+    page_size_ = PAGE_SIZE;
   }
 }
 
 DiskManager::~DiskManager() {
-  db_io_.close();
+  StopIOWorkers();
+  // pending page map entries go out behind their pages
+  if (!staged_.empty())
+    FlushStaged();
+  else if (db_fd_ >= 0)
+    SyncFile();
+  if (db_fd_ >= 0)
+    close(db_fd_);
+  if (fsm_fd_ >= 0)
+    close(fsm_fd_);
+  if (ext_fd_ >= 0)
+    close(ext_fd_);
+  if (pmap_fd_ >= 0)
+    close(pmap_fd_);
   log_io_.close();
 }
 
+void DiskManager::StartIOWorkers() {
+  for (int i = 0; i < DISK_IO_THREADS; ++i) {
+    io_workers_.emplace_back(&DiskManager::IOWorker, this);
+  }
+}
+
+/**
+ * Stop the I/O workers, they drain the queue before they exit. Does nothing
+ * when called again
+ */
+void DiskManager::StopIOWorkers() {
+  {
+    std::lock_guard<std::mutex> lck(io_latch_);
+    io_shutdown_ = true;
+  }
+  io_cv_.notify_all();
+  for (auto &worker : io_workers_) {
+    worker.join();
+  }
+  io_workers_.clear();
+}
+
 /**
- * Write the contents of the specified page into disk file
+ * Write the contents of the specified page into disk file, how soon it
+ * reaches stable storage depends on the durability mode
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = page_id * PAGE_SIZE;
-  // set write cursor to offset
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG_DEBUG("I/O error while writing");
+  if (durability_ == DurabilityMode::BATCHED) {
+    std::lock_guard<std::mutex> lck(stage_latch_);
+    staged_[page_id].assign(page_data, page_data + page_size_);
+    if (staged_.size() >= WRITE_BATCH_SIZE)
+      FlushStaged();
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  WritePageRaw(page_id, page_data);
+  if (durability_ == DurabilityMode::SYNC_EACH_WRITE)
+    SyncFile();
 }
 
 /**
- * Read the contents of the specified page into the given memory area
+ * Read the contents of the specified page into the given memory area, a page
+ * still waiting in the write-behind buffer is served from there
  */
-void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
+bool DiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  {
+    std::lock_guard<std::mutex> lck(stage_latch_);
+    auto it = staged_.find(page_id);
+    if (it != staged_.end()) {
+      memcpy(page_data, it->second.data(), page_size_);
+      return true;
+    }
+  }
+  return ReadPageRaw(page_id, page_data);
+}
+
+/**
+ * Write back every staged page and force the db file to stable storage,
+ * used at checkpoints in every durability mode
+ */
+void DiskManager::Sync() {
+  std::lock_guard<std::mutex> lck(stage_latch_);
+  if (!staged_.empty())
+    FlushStaged();
+  else
+    SyncFile();
+}
+
+/**
+ * Switch durability mode, pages staged so far are written out first
+ */
+void DiskManager::SetDurabilityMode(DurabilityMode durability) {
+  std::lock_guard<std::mutex> lck(stage_latch_);
+  if (!staged_.empty())
+    FlushStaged();
+  durability_ = durability;
+}
+
+/**
+ * Private helper function to write one page with pwrite
+ */
+void DiskManager::WritePageRaw(page_id_t page_id, const char *page_data) {
+  off_t offset = static_cast<off_t>(page_id) * page_size_;
+  size_t length = page_size_;
+  size_t stored = 0;
+  // the header page is read before the page map exists, never compress it
+  if (compress_ && page_id != HEADER_PAGE_ID) {
+    char *packed = GetBounceBuffer();
+    CompressedHeader header{COMPRESSED_MAGIC, 0, 0};
+    size_t packed_len =
+        PageCodec::Compress(page_data, page_size_, packed + sizeof(header),
+                            page_size_ - sizeof(header) - 1);
+    if (packed_len > 0) {
+      header.length_ = static_cast<uint16_t>(packed_len);
+      header.checksum_ = Crc32c(packed + sizeof(header), packed_len);
+      memcpy(packed, &header, sizeof(header));
+      stored = sizeof(header) + packed_len;
+      page_data = packed;
+      length = StoredBytes(stored);
+    }
+  }
+  if (stored == 0 && direct_io_ && !IsAligned(page_data)) {
+    char *bounce = GetBounceBuffer();
+    memcpy(bounce, page_data, page_size_);
+    page_data = bounce;
+  }
+  PageMapEntry entry{Crc32c(page_data, stored > 0 ? stored : page_size_),
+                     static_cast<uint16_t>(stored), PAGE_CHECKSUMMED};
+  // a compressed slot carries its own checksum, any other relies on the map
+  if (stored == 0)
+    ClearPageMapEntries({{page_id, entry}});
+  size_t written = 0;
+  // pwrite may return early, keep going until the whole page is out
+  while (written < length) {
+    ++num_write_calls_;
+    ssize_t rc = pwrite(db_fd_, page_data + written, length - written,
+                        offset + written);
+    if (rc < 0 && errno == EINTR)
+      continue;
+    // check for I/O error
+    if (rc <= 0) {
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    written += rc;
+  }
+  num_bytes_written_ += written;
+  SetPageMapEntries(page_id, &entry, 1);
+
+  // the rest of the slot is dead space
+  if (stored > 0 && punch_holes_ &&
+      fallocate(db_fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                offset + length, page_size_ - length) != 0) {
+    LOG_DEBUG("can't punch hole for page %d", page_id);
+  }
+}
+
+/**
+ * Private helper function to read one page with pread, false if its stored
+ * bytes do not match their checksum or do not decompress. The page map tells
+ * how much of the slot to read, the slot itself whether it holds a
+ * compressed page
+ */
+bool DiskManager::ReadPageRaw(page_id_t page_id, char *page_data) {
+  off_t offset = static_cast<off_t>(page_id) * page_size_;
   // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  struct stat stat_buf;
+  if (fstat(db_fd_, &stat_buf) != 0) {
     LOG_DEBUG("I/O error while reading");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    return false;
+  }
+  // a page never written reads as zeroes, like one past the end of a run
+  if (offset > stat_buf.st_size) {
+    memset(page_data, 0, page_size_);
+    return true;
+  }
+  PageMapEntry entry = GetPageMapEntry(page_id);
+  size_t length =
+      entry.stored_len_ > 0 ? StoredBytes(entry.stored_len_) : page_size_;
+  char *slot = page_data;
+  if (entry.stored_len_ > 0 || (direct_io_ && !IsAligned(page_data))) {
+    slot = GetBounceBuffer();
+  }
+  size_t read_count = ReadSlot(page_id, slot, length);
+  // the page was rewritten longer than the map says, e.g. before a crash
+  CompressedHeader header;
+  if (length < page_size_ && read_count >= sizeof(header) &&
+      GetCompressedHeader(slot, header) &&
+      sizeof(header) + header.length_ > read_count) {
+    read_count =
+        ReadSlot(page_id, slot, StoredBytes(sizeof(header) + header.length_));
+  }
+  return DecodeSlot(page_id, entry, slot, read_count, page_data);
+}
+
+/**
+ * Private helper function to read the first length bytes of a page's slot,
+ * returns the number of bytes read
+ */
+size_t DiskManager::ReadSlot(page_id_t page_id, char *buf, size_t length) {
+  off_t offset = static_cast<off_t>(page_id) * page_size_;
+  size_t read_count = 0;
+  while (read_count < length) {
+    ++num_read_calls_;
+    ssize_t rc = pread(db_fd_, buf + read_count, length - read_count,
+                       offset + read_count);
+    if (rc < 0 && errno == EINTR)
+      continue;
+    if (rc <= 0)
+      break;
+    read_count += rc;
+  }
+  num_bytes_read_ += read_count;
+  return read_count;
+}
+
+/**
+ * Private helper function to parse the header of a compressed page, false if
+ * the slot does not start with one
+ */
+bool DiskManager::GetCompressedHeader(const char *slot,
+                                      CompressedHeader &header) const {
+  memcpy(&header, slot, sizeof(header));
+  return header.magic_ == COMPRESSED_MAGIC &&
+         sizeof(header) + header.length_ < page_size_;
+}
+
+/**
+ * Private helper function to turn the read_count bytes read from a page's
+ * slot into the page in dest, which may be the slot itself. A slot holding an
+ * intact compressed page is decompressed whatever the page map says, as its
+ * entry may lag behind after a crash; any other slot is checked against the
+ * map's checksum, and fails if the map promised a compressed page
+ */
+bool DiskManager::DecodeSlot(page_id_t page_id, const PageMapEntry &entry,
+                             char *slot, size_t read_count, char *dest) {
+  CompressedHeader header;
+  if (read_count >= sizeof(header) && GetCompressedHeader(slot, header) &&
+      sizeof(header) + header.length_ <= read_count &&
+      Crc32c(slot + sizeof(header), header.length_) == header.checksum_) {
+    const char *packed = slot + sizeof(header);
+    if (slot == dest) {
+      char *copy = GetBounceBuffer();
+      memcpy(copy, packed, header.length_);
+      packed = copy;
+    }
+    if (PageCodec::Decompress(packed, header.length_, dest, page_size_))
+      return true;
+    LOG_DEBUG("Corrupted compressed page %d", page_id);
+    memset(dest, 0, page_size_);
+    return false;
+  }
+  if (entry.stored_len_ > 0) {
+    ++num_checksum_failures_;
+    LOG_DEBUG("Corrupted compressed page %d", page_id);
+    memset(dest, 0, page_size_);
+    return false;
+  }
+  // if file ends before reading a whole page
+  if (read_count < page_size_) {
+    LOG_DEBUG("Read less than a page");
+    memset(slot + read_count, 0, page_size_ - read_count);
+  }
+  bool intact = VerifyChecksum(page_id, entry, slot);
+  if (slot != dest)
+    memcpy(dest, slot, page_size_);
+  return intact;
+}
+
+/**
+ * Write many pages at once, adjacent pages share a single system call. In
+ * sync-each-write mode the whole batch is synced once, together with its
+ * page map entries
+ */
+void DiskManager::WritePages(
+    const std::vector<std::pair<page_id_t, char *>> &pages) {
+  if (durability_ == DurabilityMode::BATCHED) {
+    for (auto &page : pages)
+      WritePage(page.first, page.second);
+    return;
+  }
+  VectoredIO(true, pages);
+  if (durability_ == DurabilityMode::SYNC_EACH_WRITE && !pages.empty())
+    SyncFile();
+}
+
+/**
+ * Read many pages at once, adjacent pages share a single system call.
+ * Pages past the end of file read as zeroes
+ */
+bool DiskManager::ReadPages(
+    const std::vector<std::pair<page_id_t, char *>> &pages) {
+  std::vector<std::pair<page_id_t, char *>> unstaged;
+  {
+    std::lock_guard<std::mutex> lck(stage_latch_);
+    for (auto &page : pages) {
+      auto it = staged_.find(page.first);
+      if (it != staged_.end())
+        memcpy(page.second, it->second.data(), page_size_);
+      else
+        unstaged.push_back(page);
+    }
+  }
+  return VectoredIO(false, unstaged);
+}
+
+/**
+ * Queue an asynchronous page write, page_data must stay valid until the
+ * returned future is ready
+ */
+std::future<void> DiskManager::WritePageAsync(page_id_t page_id,
+                                              const char *page_data) {
+  std::vector<DiskRequest> requests;
+  requests.emplace_back(true, page_id, const_cast<char *>(page_data));
+  auto f = requests.back().callback_.get_future();
+  SubmitBatch(requests);
+  return f;
+}
+
+/**
+ * Queue an asynchronous page read, page_data must stay valid until the
+ * returned future is ready
+ */
+std::future<void> DiskManager::ReadPageAsync(page_id_t page_id,
+                                             char *page_data) {
+  std::vector<DiskRequest> requests;
+  requests.emplace_back(false, page_id, page_data);
+  auto f = requests.back().callback_.get_future();
+  SubmitBatch(requests);
+  return f;
+}
+
+/**
+ * Hand a batch of requests to the I/O workers under one acquisition of the
+ * queue latch. Requests are moved out of the vector, which is left empty.
+ */
+void DiskManager::SubmitBatch(std::vector<DiskRequest> &requests) {
+  {
+    std::lock_guard<std::mutex> lck(io_latch_);
+    for (auto &request : requests) {
+      io_queue_.push_back(std::move(request));
+    }
+  }
+  requests.clear();
+  io_cv_.notify_all();
+}
+
+/**
+ * Body of each I/O worker: serve queued requests until shutdown
+ */
+void DiskManager::IOWorker() {
+  std::unique_lock<std::mutex> lck(io_latch_);
+  while (true) {
+    io_cv_.wait(lck, [this] { return io_shutdown_ || !io_queue_.empty(); });
+    if (io_queue_.empty())
+      return; // shutdown and nothing left to do
+    DiskRequest request = std::move(io_queue_.front());
+    io_queue_.pop_front();
+    lck.unlock();
+    if (request.is_write_) {
+      WritePage(request.page_id_, request.page_data_);
+    } else {
+      ReadPage(request.page_id_, request.page_data_);
     }
+    request.callback_.set_value();
+    lck.lock();
   }
 }
 
@@ -158,16 +569,130 @@ bool DiskManager::ReadLog(char *log_data, int size, int offset) {
 
 /**
  * Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * With a hint the page comes from the extent of the object owning the hint
+ * page. Otherwise reuse the most recently freed page if there is one, or
+ * extend the file by bumping the page counter
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::AllocatePage(page_id_t hint_page_id) {
+  std::lock_guard<std::mutex> lck(alloc_latch_);
+  if (hint_page_id >= 0 && hint_page_id < next_page_id_) {
+    // a page outside any extent stands for its object until it gets one
+    size_t extent = hint_page_id / EXTENT_SIZE;
+    page_id_t owner = hint_page_id;
+    if (extent < extents_.size() && extents_[extent].owner_ != INVALID_PAGE_ID)
+      owner = extents_[extent].owner_;
+    return AllocateInExtent(owner);
+  }
+  if (free_pages_.empty())
+    return next_page_id_++;
+  page_id_t page_id = free_pages_.back();
+  free_pages_.pop_back();
+  SetFree(page_id, false);
+  return page_id;
+}
+
+/**
+ * A page is allocated if it lies below the page counter, is not marked free
+ * and, inside an extent, has been handed out of it
+ */
+bool DiskManager::IsAllocated(page_id_t page_id) {
+  std::lock_guard<std::mutex> lck(alloc_latch_);
+  if (page_id < 0 || page_id >= next_page_id_)
+    return false;
+  if (static_cast<size_t>(page_id / 8) < free_map_.size() &&
+      (free_map_[page_id / 8] & (1 << (page_id % 8))))
+    return false;
+  size_t extent = page_id / EXTENT_SIZE;
+  return extent >= extents_.size() ||
+         extents_[extent].owner_ == INVALID_PAGE_ID ||
+         page_id % EXTENT_SIZE < extents_[extent].used_;
+}
 
 /**
  * Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
+ * Mark the page free in the free-page map, and give its blocks back to the
+ * file system if hole punching is enabled
+ */
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  std::lock_guard<std::mutex> lck(alloc_latch_);
+  if (page_id < 0 || page_id >= next_page_id_)
+    return;
+  if (static_cast<size_t>(page_id / 8) < free_map_.size() &&
+      (free_map_[page_id / 8] & (1 << (page_id % 8))))
+    return; // already free
+  // the object page_id stood for is gone: the unused rest of its newest
+  // extent is freed and all its extents lose their owner, so that neither a
+  // hint into them nor the next object starting at page_id leads to it
+  auto it = owner_extent_.find(page_id);
+  if (it != owner_extent_.end()) {
+    ExtentInfo &info = extents_[it->second];
+    for (; info.used_ < EXTENT_SIZE; ++info.used_) {
+      page_id_t unused = it->second * EXTENT_SIZE + info.used_;
+      SetFree(unused, true);
+      free_pages_.push_back(unused);
+    }
+    owner_extent_.erase(it);
+    for (size_t extent = 0; extent < extents_.size(); ++extent) {
+      if (extents_[extent].owner_ == page_id) {
+        extents_[extent].owner_ = INVALID_PAGE_ID;
+        PersistExtent(extent);
+      }
+    }
+  }
+  SetFree(page_id, true);
+  free_pages_.push_back(page_id);
+  // a staged write of the page must not bring it back
+  {
+    std::lock_guard<std::mutex> stage_lck(stage_latch_);
+    staged_.erase(page_id);
+  }
+  // the contents are gone, so is their checksum
+  PageMapEntry entry{0, 0, 0};
+  SetPageMapEntries(page_id, &entry, 1);
+
+  if (punch_holes_ && db_fd_ >= 0 &&
+      fallocate(db_fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                static_cast<off_t>(page_id) * page_size_, page_size_) != 0) {
+    LOG_DEBUG("can't punch hole for page %d", page_id);
+  }
+}
+
+/**
+ * Undo an AllocatePage whose page was never used. The last page handed out of
+ * an extent goes back to it, any other page is deallocated
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-  return;
+void DiskManager::UnallocatePage(page_id_t page_id) {
+  {
+    std::lock_guard<std::mutex> lck(alloc_latch_);
+    size_t extent = page_id / EXTENT_SIZE;
+    if (page_id >= 0 && extent < extents_.size() &&
+        extents_[extent].owner_ != INVALID_PAGE_ID &&
+        page_id % EXTENT_SIZE == extents_[extent].used_ - 1) {
+      --extents_[extent].used_;
+      PersistExtent(extent);
+      return;
+    }
+  }
+  DeallocatePage(page_id);
+}
+
+/**
+ * Returns the object owning the extent page_id lies in, or INVALID_PAGE_ID
+ */
+page_id_t DiskManager::GetExtentOwner(page_id_t page_id) {
+  std::lock_guard<std::mutex> lck(alloc_latch_);
+  size_t extent = page_id / EXTENT_SIZE;
+  if (page_id < 0 || extent >= extents_.size())
+    return INVALID_PAGE_ID;
+  return extents_[extent].owner_;
+}
+
+/**
+ * Returns number of pages waiting to be reused
+ */
+size_t DiskManager::GetNumFreePages() {
+  std::lock_guard<std::mutex> lck(alloc_latch_);
+  return free_pages_.size();
 }
 
 /**
@@ -180,6 +705,450 @@ int DiskManager::GetNumFlushes() const { return num_flushes_; }
  */
 bool DiskManager::GetFlushState() const { return flush_log_; }
 
+/**
+ * Private helper function behind ReadPages/WritePages: sort the requests,
+ * then hand every run of consecutive page ids to preadv/pwritev. Unaligned
+ * buffers cannot take part in direct I/O and go through the single page path.
+ * A read returns false if any page failed its checksum
+ */
+bool DiskManager::VectoredIO(
+    bool is_write, const std::vector<std::pair<page_id_t, char *>> &pages) {
+  bool intact = true;
+  std::vector<std::pair<page_id_t, char *>> sorted;
+  sorted.reserve(pages.size());
+  for (auto &page : pages) {
+    // compressed pages have their own size, they cannot join a run
+    bool compressed = is_write ? compress_.load()
+                               : GetPageMapEntry(page.first).stored_len_ > 0;
+    if (compressed || (direct_io_ && !IsAligned(page.second))) {
+      if (is_write)
+        WritePageRaw(page.first, page.second);
+      else
+        intact = ReadPageRaw(page.first, page.second) && intact;
+    } else {
+      sorted.push_back(page);
+    }
+  }
+  std::sort(sorted.begin(), sorted.end());
+  std::vector<std::pair<page_id_t, PageMapEntry>> written;
+  if (is_write && !sorted.empty()) {
+    for (auto &page : sorted) {
+      written.emplace_back(page.first,
+                           PageMapEntry{Crc32c(page.second, page_size_), 0,
+                                        PAGE_CHECKSUMMED});
+    }
+    ClearPageMapEntries(written);
+  }
+
+  std::vector<struct iovec> iov;
+  std::vector<PageMapEntry> entries;
+  size_t begin = 0;
+  while (begin < sorted.size()) {
+    // collect a run of adjacent pages
+    iov.clear();
+    size_t end = begin;
+    while (end < sorted.size() && iov.size() < IOV_MAX &&
+           sorted[end].first ==
+               sorted[begin].first + static_cast<page_id_t>(end - begin)) {
+      iov.push_back({sorted[end].second, page_size_});
+      ++end;
+    }
+    off_t offset = static_cast<off_t>(sorted[begin].first) * page_size_;
+    size_t total = iov.size() * page_size_;
+    size_t done = 0;
+    struct iovec *cur = iov.data();
+    int count = iov.size();
+    ++num_vectored_ios_;
+    // the kernel may transfer less than asked, continue where it stopped
+    while (done < total) {
+      ++(is_write ? num_write_calls_ : num_read_calls_);
+      ssize_t rc = is_write ? pwritev(db_fd_, cur, count, offset + done)
+                            : preadv(db_fd_, cur, count, offset + done);
+      if (rc < 0 && errno == EINTR)
+        continue;
+      if (rc <= 0)
+        break;
+      done += rc;
+      while (count > 0 && static_cast<size_t>(rc) >= cur->iov_len) {
+        rc -= cur->iov_len;
+        ++cur;
+        --count;
+      }
+      if (count > 0) {
+        cur->iov_base = static_cast<char *>(cur->iov_base) + rc;
+        cur->iov_len -= rc;
+      }
+    }
+    (is_write ? num_bytes_written_ : num_bytes_read_) += done;
+    if (done < total) {
+      if (is_write) {
+        LOG_DEBUG("I/O error while writing");
+      } else {
+        // file ends inside the run
+        LOG_DEBUG("Read less than requested");
+        for (; count > 0; ++cur, --count)
+          memset(cur->iov_base, 0, cur->iov_len);
+      }
+    }
+
+    // checksums of a run are recorded with a single page map write
+    entries.clear();
+    for (size_t i = begin; i < end; ++i) {
+      if (is_write) {
+        entries.push_back(written[i].second);
+      } else {
+        intact = DecodeSlot(sorted[i].first, GetPageMapEntry(sorted[i].first),
+                            sorted[i].second, page_size_, sorted[i].second) &&
+                 intact;
+      }
+    }
+    if (is_write)
+      SetPageMapEntries(sorted[begin].first, entries.data(), entries.size());
+    begin = end;
+  }
+  return intact;
+}
+
+/**
+ * Private helper function to write out the write-behind buffer as one
+ * coalesced batch followed by a single fdatasync. Caller holds stage_latch_
+ */
+void DiskManager::FlushStaged() {
+  std::vector<std::pair<page_id_t, char *>> pages;
+  pages.reserve(staged_.size());
+  for (auto &page : staged_)
+    pages.emplace_back(page.first, page.second.data());
+  VectoredIO(true, pages);
+  SyncFile();
+  staged_.clear();
+}
+
+/**
+ * Private helper function to force written pages to stable storage, and the
+ * side files with them. The page map entries recorded before the db file is
+ * synced describe page writes that sync covers; they are written back once
+ * it is done, unless their page has been written again meanwhile, so a map
+ * entry never reaches the disk ahead of its page
+ */
+void DiskManager::SyncFile() {
+  ++num_syncs_;
+  auto entries = GetDirtyPageMapEntries();
+  if (fdatasync(db_fd_) != 0) {
+    LOG_DEBUG("fdatasync failed");
+  }
+  FlushPageMap(entries);
+  for (int fd : {pmap_fd_, fsm_fd_, ext_fd_}) {
+    if (fd >= 0 && fdatasync(fd) != 0) {
+      LOG_DEBUG("fdatasync of side file failed");
+    }
+  }
+}
+
+/**
+ * Private helper function to restore allocation state when the database is
+ * opened: pages past the end of the db file were never written, and the
+ * free-page map tells which of the others have been released
+ */
+void DiskManager::LoadFreeMap() {
+  struct stat stat_buf;
+  off_t db_size = (fstat(db_fd_, &stat_buf) == 0) ? stat_buf.st_size : 0;
+  next_page_id_ = (db_size + page_size_ - 1) / page_size_;
+
+  fsm_fd_ = open(fsm_name_.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fsm_fd_ < 0) {
+    LOG_DEBUG("can't open free-page map");
+    return;
+  }
+  // a new database must not inherit a stale map
+  if (db_size == 0 && ftruncate(fsm_fd_, 0) != 0) {
+    LOG_DEBUG("can't truncate free-page map");
+  }
+  free_map_.assign((next_page_id_ + 7) / 8, 0);
+  if (pread(fsm_fd_, free_map_.data(), free_map_.size(), 0) < 0) {
+    LOG_DEBUG("I/O error while reading free-page map");
+  }
+  for (page_id_t page_id = 0; page_id < next_page_id_; ++page_id) {
+    if (free_map_[page_id / 8] & (1 << (page_id % 8)))
+      free_pages_.push_back(page_id);
+  }
+}
+
+/**
+ * Private helper function to restore the page map, a new database must not
+ * inherit a stale one
+ */
+void DiskManager::LoadPageMap() {
+  pmap_fd_ = open(pmap_name_.c_str(), O_RDWR | O_CREAT, 0644);
+  if (pmap_fd_ < 0) {
+    LOG_DEBUG("can't open page map");
+    return;
+  }
+  if (next_page_id_ == 0 && ftruncate(pmap_fd_, 0) != 0) {
+    LOG_DEBUG("can't truncate page map");
+  }
+  struct stat stat_buf;
+  off_t pmap_size = (fstat(pmap_fd_, &stat_buf) == 0) ? stat_buf.st_size : 0;
+  page_map_.resize(pmap_size / sizeof(PageMapEntry));
+  if (pread(pmap_fd_, page_map_.data(), page_map_.size() * sizeof(PageMapEntry),
+            0) < 0) {
+    LOG_DEBUG("I/O error while reading page map");
+    page_map_.assign(page_map_.size(), PageMapEntry{0, 0, 0});
+  }
+  pmap_armed_.resize(page_map_.size());
+  for (size_t i = 0; i < page_map_.size(); ++i)
+    pmap_armed_[i] = page_map_[i].flags_ != 0 || page_map_[i].stored_len_ > 0;
+}
+
+/**
+ * Private helper function returning how a page is stored, an all-zero entry
+ * for pages never written
+ */
+DiskManager::PageMapEntry DiskManager::GetPageMapEntry(page_id_t page_id) {
+  std::lock_guard<std::mutex> lck(pmap_latch_);
+  if (page_id < 0 || static_cast<size_t>(page_id) >= page_map_.size())
+    return PageMapEntry{0, 0, 0};
+  return page_map_[page_id];
+}
+
+/**
+ * Private helper function to record how count adjacent pages starting at
+ * first were stored; changed entries are written back by FlushPageMap
+ */
+void DiskManager::SetPageMapEntries(page_id_t first,
+                                    const PageMapEntry *entries,
+                                    size_t count) {
+  std::lock_guard<std::mutex> lck(pmap_latch_);
+  if (first + count > page_map_.size()) {
+    page_map_.resize(first + count, PageMapEntry{0, 0, 0});
+    pmap_armed_.resize(first + count);
+  }
+  for (size_t i = 0; i < count; ++i) {
+    if (memcmp(&page_map_[first + i], &entries[i], sizeof(PageMapEntry)) != 0) {
+      page_map_[first + i] = entries[i];
+      pmap_dirty_.insert(first + static_cast<page_id_t>(i));
+    }
+  }
+}
+
+/**
+ * Private helper function to forget the checksums of pages about to be
+ * overwritten as is, given with the entries of their new contents. Entries on
+ * disk that would check the slots are cleared and synced first, one write per
+ * run of adjacent ones, so that neither the old nor the new version of a page
+ * fails its check after a crash. Pages rewritten with the contents they had
+ * at the last sync keep their entries
+ */
+void DiskManager::ClearPageMapEntries(
+    const std::vector<std::pair<page_id_t, PageMapEntry>> &pages) {
+  std::lock_guard<std::mutex> lck(pmap_latch_);
+  std::vector<page_id_t> armed;
+  for (auto &page : pages) {
+    page_id_t page_id = page.first;
+    if (static_cast<size_t>(page_id) >= page_map_.size())
+      continue; // never recorded, nothing on disk either
+    if (pmap_armed_[page_id] && pmap_dirty_.count(page_id) == 0 &&
+        memcmp(&page_map_[page_id], &page.second, sizeof(PageMapEntry)) == 0)
+      continue; // the entry on disk checks both versions
+    page_map_[page_id] = PageMapEntry{0, 0, 0};
+    pmap_dirty_.insert(page_id);
+    if (pmap_armed_[page_id]) {
+      pmap_armed_[page_id] = false;
+      armed.push_back(page_id);
+    }
+  }
+  if (armed.empty() || pmap_fd_ < 0)
+    return;
+  std::sort(armed.begin(), armed.end());
+  for (size_t begin = 0, end; begin < armed.size(); begin = end) {
+    for (end = begin + 1;
+         end < armed.size() && armed[end] == armed[end - 1] + 1; ++end) {
+    }
+    ++num_write_calls_;
+    ssize_t length = (end - begin) * sizeof(PageMapEntry);
+    if (pwrite(pmap_fd_, &page_map_[armed[begin]], length,
+               armed[begin] * sizeof(PageMapEntry)) != length) {
+      LOG_DEBUG("I/O error while writing page map");
+    }
+  }
+  if (fdatasync(pmap_fd_) != 0) {
+    LOG_DEBUG("fdatasync of page map failed");
+  }
+}
+
+/**
+ * Private helper function to take the changed page map entries, in page id
+ * order, before the db file is synced
+ */
+std::vector<std::pair<page_id_t, DiskManager::PageMapEntry>>
+DiskManager::GetDirtyPageMapEntries() {
+  std::lock_guard<std::mutex> lck(pmap_latch_);
+  std::vector<std::pair<page_id_t, PageMapEntry>> entries;
+  entries.reserve(pmap_dirty_.size());
+  for (page_id_t page_id : pmap_dirty_)
+    entries.emplace_back(page_id, page_map_[page_id]);
+  return entries;
+}
+
+/**
+ * Private helper function to write back page map entries taken before the
+ * last sync of the db file, one call per run of adjacent ones. Entries that
+ * changed since are left for the next sync: their page may have been written
+ * again after the sync
+ */
+void DiskManager::FlushPageMap(
+    const std::vector<std::pair<page_id_t, PageMapEntry>> &entries) {
+  std::lock_guard<std::mutex> lck(pmap_latch_);
+  std::vector<page_id_t> synced;
+  for (auto &entry : entries) {
+    if (memcmp(&page_map_[entry.first], &entry.second, sizeof(PageMapEntry)) ==
+        0) {
+      synced.push_back(entry.first);
+      pmap_dirty_.erase(entry.first);
+      pmap_armed_[entry.first] =
+          entry.second.flags_ != 0 || entry.second.stored_len_ > 0;
+    }
+  }
+  for (size_t begin = 0, end; begin < synced.size(); begin = end) {
+    for (end = begin + 1;
+         end < synced.size() && synced[end] == synced[end - 1] + 1; ++end) {
+    }
+    if (pmap_fd_ < 0)
+      continue;
+    ++num_write_calls_;
+    ssize_t length = (end - begin) * sizeof(PageMapEntry);
+    if (pwrite(pmap_fd_, &page_map_[synced[begin]], length,
+               synced[begin] * sizeof(PageMapEntry)) != length) {
+      LOG_DEBUG("I/O error while writing page map");
+    }
+  }
+}
+
+/**
+ * Private helper function to check a page stored as is against the checksum
+ * recorded when it was written, false on a mismatch. Compressed pages carry
+ * their checksum in their header
+ */
+bool DiskManager::VerifyChecksum(page_id_t page_id, const PageMapEntry &entry,
+                                 const char *stored_data) {
+  if (!(entry.flags_ & PAGE_CHECKSUMMED))
+    return true;
+  if (Crc32c(stored_data, page_size_) != entry.checksum_) {
+    ++num_checksum_failures_;
+    LOG_DEBUG("Checksum mismatch on page %d", page_id);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Private helper function giving the bytes transferred for a compressed page,
+ * direct I/O needs whole aligned blocks
+ */
+size_t DiskManager::StoredBytes(size_t stored) const {
+  if (!direct_io_)
+    return stored;
+  return (stored + DIRECT_IO_ALIGNMENT - 1) / DIRECT_IO_ALIGNMENT *
+         DIRECT_IO_ALIGNMENT;
+}
+
+/**
+ * Private helper function to restore extent owners, the end of the last
+ * extent bounds the page counter even if its space was never written
+ */
+void DiskManager::LoadExtentMap() {
+  ext_fd_ = open(ext_name_.c_str(), O_RDWR | O_CREAT, 0644);
+  if (ext_fd_ < 0) {
+    LOG_DEBUG("can't open extent map");
+    return;
+  }
+  if (next_page_id_ == 0 && ftruncate(ext_fd_, 0) != 0) {
+    LOG_DEBUG("can't truncate extent map");
+  }
+  struct stat stat_buf;
+  off_t ext_size = (fstat(ext_fd_, &stat_buf) == 0) ? stat_buf.st_size : 0;
+  extents_.resize(ext_size / sizeof(ExtentInfo));
+  if (pread(ext_fd_, extents_.data(), extents_.size() * sizeof(ExtentInfo),
+            0) < 0) {
+    LOG_DEBUG("I/O error while reading extent map");
+    extents_.clear();
+  }
+  for (size_t extent = 0; extent < extents_.size(); ++extent) {
+    // extents of dropped objects keep their fill level but have no owner
+    if (extents_[extent].owner_ != INVALID_PAGE_ID)
+      owner_extent_[extents_[extent].owner_] = extent;
+    else if (extents_[extent].used_ == 0)
+      continue;
+    page_id_t extent_end = (extent + 1) * EXTENT_SIZE;
+    if (next_page_id_ < extent_end)
+      next_page_id_ = extent_end;
+  }
+}
+
+/**
+ * Private helper function to hand out the next page of owner's newest extent,
+ * reserving a fresh extent at the end of the file when it is full. Pages
+ * skipped to align the extent go to the free list. Caller holds alloc_latch_
+ */
+page_id_t DiskManager::AllocateInExtent(page_id_t owner) {
+  auto it = owner_extent_.find(owner);
+  if (it == owner_extent_.end() || extents_[it->second].used_ == EXTENT_SIZE) {
+    page_id_t start =
+        (next_page_id_ + EXTENT_SIZE - 1) / EXTENT_SIZE * EXTENT_SIZE;
+    for (page_id_t page_id = next_page_id_; page_id < start; ++page_id) {
+      SetFree(page_id, true);
+      free_pages_.push_back(page_id);
+    }
+    next_page_id_ = start + EXTENT_SIZE;
+    // reserve the space up front so the extent is contiguous on disk
+    if (db_fd_ >= 0 &&
+        fallocate(db_fd_, 0, static_cast<off_t>(start) * page_size_,
+                  EXTENT_SIZE * page_size_) != 0) {
+      LOG_DEBUG("can't preallocate extent at page %d", start);
+    }
+    size_t extent = start / EXTENT_SIZE;
+    while (extents_.size() < extent) {
+      extents_.push_back(ExtentInfo{INVALID_PAGE_ID, 0});
+      PersistExtent(extents_.size() - 1);
+    }
+    extents_.resize(extent + 1);
+    extents_[extent] = ExtentInfo{owner, 0};
+    it = owner_extent_.insert({owner, extent}).first;
+    it->second = extent;
+  }
+  size_t extent = it->second;
+  page_id_t page_id = extent * EXTENT_SIZE + extents_[extent].used_++;
+  PersistExtent(extent);
+  return page_id;
+}
+
+/**
+ * Private helper function to write back the entry of one extent
+ */
+void DiskManager::PersistExtent(size_t extent) {
+  if (ext_fd_ >= 0 &&
+      pwrite(ext_fd_, &extents_[extent], sizeof(ExtentInfo),
+             extent * sizeof(ExtentInfo)) != sizeof(ExtentInfo)) {
+    LOG_DEBUG("I/O error while writing extent map");
+  }
+}
+
+/**
+ * Private helper function to flip the bit of one page in the free-page map,
+ * only the byte holding it is written back. Caller holds alloc_latch_
+ */
+void DiskManager::SetFree(page_id_t page_id, bool is_free) {
+  size_t index = page_id / 8;
+  if (index >= free_map_.size())
+    free_map_.resize(index + 1, 0);
+  if (is_free)
+    free_map_[index] |= (1 << (page_id % 8));
+  else
+    free_map_[index] &= ~(1 << (page_id % 8));
+  if (fsm_fd_ >= 0 && pwrite(fsm_fd_, &free_map_[index], 1, index) != 1) {
+    LOG_DEBUG("I/O error while writing free-page map");
+  }
+}
+
 /**
  * Private helper function to get disk file size
  */
@@ -0,0 +1,86 @@
+/**
+ * memory_disk_manager.cpp
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "disk/memory_disk_manager.h"
+
+namespace scudb {
+
+MemoryDiskManager::MemoryDiskManager(size_t page_size)
+    : DiskManager(page_size) {
+  StartIOWorkers();
+}
+
+MemoryDiskManager::~MemoryDiskManager() {
+  // queued requests still need the pages
+  StopIOWorkers();
+}
+
+void MemoryDiskManager::WritePage(page_id_t page_id, const char *page_data) {
+  std::lock_guard<std::mutex> lck(latch_);
+  if (static_cast<size_t>(page_id) >= pages_.size())
+    pages_.resize(page_id + 1);
+  if (pages_[page_id] == nullptr)
+    pages_[page_id].reset(new char[page_size_]);
+  memcpy(pages_[page_id].get(), page_data, page_size_);
+  ++num_write_calls_;
+  num_bytes_written_ += page_size_;
+}
+
+/**
+ * Pages never written read as zeroes
+ */
+bool MemoryDiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  std::lock_guard<std::mutex> lck(latch_);
+  if (static_cast<size_t>(page_id) < pages_.size() &&
+      pages_[page_id] != nullptr) {
+    memcpy(page_data, pages_[page_id].get(), page_size_);
+  } else {
+    memset(page_data, 0, page_size_);
+  }
+  ++num_read_calls_;
+  num_bytes_read_ += page_size_;
+  return true;
+}
+
+void MemoryDiskManager::WritePages(
+    const std::vector<std::pair<page_id_t, char *>> &pages) {
+  for (auto &page : pages)
+    MemoryDiskManager::WritePage(page.first, page.second);
+}
+
+bool MemoryDiskManager::ReadPages(
+    const std::vector<std::pair<page_id_t, char *>> &pages) {
+  for (auto &page : pages)
+    MemoryDiskManager::ReadPage(page.first, page.second);
+  return true;
+}
+
+void MemoryDiskManager::WriteLog(char *log_data, int size) {
+  if (size == 0) // no effect on num_flushes_ if log buffer is empty
+    return;
+  std::lock_guard<std::mutex> lck(latch_);
+  flush_log_ = true;
+  num_flushes_ += 1;
+  log_.insert(log_.end(), log_data, log_data + size);
+  flush_log_ = false;
+}
+
+/**
+ * Same contract as the file backend: false once offset reaches the end of
+ * the log, a short read is padded with zeroes
+ */
+bool MemoryDiskManager::ReadLog(char *log_data, int size, int offset) {
+  std::lock_guard<std::mutex> lck(latch_);
+  if (offset >= static_cast<int>(log_.size()))
+    return false;
+  int read_count = std::min<int>(size, log_.size() - offset);
+  memcpy(log_data, log_.data() + offset, read_count);
+  memset(log_data + read_count, 0, size - read_count);
+  return true;
+}
+
+} // namespace scudb
@@ -0,0 +1,159 @@
+/**
+ * page_codec.cpp
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "disk/page_codec.h"
+
+namespace scudb {
+
+static const size_t MIN_MATCH = 4;      // shortest back reference
+static const size_t MAX_OFFSET = 65535; // farthest back reference
+static const int HASH_BITS = 12;        // size of the match finder table
+
+static inline uint32_t Read32(const uint8_t *ptr) {
+  uint32_t value;
+  memcpy(&value, ptr, sizeof(value));
+  return value;
+}
+
+/**
+ * Append the part of a length that did not fit into its nibble
+ */
+static bool PutLength(uint8_t *&op, const uint8_t *oend, size_t len) {
+  for (; len >= 255; len -= 255) {
+    if (op >= oend)
+      return false;
+    *op++ = 255;
+  }
+  if (op >= oend)
+    return false;
+  *op++ = static_cast<uint8_t>(len);
+  return true;
+}
+
+static bool GetLength(const uint8_t *&ip, const uint8_t *iend, size_t &len) {
+  uint8_t byte;
+  do {
+    if (ip >= iend)
+      return false;
+    byte = *ip++;
+    len += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/**
+ * Append one sequence, a match_len of 0 ends the stream with literals only
+ */
+static bool PutSequence(uint8_t *&op, const uint8_t *oend, const uint8_t *lit,
+                        size_t lit_len, size_t offset, size_t match_len) {
+  if (op >= oend)
+    return false;
+  uint8_t *token = op++;
+  *token = static_cast<uint8_t>(std::min<size_t>(lit_len, 15) << 4);
+  if (lit_len >= 15 && !PutLength(op, oend, lit_len - 15))
+    return false;
+  if (static_cast<size_t>(oend - op) < lit_len)
+    return false;
+  memcpy(op, lit, lit_len);
+  op += lit_len;
+  if (match_len == 0)
+    return true;
+
+  if (oend - op < 2)
+    return false;
+  *op++ = static_cast<uint8_t>(offset & 0xff);
+  *op++ = static_cast<uint8_t>(offset >> 8);
+  match_len -= MIN_MATCH;
+  *token |= static_cast<uint8_t>(std::min<size_t>(match_len, 15));
+  return match_len < 15 || PutLength(op, oend, match_len - 15);
+}
+
+/**
+ * Greedy compression: a hash of the next four bytes finds the last position
+ * they occurred at, a hit is extended as far as the input matches
+ */
+size_t PageCodec::Compress(const char *src, size_t src_len, char *dst,
+                           size_t dst_cap) {
+  const uint8_t *in = reinterpret_cast<const uint8_t *>(src);
+  uint8_t *op = reinterpret_cast<uint8_t *>(dst);
+  const uint8_t *oend = op + dst_cap;
+  // position + 1 of the last occurrence of each hash, 0 if none
+  uint32_t table[1 << HASH_BITS] = {0};
+
+  size_t anchor = 0, pos = 0;
+  while (pos + MIN_MATCH <= src_len) {
+    uint32_t sequence = Read32(in + pos);
+    uint32_t hash = (sequence * 2654435761u) >> (32 - HASH_BITS);
+    size_t candidate = table[hash];
+    table[hash] = pos + 1;
+    if (candidate == 0 || pos - (candidate - 1) > MAX_OFFSET ||
+        Read32(in + candidate - 1) != sequence) {
+      ++pos;
+      continue;
+    }
+    size_t ref = candidate - 1;
+    size_t len = MIN_MATCH;
+    while (pos + len < src_len && in[ref + len] == in[pos + len])
+      ++len;
+    if (!PutSequence(op, oend, in + anchor, pos - anchor, pos - ref, len))
+      return 0;
+    pos += len;
+    anchor = pos;
+  }
+  if (!PutSequence(op, oend, in + anchor, src_len - anchor, 0, 0))
+    return 0;
+  return op - reinterpret_cast<uint8_t *>(dst);
+}
+
+/**
+ * Decompression checks every length and offset against both buffers, so a
+ * damaged page is reported instead of overrunning memory
+ */
+bool PageCodec::Decompress(const char *src, size_t src_len, char *dst,
+                           size_t dst_len) {
+  const uint8_t *ip = reinterpret_cast<const uint8_t *>(src);
+  const uint8_t *iend = ip + src_len;
+  uint8_t *op = reinterpret_cast<uint8_t *>(dst);
+  uint8_t *const ostart = op;
+  const uint8_t *oend = op + dst_len;
+
+  while (ip < iend) {
+    uint8_t token = *ip++;
+    size_t lit_len = token >> 4;
+    if (lit_len == 15 && !GetLength(ip, iend, lit_len))
+      return false;
+    if (static_cast<size_t>(iend - ip) < lit_len ||
+        static_cast<size_t>(oend - op) < lit_len)
+      return false;
+    memcpy(op, ip, lit_len);
+    ip += lit_len;
+    op += lit_len;
+    if (ip == iend)
+      break; // last sequence
+
+    if (iend - ip < 2)
+      return false;
+    size_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    size_t match_len = token & 15;
+    if (match_len == 15 && !GetLength(ip, iend, match_len))
+      return false;
+    match_len += MIN_MATCH;
+    if (offset == 0 || offset > static_cast<size_t>(op - ostart) ||
+        static_cast<size_t>(oend - op) < match_len)
+      return false;
+    // byte by byte, the match may overlap the bytes it produces
+    const uint8_t *ref = op - offset;
+    for (size_t i = 0; i < match_len; ++i)
+      op[i] = ref[i];
+    op += match_len;
+  }
+  return op == oend;
+}
+
+} // namespace scudb
@@ -0,0 +1,92 @@
+/**
+ * simulated_disk_manager.cpp
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "disk/simulated_disk_manager.h"
+
+namespace scudb {
+
+SimulatedDiskManager::SimulatedDiskManager(const DeviceProfile &profile,
+                                           size_t page_size,
+                                           bool inject_delay)
+    : MemoryDiskManager(page_size), profile_(profile),
+      inject_delay_(inject_delay), simulated_ns_(0),
+      head_page_id_(INVALID_PAGE_ID) {}
+
+void SimulatedDiskManager::WritePage(page_id_t page_id,
+                                     const char *page_data) {
+  Charge(true, page_id, 1);
+  MemoryDiskManager::WritePage(page_id, page_data);
+}
+
+bool SimulatedDiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  Charge(false, page_id, 1);
+  return MemoryDiskManager::ReadPage(page_id, page_data);
+}
+
+/**
+ * Like the file backend, runs of adjacent pages cost a single request
+ */
+void SimulatedDiskManager::WritePages(
+    const std::vector<std::pair<page_id_t, char *>> &pages) {
+  ForEachRun(pages, true, [this](page_id_t page_id, char *page_data) {
+    MemoryDiskManager::WritePage(page_id, page_data);
+  });
+}
+
+bool SimulatedDiskManager::ReadPages(
+    const std::vector<std::pair<page_id_t, char *>> &pages) {
+  ForEachRun(pages, false, [this](page_id_t page_id, char *page_data) {
+    MemoryDiskManager::ReadPage(page_id, page_data);
+  });
+  return true;
+}
+
+template <typename F>
+void SimulatedDiskManager::ForEachRun(
+    const std::vector<std::pair<page_id_t, char *>> &pages, bool is_write,
+    F io) {
+  std::vector<std::pair<page_id_t, char *>> sorted(pages);
+  std::sort(sorted.begin(), sorted.end());
+  size_t begin = 0;
+  while (begin < sorted.size()) {
+    size_t end = begin + 1;
+    while (end < sorted.size() &&
+           sorted[end].first ==
+               sorted[begin].first + static_cast<page_id_t>(end - begin))
+      ++end;
+    Charge(is_write, sorted[begin].first, end - begin);
+    for (size_t i = begin; i < end; ++i)
+      io(sorted[i].first, sorted[i].second);
+    begin = end;
+  }
+}
+
+/**
+ * Account one request for num_pages adjacent pages on the simulated clock
+ */
+void SimulatedDiskManager::Charge(bool is_write, page_id_t first_page_id,
+                                  size_t num_pages) {
+  double latency_us;
+  {
+    std::lock_guard<std::mutex> lck(device_latch_);
+    if (first_page_id == head_page_id_)
+      latency_us = profile_.sequential_latency_us_;
+    else
+      latency_us =
+          is_write ? profile_.write_latency_us_ : profile_.read_latency_us_;
+    head_page_id_ = first_page_id + num_pages;
+  }
+  // MB/s is bytes per microsecond
+  double us = latency_us + num_pages * page_size_ / profile_.bandwidth_mb_s_;
+  simulated_ns_ += static_cast<uint64_t>(us * 1000);
+  if (inject_delay_)
+    std::this_thread::sleep_for(std::chrono::nanoseconds(
+        static_cast<int64_t>(us * 1000)));
+}
+
+} // namespace scudb
@@ -0,0 +1,144 @@
+#include <cassert>
+#include <functional>
+#include <vector>
+
+#include "hash/lock_free_hash.h"
+#include "page/page.h"
+
+namespace scudb {
+
+/*
+ * constructor
+ * capacity is a power of two of at least twice max_entries, so probe
+ * sequences stay short
+ */
+template <typename K, typename V>
+LockFreeHash<K, V>::LockFreeHash(size_t max_entries, const K &empty_key,
+                                 const K &deleted_key)
+    : max_entries_(max_entries), empty_key_(empty_key),
+      deleted_key_(deleted_key), num_entries_(0), num_used_(0) {
+  size_t capacity = 8;
+  while (capacity < 2 * max_entries) {
+    capacity <<= 1;
+  }
+  mask_ = capacity - 1;
+  slots_.reset(new Slot[capacity]);
+  for (size_t i = 0; i < capacity; ++i) {
+    slots_[i].key.store(empty_key_, std::memory_order_relaxed);
+    slots_[i].value.store(V(), std::memory_order_relaxed);
+  }
+}
+
+/*
+ * helper function to calculate the slot of input key, a multiplicative hash
+ * spreads consecutive keys such as page ids
+ */
+template <typename K, typename V>
+size_t LockFreeHash<K, V>::HashKey(const K &key) const {
+  return (std::hash<K>{}(key) * 0x9E3779B97F4A7C15ull >> 16) & mask_;
+}
+
+/*
+ * lookup function to find value associate with input key. The key is read
+ * again after the value: writers store the value before publishing the key,
+ * so an unchanged key means the value belongs to it
+ */
+template <typename K, typename V>
+bool LockFreeHash<K, V>::Find(const K &key, V &value) {
+  for (size_t i = HashKey(key), n = 0; n <= mask_; i = (i + 1) & mask_, ++n) {
+    K cur = slots_[i].key.load();
+    if (cur == empty_key_) {
+      return false;
+    }
+    if (cur == key) {
+      V found = slots_[i].value.load();
+      if (slots_[i].key.load() != key) {
+        return false;
+      }
+      value = found;
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * delete <key,value> entry in hash table, the slot becomes a tombstone so
+ * that probe sequences running through it stay intact
+ * Shrink & Combination is not required for this project
+ */
+template <typename K, typename V>
+bool LockFreeHash<K, V>::Remove(const K &key) {
+  for (size_t i = HashKey(key), n = 0; n <= mask_; i = (i + 1) & mask_, ++n) {
+    K cur = slots_[i].key.load(std::memory_order_relaxed);
+    if (cur == empty_key_) {
+      return false;
+    }
+    if (cur == key) {
+      slots_[i].key.store(deleted_key_);
+      --num_entries_;
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * insert <key,value> entry in hash table, overwriting an existing value.
+ * Tombstones are reused; when live keys plus tombstones fill three quarters
+ * of the table the tombstones are purged first
+ */
+template <typename K, typename V>
+void LockFreeHash<K, V>::Insert(const K &key, const V &value) {
+  size_t reuse = mask_ + 1;
+  for (size_t i = HashKey(key), n = 0; n <= mask_; i = (i + 1) & mask_, ++n) {
+    K cur = slots_[i].key.load(std::memory_order_relaxed);
+    if (cur == key) {
+      // readers see either the old or the new value, both mapped to key
+      slots_[i].value.store(value);
+      return;
+    }
+    if (cur == deleted_key_ && reuse > mask_) {
+      reuse = i;
+    } else if (cur == empty_key_) {
+      if (reuse > mask_) {
+        if ((num_used_ + 1) * 4 > (mask_ + 1) * 3) {
+          PurgeDeleted();
+          Insert(key, value);
+          return;
+        }
+        reuse = i;
+        ++num_used_;
+      }
+      break;
+    }
+  }
+  assert(reuse <= mask_ && num_entries_ < max_entries_);
+  slots_[reuse].value.store(value);
+  slots_[reuse].key.store(key);
+  ++num_entries_;
+}
+
+/*
+ * rebuild the table without tombstones. Concurrent readers may miss keys
+ * while this runs, which callers that retry under the writer's lock accept
+ */
+template <typename K, typename V> void LockFreeHash<K, V>::PurgeDeleted() {
+  std::vector<std::pair<K, V>> live;
+  for (size_t i = 0; i <= mask_; ++i) {
+    K cur = slots_[i].key.load(std::memory_order_relaxed);
+    if (cur != empty_key_ && cur != deleted_key_) {
+      live.emplace_back(cur, slots_[i].value.load(std::memory_order_relaxed));
+    }
+    slots_[i].key.store(empty_key_);
+  }
+  num_entries_ = num_used_ = 0;
+  for (auto &entry : live) {
+    Insert(entry.first, entry.second);
+  }
+}
+
+template class LockFreeHash<page_id_t, Page *>;
+// test purpose
+template class LockFreeHash<int, int>;
+} // namespace scudb
@@ -0,0 +1,66 @@
+/**
+ * arc_replacer.h
+ *
+ * Adaptive replacement cache (Megiddo and Modha). Resident values are split
+ * into T1, seen once recently, and T2, seen at least twice; both are LRU
+ * lists. Keys evicted from them are remembered in the ghost lists B1 and B2.
+ * A new value whose key is in B1 means T1 was too small, one in B2 that T2
+ * was, and the target size p of T1 moves accordingly; such values go
+ * straight to T2. Victims come from T1 while it is larger than p, else from
+ * T2, so the split between recency and frequency follows the workload.
+ *
+ * As in TwoQReplacer, Erase only makes a value ineligible and a value
+ * inserted under a new key starts over.
+ */
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "buffer/ghost_list.h"
+#include "buffer/replacer.h"
+
+namespace scudb {
+
+template <typename T> class ARCReplacer : public Replacer<T> {
+  struct Entry {
+    int64_t key_;
+    bool frequent_;  // in T2 rather than T1
+    bool evictable_; // false while erased
+    typename std::list<T>::iterator pos_;
+  };
+
+public:
+  // capacity is the number of frames of the pool
+  explicit ARCReplacer(size_t capacity);
+  ~ARCReplacer();
+
+  void Insert(const T &value) override;
+  bool Victim(T &value) override;
+  bool Erase(const T &value) override;
+  size_t Size() override;
+  void PeekVictims(std::vector<T> &values, size_t max_count) override;
+
+  // current target size of T1, for tests
+  size_t GetTarget();
+
+private:
+  typename std::list<T>::iterator
+  NextEvictable(std::list<T> &list, typename std::list<T>::iterator it);
+  // bound B1 by what T1 leaves of capacity_, and all lists by 2 capacity_
+  void TrimGhosts();
+
+  size_t capacity_;
+  size_t target_; // p, the size T1 should have
+  size_t size_;   // eligible values
+  std::list<T> t1_;
+  std::list<T> t2_;
+  std::unordered_map<T, Entry> entries_;
+  GhostList b1_;
+  GhostList b2_;
+  std::mutex latch_;
+};
+
+} // namespace scudb
@@ -0,0 +1,53 @@
+/**
+ * array_lru_replacer.h
+ *
+ * An LRU replacer for a fixed set of values, such as the frames of a buffer
+ * pool. Every value owns a slot in an array preallocated by the constructor,
+ * and the LRU list is threaded through those slots by index, so Insert,
+ * Victim and Erase take constant time and never allocate. Values must be
+ * first, first + 1, ..., first + capacity - 1: frame pointers into the
+ * pool's page array, or small integers.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "buffer/replacer.h"
+
+namespace scudb {
+
+template <typename T> class ArrayLRUReplacer : public Replacer<T> {
+  struct Node {
+    uint32_t prev_;
+    uint32_t next_;
+    bool linked_;
+  };
+
+public:
+  explicit ArrayLRUReplacer(size_t capacity, T first = T());
+  ~ArrayLRUReplacer();
+
+  void Insert(const T &value) override;
+  bool Victim(T &value) override;
+  bool Erase(const T &value) override;
+  size_t Size() override;
+  void PeekVictims(std::vector<T> &values, size_t max_count) override;
+
+private:
+  inline uint32_t IndexOf(const T &value) const {
+    return static_cast<uint32_t>(value - first_);
+  }
+  void Unlink(uint32_t index);
+
+  T first_;
+  uint32_t head_; // index of the list head, after the last value's slot
+  size_t size_;
+  // most recently used first from the head's next_, one slot per value
+  std::vector<Node> nodes_;
+  std::mutex latch_;
+};
+
+} // namespace scudb
@@ -0,0 +1,53 @@
+/**
+ * buffer_access_strategy.h
+ *
+ * A buffer access strategy lets a large scan cycle through a small private
+ * ring of frames instead of the whole buffer pool, as PostgreSQL does for
+ * bulk reads. Pages the scan misses are loaded into frames of its ring; once
+ * the ring is full, the frame of the oldest ring page is reused if no one
+ * pins it. A ring takes at most an eighth of a pool's frames. Ring frames
+ * stay out of the replacer while the strategy lives, so a scan never pushes
+ * other pages toward eviction. A ring page fetched by another reader leaves
+ * the ring and becomes an ordinary page. Destroying the strategy hands its
+ * frames back to the replacer.
+ *
+ * One strategy serves one scan and must not outlive the buffer pool.
+ */
+
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+
+namespace scudb {
+
+class BufferPoolManager;
+class Page;
+
+class BufferAccessStrategy {
+public:
+  explicit BufferAccessStrategy(size_t ring_size = SCAN_RING_SIZE);
+  ~BufferAccessStrategy();
+
+  inline size_t GetRingSize() const { return ring_size_; }
+  // misses served by reusing a frame of the ring
+  inline uint64_t GetNumReused() const { return num_reused_; }
+
+private:
+  friend class BufferPoolManager;
+  struct Ring {
+    std::vector<Page *> frames_;
+    size_t next_ = 0; // oldest frame once the ring is full
+  };
+
+  size_t ring_size_;
+  // one ring per buffer pool instance the scan went through
+  std::unordered_map<BufferPoolManager *, Ring> rings_;
+  std::mutex latch_;
+  std::atomic<uint64_t> num_reused_;
+};
+
+} // namespace scudb
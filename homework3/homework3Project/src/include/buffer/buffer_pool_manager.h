@@ -7,45 +7,239 @@
  */
 
 #pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
 #include <list>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
+#include "buffer/array_lru_replacer.h"
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffered_replacer.h"
+#include "buffer/compressed_page_cache.h"
+#include "buffer/frame_arena.h"
+#include "buffer/page_guard.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/replacer_factory.h"
 #include "disk/disk_manager.h"
-#include "hash/extendible_hash.h"
+#include "hash/lock_free_hash.h"
 #include "logging/log_manager.h"
 #include "page/page.h"
 
 namespace scudb {
+
+// what a FlushAllPages wrote and how long it took
+struct FlushStats {
+  size_t num_pages_ = 0;
+  // runs of adjacent pages handed to the disk manager, each one write
+  size_t num_runs_ = 0;
+  size_t num_bytes_ = 0;
+  double elapsed_ms_ = 0; // including the final sync
+};
+
 class BufferPoolManager {
 public:
+  // memory chooses how frames are backed; a NUMA-aware pool splits them over
+  // the memory nodes and hands out frames local to the calling thread first.
+  // The pool may grow to max_pool_size frames, at least pool_size, see Resize
   BufferPoolManager(size_t pool_size, DiskManager *disk_manager,
-                          LogManager *log_manager = nullptr);
+                    LogManager *log_manager = nullptr,
+                    ReplacerPolicy policy = ReplacerPolicy::LRU,
+                    FrameMemory memory = FrameMemory::DEFAULT,
+                    bool numa_aware = false, size_t max_pool_size = 0);
+
+  virtual ~BufferPoolManager();
+
+  // a scan passes its strategy to keep to its own ring of frames
+  virtual Page *FetchPage(page_id_t page_id,
+                          BufferAccessStrategy *strategy = nullptr);
+
+  virtual bool UnpinPage(page_id_t page_id, bool is_dirty);
+  // for callers that hold a pin on page and thus know its frame; skips the
+  // page table lookup
+  virtual bool UnpinPage(Page *page, bool is_dirty);
+
+  virtual bool FlushPage(page_id_t page_id);
 
-  ~BufferPoolManager();
+  // checkpoint: write every page dirty at the call back, in page id order
+  // with adjacent pages in one write, and sync. Fetches go on meanwhile
+  virtual FlushStats FlushAllPages();
 
-  Page *FetchPage(page_id_t page_id);
+  // load pages that are not yet resident without pinning them
+  virtual void Prefetch(const std::vector<page_id_t> &page_ids,
+                        BufferAccessStrategy *strategy = nullptr);
+  // same, done by a background worker; the future is ready once the pages
+  // are loaded. Requests are served in order
+  std::future<void> PrefetchAsync(std::vector<page_id_t> page_ids,
+                                  BufferAccessStrategy *strategy = nullptr);
 
-  bool UnpinPage(page_id_t page_id, bool is_dirty);
+  // hint_page_id keeps the new page in the extent of the hint's object
+  virtual Page *NewPage(page_id_t &page_id,
+                        page_id_t hint_page_id = INVALID_PAGE_ID);
 
-  bool FlushPage(page_id_t page_id);
+  virtual bool DeletePage(page_id_t page_id);
 
-  Page *NewPage(page_id_t &page_id);
+  // the same as FetchPage and NewPage, with the pin (and latch) owned by a
+  // guard; the guard is empty if the page could not be brought in
+  BasicPageGuard FetchPageBasic(page_id_t page_id);
+  ReadPageGuard FetchPageRead(page_id_t page_id,
+                              BufferAccessStrategy *strategy = nullptr);
+  WritePageGuard FetchPageWrite(page_id_t page_id);
+  BasicPageGuard NewPageGuarded(page_id_t &page_id,
+                                page_id_t hint_page_id = INVALID_PAGE_ID);
 
-  bool DeletePage(page_id_t page_id);
+  // pointer swizzling: ref names the frame page_id was last found in. If the
+  // frame still holds the page it is pinned directly, without the page
+  // table; otherwise the page is fetched and ref swizzled to its frame. A
+  // frame given to another page fails the check, so refs need no unswizzling
+  // when their page is evicted. A null ref is an ordinary fetch
+  virtual Page *FetchSwizzled(page_id_t page_id, std::atomic<Page *> *ref);
+  ReadPageGuard FetchSwizzledRead(page_id_t page_id,
+                                  std::atomic<Page *> *ref);
+  // the ref for the child at slot of the inner page parent, which the caller
+  // keeps pinned; nullptr for a slot past the end of a page
+  std::atomic<Page *> *GetChildRef(Page *parent, int slot);
+  // fetches served from swizzled refs
+  virtual uint64_t GetNumSwizzledHits() const { return num_swizzled_hits_; }
 
-  bool CheckAllUnpined();
+  virtual bool CheckAllUnpined();
+
+  inline size_t GetPageSize() const { return page_size_; }
+  // kind of memory the frames got, which may fall short of the one asked for
+  virtual FrameMemory GetFrameMemory() const {
+    return frame_arena_->GetMemory();
+  }
+  virtual size_t GetPoolSize() const { return pool_size_; }
+  virtual size_t GetMaxPoolSize() const { return max_pool_size_; }
+  // change the number of frames while the pool is in use, to between 1 and
+  // GetMaxPoolSize(); false if new_size is out of that range, or if a shrink
+  // stopped short at frames kept pinned, see GetPoolSize
+  virtual bool Resize(size_t new_size);
+
+  // whether scans read ahead of their position, see Readahead
+  inline void SetReadahead(bool readahead) { readahead_ = readahead; }
+  inline bool IsReadaheadEnabled() const { return readahead_; }
+
+  // background cleaner writing dirty pages at the cold end of the replacer
+  // before they are picked as victims; while more than high_ratio of the
+  // frames are dirty it cleans further, down to low_ratio
+  virtual void StartCleaner(double low_ratio = CLEANER_LOW_DIRTY_RATIO,
+                            double high_ratio = CLEANER_HIGH_DIRTY_RATIO);
+  virtual void StopCleaner();
+  // pages written by the cleaner, and victims that were still dirty
+  virtual uint64_t GetNumPagesCleaned() const { return num_pages_cleaned_; }
+  virtual uint64_t GetNumDirtyEvictions() const {
+    return num_dirty_evictions_;
+  }
+
+  // second tier of evicted pages kept compressed in memory, see
+  // CompressedPageCache; off until given a budget of compressed bytes, and
+  // a budget of 0 turns it off again
+  virtual void SetCompressedCacheBudget(size_t budget_bytes);
+  virtual CompressedCacheStats GetCompressedCacheStats();
+
+protected:
+  BufferPoolManager(DiskManager *disk_manager, LogManager *log_manager);
+  // subclasses whose Prefetch uses state of their own stop the worker first
+  void StopPrefetchWorker();
 
 private:
-  size_t pool_size_; // number of pages in buffer pool
+  friend class ParallelBufferPoolManager;
+  friend class BufferAccessStrategy;
+  Page *NewPageWithId(page_id_t page_id);
+  void InstallNewPage(Page *tar, page_id_t page_id,
+                      std::unique_lock<std::mutex> &lck);
+  Page *TryPinResident(page_id_t page_id, BufferAccessStrategy *strategy);
+  Page *TryPinFrame(Page *tar, page_id_t page_id,
+                    BufferAccessStrategy *strategy);
+  inline bool OwnsFrame(Page *tar) const {
+    return tar >= pages_ && tar < pages_ + max_pool_size_;
+  }
+  // whether tar is among the frames in use, not one a shrink gives up
+  inline bool InPool(Page *tar) const {
+    return static_cast<size_t>(tar - pages_) < pool_size_;
+  }
+  bool RetireFrame(Page *tar, std::unique_lock<std::mutex> &lck);
+  static void Unswizzle(Page *tar);
+  void ReleasePin(Page *tar);
+  void DropFailedFrame(Page *tar);
+  bool UnpinFrame(Page *tar, bool is_dirty);
+  int GetFrameNode(Page *tar) const;
+  Page *GetLocalVictim(int node);
+  static bool IsReplaceable(Page *tar);
+  void WaitForIO(Page *tar, std::unique_lock<std::mutex> &lck);
+  bool WaitForEviction(page_id_t page_id, std::unique_lock<std::mutex> &lck);
+  bool WaitForCleaning(page_id_t page_id, std::unique_lock<std::mutex> &lck);
+  void CleanerLoop();
+  void PrefetchLoop();
+  size_t CleanRound(std::unique_lock<std::mutex> &lck);
+  FlushStats FlushInstances(const std::vector<BufferPoolManager *> &instances);
+  void CollectDirtyPages(std::vector<page_id_t> &page_ids);
+  Page *PinForFlush(page_id_t page_id);
+  void EndFlush(page_id_t page_id);
+  void WaitForWrites();
+  bool IsStashed(page_id_t page_id) const;
+  void StashPage(page_id_t page_id, const char *data);
+  bool ReadPageData(page_id_t page_id, char *data);
+  bool ReadPagesData(const std::vector<std::pair<page_id_t, char *>> &pages);
+
+  std::atomic<size_t> pool_size_; // number of pages in buffer pool
+  // frames reserved: the page table, replacer and frame memory are sized
+  // for them, though only the first pool_size_ are used
+  size_t max_pool_size_;
+  size_t page_size_; // size of each page, as chosen by the disk manager
   Page *pages_;      // array of pages
+  char *frames_;     // page contents, aligned for direct I/O
+  FrameArena *frame_arena_; // the memory behind frames_
   DiskManager *disk_manager_;
   LogManager *log_manager_;
-  HashTable<page_id_t, Page *> *page_table_; // to keep track of pages
-  Replacer<Page *> *replacer_;   // to find an unpinned page for replacement
-  std::list<Page *> *free_list_; // to find a free page for replacement
+  // to keep track of pages, lookups need no lock
+  HashTable<page_id_t, Page *> *page_table_;
+  BufferedReplacer<Page *> *replacer_; // to find an unpinned page to replace
+  // to find a free page for replacement, one list per memory node
+  std::vector<std::list<Page *>> free_lists_;
   std::mutex latch_;             // to protect shared data structure
-  Page *GetVictimPage();
+  std::mutex resize_latch_;      // one Resize at a time
+  // dirty pages being written back, by old page id, and their frames
+  std::unordered_map<page_id_t, Page *> evicting_;
+  // pages the cleaner is writing from copies, signalled on clean_cv_
+  std::unordered_set<page_id_t> cleaning_;
+  std::condition_variable clean_cv_;
+  std::thread cleaner_;
+  std::condition_variable cleaner_cv_; // wakes the cleaner early
+  bool cleaner_shutdown_ = false;
+  double cleaner_low_ratio_ = CLEANER_LOW_DIRTY_RATIO;
+  double cleaner_high_ratio_ = CLEANER_HIGH_DIRTY_RATIO;
+  char *cleaner_buffer_ = nullptr; // CLEANER_BATCH_SIZE aligned pages
+  std::atomic<uint64_t> num_pages_cleaned_{0};
+  std::atomic<uint64_t> num_dirty_evictions_{0};
+  std::atomic<uint64_t> num_swizzled_hits_{0};
+  // evicted pages kept compressed, created on first use
+  std::atomic<CompressedPageCache *> compressed_cache_{nullptr};
+  // asynchronous prefetch requests and the worker serving them
+  struct PrefetchRequest {
+    std::vector<page_id_t> page_ids_;
+    BufferAccessStrategy *strategy_;
+    std::promise<void> done_;
+  };
+  std::deque<PrefetchRequest> prefetch_queue_;
+  std::mutex prefetch_latch_;
+  std::condition_variable prefetch_cv_;
+  std::thread prefetch_worker_;
+  bool prefetch_shutdown_ = false;
+  std::atomic<bool> readahead_{true};
+  Page *GetVictimPage(BufferAccessStrategy *strategy = nullptr);
+  size_t GetRingCapacity(BufferAccessStrategy *strategy);
+  Page *GetRingVictim(BufferAccessStrategy *strategy, bool pool_exhausted);
+  void AddToRing(BufferAccessStrategy *strategy, Page *tar);
+  void ReleaseRingFrame(BufferAccessStrategy *strategy, Page *tar);
+  void ReleaseRing(BufferAccessStrategy *strategy,
+                   const std::vector<Page *> &frames);
 
 };
 } // namespace scudb
@@ -0,0 +1,73 @@
+/**
+ * buffered_replacer.h
+ *
+ * Wraps a replacer so that Insert, which the buffer pool calls on every
+ * unpin, touches no shared lock. Inserts are appended to one of several
+ * small buffers, picked by the calling thread, with a single compare and
+ * swap, and applied to the wrapped replacer in batches, in the style of
+ * Caffeine's read buffers. Victim, Erase, Size and PeekVictims apply all
+ * buffered inserts first, so a single thread sees exactly the wrapped
+ * policy; inserts from different threads may reach it slightly reordered.
+ *
+ * A buffered insert may be stale by the time it is applied. The admit
+ * predicate, if given, is asked at that point whether the value should
+ * still go in. Callers serialize everything but TryInsert, e.g. with the
+ * buffer pool latch, so that the predicate sees a stable state.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace scudb {
+
+template <typename T> class BufferedReplacer : public Replacer<T> {
+  struct Slot {
+    std::atomic<bool> full_;
+    T value_;
+  };
+  // a ring of slots; producers reserve tail_ and the drain advances head_
+  struct Stripe {
+    std::atomic<uint32_t> head_;
+    std::atomic<uint32_t> tail_;
+    Slot slots_[ACCESS_BUFFER_SIZE];
+    char padding_[64]; // keep stripes off each other's cache lines
+  };
+
+public:
+  // takes ownership of replacer
+  explicit BufferedReplacer(Replacer<T> *replacer,
+                            std::function<bool(const T &)> admit = nullptr);
+  ~BufferedReplacer();
+
+  // buffer an insert of value without locking, false if the calling
+  // thread's buffer is full; the caller then uses Insert
+  bool TryInsert(const T &value);
+  // buffered as TryInsert, or applied at once with all buffered inserts
+  // when the buffer is full
+  void Insert(const T &value) override;
+  bool Victim(T &value) override;
+  bool Erase(const T &value) override;
+  size_t Size() override;
+  void PeekVictims(std::vector<T> &values, size_t max_count) override;
+
+  // apply every buffered insert
+  void Drain();
+
+private:
+  // caller holds drain_latch_
+  void DrainLocked();
+
+  std::unique_ptr<Replacer<T>> replacer_;
+  std::function<bool(const T &)> admit_;
+  Stripe stripes_[ACCESS_BUFFER_STRIPES];
+  std::mutex drain_latch_;
+};
+
+} // namespace scudb
@@ -0,0 +1,46 @@
+/**
+ * clock_replacer.h
+ *
+ * CLOCK (second chance) replacement. Values sit on a circular list swept by
+ * a hand. Inserting a value sets its reference bit; the hand clears set bits
+ * as it passes and evicts the first value whose bit is already clear. This
+ * approximates LRU without reordering a list on every access.
+ */
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "buffer/replacer.h"
+
+namespace scudb {
+
+template <typename T> class ClockReplacer : public Replacer<T> {
+  struct Entry {
+    T value_;
+    bool referenced_;
+  };
+
+public:
+  ClockReplacer();
+  ~ClockReplacer();
+
+  void Insert(const T &value) override;
+  bool Victim(T &value) override;
+  bool Erase(const T &value) override;
+  size_t Size() override;
+  void PeekVictims(std::vector<T> &values, size_t max_count) override;
+
+private:
+  // move the hand one entry on, wrapping around at the end
+  void Advance();
+
+  std::list<Entry> ring_;
+  typename std::list<Entry>::iterator hand_;
+  std::unordered_map<T, typename std::list<Entry>::iterator> map_;
+  std::mutex latch_;
+};
+
+} // namespace scudb
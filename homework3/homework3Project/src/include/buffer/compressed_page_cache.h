@@ -0,0 +1,83 @@
+/**
+ * compressed_page_cache.h
+ *
+ * A second tier below the buffer pool, in the style of zswap: pages leaving
+ * the pool are kept in memory compressed with PageCodec, within a budget of
+ * compressed bytes, and a miss in the pool that finds its page here is
+ * decompressed instead of read from disk. Only copies equal to what is on
+ * disk are kept, so dropping one never loses data: the least recently
+ * stored pages are dropped to stay within the budget, and pages that do not
+ * compress below their size are not kept at all. A page taken back into the
+ * pool leaves the cache, it is stored again when it is evicted.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "common/config.h"
+
+namespace scudb {
+
+// state and counters of a compressed page cache
+struct CompressedCacheStats {
+  size_t budget_bytes_ = 0;
+  size_t used_bytes_ = 0; // compressed bytes held
+  size_t num_pages_ = 0;
+  uint64_t num_hits_ = 0;
+  uint64_t num_misses_ = 0;
+  uint64_t num_stored_ = 0;
+  uint64_t num_rejected_ = 0; // pages that did not compress
+  uint64_t num_dropped_ = 0;  // pages dropped for the budget
+
+  inline double GetHitRatio() const {
+    return num_hits_ + num_misses_ == 0
+               ? 0
+               : static_cast<double>(num_hits_) / (num_hits_ + num_misses_);
+  }
+};
+
+class CompressedPageCache {
+  struct Entry {
+    std::unique_ptr<char[]> data_;
+    size_t len_;
+    std::list<page_id_t>::iterator lru_;
+  };
+
+public:
+  // at most budget_bytes of compressed pages of page_size bytes each
+  CompressedPageCache(size_t budget_bytes, size_t page_size);
+
+  // keep a copy of page_id's contents, replacing an older one; false if the
+  // page does not compress or is larger than the budget
+  bool Put(page_id_t page_id, const char *data);
+  // decompress page_id into data and drop it from the cache; false on a miss
+  bool Take(page_id_t page_id, char *data);
+  void Erase(page_id_t page_id);
+  // a smaller budget drops pages right away
+  void SetBudget(size_t budget_bytes);
+
+  CompressedCacheStats GetStats();
+
+private:
+  void EraseEntry(std::unordered_map<page_id_t, Entry>::iterator it);
+  void Shrink();
+
+  size_t page_size_;
+  std::atomic<size_t> budget_bytes_;
+  size_t used_bytes_ = 0;
+  std::unordered_map<page_id_t, Entry> entries_;
+  std::list<page_id_t> lru_; // most recently stored first
+  std::mutex latch_;
+  std::atomic<uint64_t> num_hits_{0};
+  std::atomic<uint64_t> num_misses_{0};
+  std::atomic<uint64_t> num_stored_{0};
+  std::atomic<uint64_t> num_rejected_{0};
+  std::atomic<uint64_t> num_dropped_{0};
+};
+
+} // namespace scudb
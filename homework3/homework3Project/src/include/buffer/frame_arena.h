@@ -0,0 +1,79 @@
+/**
+ * frame_arena.h
+ *
+ * The memory holding the frames of a buffer pool. By default it is an
+ * ordinary aligned allocation. It can instead be mapped with 2 MiB huge
+ * pages, either transparent ones (madvise) or explicit ones from the kernel's
+ * hugetlb pool. A multi-gigabyte pool then needs a few thousand TLB entries
+ * instead of a few hundred thousand. Explicit huge pages must be reserved
+ * beforehand (vm.nr_hugepages). If they are not available, the arena falls
+ * back to transparent huge pages and reports which kind it got.
+ *
+ * A pool that may grow reserves an arena for its largest size. Memory is
+ * only committed when a frame is first touched, and Release hands the
+ * memory of frames the pool gave up back to the operating system.
+ *
+ * A NUMA-aware arena is split into one contiguous part per memory node. Each
+ * part is bound to its node before it is first touched, and GetNode tells
+ * which node a frame lives on. NUMA support uses the raw mbind system call,
+ * so it needs no library. On a machine with a single node it does nothing.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+
+namespace scudb {
+
+enum class FrameMemory { DEFAULT = 0, TRANSPARENT_HUGE, EXPLICIT_HUGE };
+
+// short name of memory, e.g. "thp"; ParseFrameMemory is the inverse and
+// returns false for an unknown name
+const char *FrameMemoryName(FrameMemory memory);
+bool ParseFrameMemory(const std::string &name, FrameMemory &memory);
+
+// memory nodes of this machine, at least 1, and the node of the calling
+// thread's current cpu
+int GetNumNumaNodes();
+int GetCurrentNumaNode();
+
+class FrameArena {
+public:
+  // num_frames frames of frame_size bytes each
+  FrameArena(size_t num_frames, size_t frame_size,
+             FrameMemory memory = FrameMemory::DEFAULT,
+             bool numa_aware = false);
+  ~FrameArena();
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  inline char *GetFrame(size_t frame) const {
+    return data_ + frame * frame_size_;
+  }
+  // the kind of memory actually obtained
+  inline FrameMemory GetMemory() const { return memory_; }
+  inline size_t GetMappedBytes() const { return mapped_bytes_; }
+  // number of parts, one per node if NUMA-aware, else 1
+  inline int GetNumNodes() const { return static_cast<int>(node_ends_.size()); }
+  int GetNode(size_t frame) const;
+  // give the memory of frames first to last - 1 back; they read as zeros
+  // when touched again. Only whole pages inside the range are released
+  void Release(size_t first, size_t last);
+
+private:
+  char *MapHuge(size_t bytes, bool explicit_huge);
+  void BindToNodes(size_t granularity);
+
+  char *data_;
+  size_t frame_size_;
+  size_t num_frames_;
+  size_t mapped_bytes_; // 0 for the aligned allocation
+  FrameMemory memory_;
+  // first frame past each node's part
+  std::vector<size_t> node_ends_;
+};
+
+} // namespace scudb
@@ -0,0 +1,36 @@
+/**
+ * ghost_list.h
+ *
+ * Keys of evicted values in eviction order, with constant-time lookup and
+ * removal. Replacement policies use it to remember what they evicted recently
+ * without holding on to the values themselves.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+
+namespace scudb {
+
+class GhostList {
+public:
+  inline bool Contains(int64_t key) const { return map_.count(key) > 0; }
+  inline size_t Size() const { return keys_.size(); }
+  inline bool Empty() const { return keys_.empty(); }
+
+  // remember key as the most recently evicted one
+  void PushBack(int64_t key);
+  // forget the least recently evicted key and return it, list not empty
+  int64_t PopFront();
+  // forget key, false if it is not remembered
+  bool Erase(int64_t key);
+
+private:
+  std::list<int64_t> keys_;
+  std::unordered_map<int64_t, std::list<int64_t>::iterator> map_;
+};
+
+} // namespace scudb
@@ -0,0 +1,66 @@
+/**
+ * lru_k_replacer.h
+ *
+ * LRU-K replacement (O'Neil et al.). Every Insert counts as an access, and
+ * the last k access times of each value are kept. The victim is the value
+ * whose k-th latest access lies furthest back; values with fewer than k
+ * accesses go first, oldest first access first. A page touched once by a
+ * scan is therefore evicted before a page that index probes keep coming
+ * back to.
+ *
+ * Access history is keyed by ReplacerKey, so it stays with a page while the
+ * page is pinned and for a while after it was evicted: the keys of the last
+ * history_size evicted or pinned values keep their history.
+ */
+
+#pragma once
+
+#include <deque>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "buffer/ghost_list.h"
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace scudb {
+
+template <typename T> class LRUKReplacer : public Replacer<T> {
+  // eviction order: values without k accesses first, then by k-th latest
+  // access; the access time makes every priority unique
+  typedef std::pair<bool, uint64_t> Priority;
+  struct Entry {
+    int64_t key_;
+    typename std::map<Priority, T>::iterator pos_;
+  };
+
+public:
+  explicit LRUKReplacer(size_t k = LRUK_K,
+                        size_t history_size = BUFFER_POOL_SIZE);
+  ~LRUKReplacer();
+
+  void Insert(const T &value) override;
+  bool Victim(T &value) override;
+  bool Erase(const T &value) override;
+  size_t Size() override;
+  void PeekVictims(std::vector<T> &values, size_t max_count) override;
+
+private:
+  // keep the history of key for now, dropping the oldest remembered one
+  void Remember(int64_t key);
+
+  size_t k_;
+  size_t history_size_;
+  uint64_t current_time_;
+  // last k access times per key, oldest first
+  std::unordered_map<int64_t, std::deque<uint64_t>> history_;
+  std::map<Priority, T> order_;
+  std::unordered_map<T, Entry> entries_;
+  // keys with a history but no entry
+  GhostList remembered_;
+  std::mutex latch_;
+};
+
+} // namespace scudb
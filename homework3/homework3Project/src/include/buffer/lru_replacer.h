@@ -40,6 +40,8 @@ public:
 
   size_t Size();
 
+  void PeekVictims(std::vector<T> &values, size_t max_count);
+
 private:
   shared_ptr<Node> head;
   shared_ptr<Node> tail;
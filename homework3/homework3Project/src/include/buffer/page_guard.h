@@ -0,0 +1,108 @@
+/**
+ * page_guard.h
+ *
+ * Movable owners of a pinned page. A guard takes over the pin of a page
+ * returned by the buffer pool and gives it back when it goes out of scope,
+ * is reassigned or is released explicitly. The frame is known, so the unpin
+ * needs no page table lookup. ReadPageGuard and WritePageGuard also hold the
+ * page's read or write latch and drop it before the pin.
+ *
+ * Guards are not copyable. Moving one hands over the pin and the latch and
+ * leaves the source empty; assigning to a guard first acquires the new page
+ * (the right-hand side is already latched), then releases the old one, which
+ * is the order latch crabbing needs.
+ */
+
+#pragma once
+
+#include "page/page.h"
+
+namespace scudb {
+
+class BufferPoolManager;
+
+// a pin only, e.g. for pages latched by someone else or not yet shared
+class BasicPageGuard {
+public:
+  BasicPageGuard() = default;
+  // takes over a pin on page, which may be nullptr
+  BasicPageGuard(BufferPoolManager *buffer_pool_manager, Page *page);
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+  BasicPageGuard &operator=(BasicPageGuard &&that) noexcept;
+  BasicPageGuard(const BasicPageGuard &) = delete;
+  BasicPageGuard &operator=(const BasicPageGuard &) = delete;
+  ~BasicPageGuard() { Release(); }
+
+  // unpin now; the guard is empty afterwards
+  void Release();
+
+  inline bool IsValid() const { return page_ != nullptr; }
+  inline Page *GetPage() const { return page_; }
+  inline page_id_t GetPageId() const { return page_->GetPageId(); }
+  inline char *GetData() const { return page_->GetData(); }
+  // the page is written back before its frame is reused
+  inline void SetDirty() { is_dirty_ = true; }
+
+  template <typename T> inline const T *As() const {
+    return reinterpret_cast<const T *>(page_->GetData());
+  }
+  template <typename T> inline T *AsMut() {
+    is_dirty_ = true;
+    return reinterpret_cast<T *>(page_->GetData());
+  }
+
+private:
+  BufferPoolManager *buffer_pool_manager_ = nullptr;
+  Page *page_ = nullptr;
+  bool is_dirty_ = false;
+};
+
+class ReadPageGuard {
+public:
+  ReadPageGuard() = default;
+  // takes over a pin on page and read latches it
+  ReadPageGuard(BufferPoolManager *buffer_pool_manager, Page *page);
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+  ReadPageGuard &operator=(ReadPageGuard &&that) noexcept;
+  ~ReadPageGuard() { Release(); }
+
+  // unlatch and unpin now
+  void Release();
+
+  inline bool IsValid() const { return guard_.IsValid(); }
+  inline Page *GetPage() const { return guard_.GetPage(); }
+  inline page_id_t GetPageId() const { return guard_.GetPageId(); }
+  inline const char *GetData() const { return guard_.GetData(); }
+
+  template <typename T> inline const T *As() const { return guard_.As<T>(); }
+
+private:
+  BasicPageGuard guard_;
+};
+
+class WritePageGuard {
+public:
+  WritePageGuard() = default;
+  // takes over a pin on page and write latches it
+  WritePageGuard(BufferPoolManager *buffer_pool_manager, Page *page);
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+  WritePageGuard &operator=(WritePageGuard &&that) noexcept;
+  ~WritePageGuard() { Release(); }
+
+  // unlatch and unpin now, dirty if the page was changed through AsMut
+  void Release();
+
+  inline bool IsValid() const { return guard_.IsValid(); }
+  inline Page *GetPage() const { return guard_.GetPage(); }
+  inline page_id_t GetPageId() const { return guard_.GetPageId(); }
+  inline char *GetData() const { return guard_.GetData(); }
+  inline void SetDirty() { guard_.SetDirty(); }
+
+  template <typename T> inline const T *As() const { return guard_.As<T>(); }
+  template <typename T> inline T *AsMut() { return guard_.AsMut<T>(); }
+
+private:
+  BasicPageGuard guard_;
+};
+
+} // namespace scudb
@@ -0,0 +1,75 @@
+/**
+ * parallel_buffer_pool_manager.h
+ *
+ * A buffer pool split into independent instances, each with its own latch,
+ * page table, replacer and free list. A page always lives in the instance
+ * chosen by its page id, so threads working on different pages rarely
+ * contend. The public interface is that of BufferPoolManager; note that a
+ * new page fails once its own instance is fully pinned, even if others are
+ * not.
+ */
+
+#pragma once
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+
+namespace scudb {
+
+class ParallelBufferPoolManager : public BufferPoolManager {
+public:
+  // pool_size frames in total, spread over num_instances instances, and so
+  // is max_pool_size
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size,
+                            DiskManager *disk_manager,
+                            LogManager *log_manager = nullptr,
+                            ReplacerPolicy policy = ReplacerPolicy::LRU,
+                            FrameMemory memory = FrameMemory::DEFAULT,
+                            bool numa_aware = false, size_t max_pool_size = 0);
+  ~ParallelBufferPoolManager();
+
+  Page *FetchPage(page_id_t page_id,
+                  BufferAccessStrategy *strategy = nullptr) override;
+  Page *FetchSwizzled(page_id_t page_id, std::atomic<Page *> *ref) override;
+  bool UnpinPage(page_id_t page_id, bool is_dirty) override;
+  bool UnpinPage(Page *page, bool is_dirty) override;
+  bool FlushPage(page_id_t page_id) override;
+  // pages of all instances are sorted together, as neighbours on disk live
+  // in different instances
+  FlushStats FlushAllPages() override;
+  void Prefetch(const std::vector<page_id_t> &page_ids,
+                BufferAccessStrategy *strategy = nullptr) override;
+  Page *NewPage(page_id_t &page_id,
+                page_id_t hint_page_id = INVALID_PAGE_ID) override;
+  bool DeletePage(page_id_t page_id) override;
+  bool CheckAllUnpined() override;
+  void StartCleaner(double low_ratio = CLEANER_LOW_DIRTY_RATIO,
+                    double high_ratio = CLEANER_HIGH_DIRTY_RATIO) override;
+  void StopCleaner() override;
+  uint64_t GetNumPagesCleaned() const override;
+  uint64_t GetNumDirtyEvictions() const override;
+  uint64_t GetNumSwizzledHits() const override;
+  size_t GetPoolSize() const override;
+  size_t GetMaxPoolSize() const override;
+  // every instance keeps at least one frame
+  bool Resize(size_t new_size) override;
+  FrameMemory GetFrameMemory() const override;
+  // the budget is split like the frames
+  void SetCompressedCacheBudget(size_t budget_bytes) override;
+  CompressedCacheStats GetCompressedCacheStats() override;
+
+  inline size_t GetNumInstances() const { return instances_.size(); }
+
+private:
+  inline BufferPoolManager *GetInstance(page_id_t page_id) {
+    return instances_[static_cast<uint32_t>(page_id) % instances_.size()];
+  }
+  // share of instance i in size frames
+  inline size_t GetShare(size_t size, size_t i) const {
+    return size / instances_.size() + (i < size % instances_.size());
+  }
+
+  std::vector<BufferPoolManager *> instances_;
+};
+
+} // namespace scudb
@@ -0,0 +1,45 @@
+/**
+ * readahead.h
+ *
+ * Adaptive sequential readahead for scans that follow a chain of pages, such
+ * as the next-page links of a table heap or the leaf chain of a b+ tree. The
+ * scan reports each page it moves to. After READAHEAD_TRIGGER moves in a row
+ * to the physically next page, the pages after the current one are
+ * prefetched in the background. The window starts at READAHEAD_MIN_PAGES and
+ * doubles each time the scan reaches the middle of the last window, up to
+ * READAHEAD_MAX_PAGES or a quarter of the buffer pool; a jump resets it.
+ * Chains are assumed to be laid out in page order, which extent allocation
+ * makes likely; a wrong guess only costs a read. A scan with an access
+ * strategy reads ahead into its ring, at most half a ring at a time.
+ */
+
+#pragma once
+#include <future>
+
+#include "buffer/buffer_pool_manager.h"
+
+namespace scudb {
+
+class Readahead {
+public:
+  explicit Readahead(BufferPoolManager *buffer_pool_manager,
+                     BufferAccessStrategy *strategy = nullptr);
+  // waits for the prefetch still in flight
+  ~Readahead();
+
+  // the scan moved to page_id
+  void Advance(page_id_t page_id);
+
+  inline size_t GetWindow() const { return window_; }
+
+private:
+  BufferPoolManager *buffer_pool_manager_;
+  BufferAccessStrategy *strategy_;
+  page_id_t last_page_id_;
+  int sequential_moves_;
+  size_t window_;
+  page_id_t prefetched_until_; // last page requested so far
+  std::future<void> pending_;
+};
+
+} // namespace scudb
@@ -5,10 +5,14 @@
  */
 #pragma once
 
+#include <cstdint>
 #include <cstdlib>
+#include <vector>
 
 namespace scudb {
 
+class Page;
+
 template <typename T> class Replacer {
 public:
   Replacer() {}
@@ -17,6 +21,18 @@ public:
   virtual bool Victim(T &value) = 0;
   virtual bool Erase(const T &value) = 0;
   virtual size_t Size() = 0;
+  // up to max_count values in the order Victim would pick them, left in place
+  virtual void PeekVictims(std::vector<T> &values, size_t max_count) = 0;
 };
 
+/*
+ * Identity of the content a value stands for. Policies that remember values
+ * after evicting them key that history by it: a value is itself, a frame is
+ * the page it currently holds
+ */
+template <typename T> inline int64_t ReplacerKey(const T &value) {
+  return static_cast<int64_t>(value);
+}
+int64_t ReplacerKey(Page *const &page);
+
 } // namespace scudb
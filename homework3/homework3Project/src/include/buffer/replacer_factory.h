@@ -0,0 +1,27 @@
+/**
+ * replacer_factory.h
+ *
+ * The replacement policies a buffer pool can be built with, and a factory
+ * creating a replacer for a chosen policy.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "buffer/replacer.h"
+
+namespace scudb {
+
+enum class ReplacerPolicy { LRU = 0, CLOCK, LRU_K, TWO_Q, ARC };
+
+// a replacer of policy for a pool of capacity frames, owned by the caller
+template <typename T>
+Replacer<T> *CreateReplacer(ReplacerPolicy policy, size_t capacity);
+
+// short name of policy, e.g. "lru-k"; ParseReplacerPolicy is the inverse and
+// returns false for an unknown name
+const char *ReplacerPolicyName(ReplacerPolicy policy);
+bool ParseReplacerPolicy(const std::string &name, ReplacerPolicy &policy);
+
+} // namespace scudb
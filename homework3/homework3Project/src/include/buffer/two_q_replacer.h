@@ -0,0 +1,61 @@
+/**
+ * two_q_replacer.h
+ *
+ * 2Q replacement (Johnson and Shasha). Values seen for the first time enter
+ * A1in, a FIFO limited to a quarter of the pool; accesses while they are in
+ * A1in are taken as correlated and do not promote them. Keys evicted from
+ * A1in are remembered in A1out, and a value whose key is found there is hot
+ * and goes to Am, an LRU list. Pages of a scan thus pass through A1in
+ * without displacing the pages in Am.
+ *
+ * Erase only makes a value ineligible: a pinned page keeps its place and
+ * queue, and Insert makes it eligible again. A value inserted under a new key
+ * starts over as a new value.
+ */
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "buffer/ghost_list.h"
+#include "buffer/replacer.h"
+
+namespace scudb {
+
+template <typename T> class TwoQReplacer : public Replacer<T> {
+  struct Entry {
+    int64_t key_;
+    bool hot_;       // in Am rather than A1in
+    bool evictable_; // false while erased
+    typename std::list<T>::iterator pos_;
+  };
+
+public:
+  // capacity is the number of frames of the pool
+  explicit TwoQReplacer(size_t capacity);
+  ~TwoQReplacer();
+
+  void Insert(const T &value) override;
+  bool Victim(T &value) override;
+  bool Erase(const T &value) override;
+  size_t Size() override;
+  void PeekVictims(std::vector<T> &values, size_t max_count) override;
+
+private:
+  // first eligible value of queue at or after it, queue.end() if none
+  typename std::list<T>::iterator
+  NextEvictable(std::list<T> &queue, typename std::list<T>::iterator it);
+
+  size_t kin_;  // A1in size from which A1in is evicted first
+  size_t kout_; // keys remembered in A1out
+  size_t size_; // eligible values
+  std::list<T> a1in_;
+  std::list<T> am_;
+  std::unordered_map<T, Entry> entries_;
+  GhostList a1out_;
+  std::mutex latch_;
+};
+
+} // namespace scudb
@@ -20,11 +20,33 @@ extern std::atomic<bool> ENABLE_LOGGING;
 #define INVALID_TXN_ID -1  // representing an invalid txn id
 #define INVALID_LSN -1     // representing an invalid lsn
 #define HEADER_PAGE_ID 0   // the header page id
-#define PAGE_SIZE 128     // size of a data page in byte
+#define PAGE_SIZE 128     // default size of a data page in byte
+#define MAX_PAGE_SIZE 32768 // largest page size a database may choose
 #define LOG_BUFFER_SIZE                                                            \
   ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE) // size of a log buffer in byte
 #define BUCKET_SIZE 50                 // size of extendible hash bucket
 #define BUFFER_POOL_SIZE 10            // size of buffer pool
+#define BUFFER_POOL_MAX_SIZE 1024      // frames the engine's pool may grow to
+#define RESIZE_TIMEOUT_MS 1000         // longest a shrink waits for pinned frames
+#define DISK_IO_THREADS 4              // number of asynchronous I/O workers
+#define DIRECT_IO_ALIGNMENT 4096       // buffer/offset alignment of O_DIRECT
+#define EXTENT_SIZE 64                 // pages reserved at once for an object
+#define WRITE_BATCH_SIZE 32            // staged pages per write-behind batch
+#define CLEANER_INTERVAL_MS 10         // period of the background page cleaner
+#define CLEANER_LOOKAHEAD 16           // coldest pages the cleaner keeps clean
+#define CLEANER_BATCH_SIZE 32          // pages the cleaner writes per round
+#define CHECKPOINT_BATCH_SIZE 64       // pages FlushAllPages copies per write
+#define CLEANER_LOW_DIRTY_RATIO 0.1    // dirty share the cleaner cleans down to
+#define CLEANER_HIGH_DIRTY_RATIO 0.3   // dirty share that triggers bulk cleaning
+#define READAHEAD_TRIGGER 2            // sequential page moves before readahead
+#define READAHEAD_MIN_PAGES 4          // first readahead window
+#define READAHEAD_MAX_PAGES 64         // largest readahead window
+#define SCAN_RING_SIZE 32              // frames a scan strategy cycles through
+#define LRUK_K 2                       // accesses LRU-K ranks pages by
+#define ACCESS_BUFFER_STRIPES 16       // buffers of unpins, chosen by thread
+#define ACCESS_BUFFER_SIZE 64          // unpins a buffer holds before a drain
+#define HUGE_PAGE_SIZE 2097152         // 2 MiB huge pages backing frames
+#define NUMA_VICTIM_LOOKAHEAD 8        // coldest pages searched for a local one
 
 typedef int32_t page_id_t; // page id type
 typedef int32_t txn_id_t;  // transaction id type
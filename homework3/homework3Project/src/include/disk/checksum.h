@@ -0,0 +1,22 @@
+/**
+ * checksum.h
+ *
+ * CRC32C (Castagnoli) page checksums. On x86 CPUs with SSE4.2 the crc32
+ * instruction processes eight bytes per cycle; elsewhere a slicing-by-8 table
+ * routine gives the same result. The choice is made once at run time, so no
+ * special compiler flags are needed.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace scudb {
+
+// checksum of len bytes, using the fastest routine available
+uint32_t Crc32c(const char *data, size_t len);
+// the portable routine, exposed for testing
+uint32_t Crc32cPortable(const char *data, size_t len);
+bool Crc32cHardwareAvailable();
+
+} // namespace scudb
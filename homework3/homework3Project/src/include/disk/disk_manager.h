@@ -5,49 +5,271 @@
  * database. It also performs read and write of pages to and from disk, and
  * provides a logical file layer within the context of a database management
  * system.
+ *
+ * Page I/O uses positional pread/pwrite on a raw file descriptor, so requests
+ * from different threads never share a file cursor and may overlap. The
+ * asynchronous interface hands requests to a small pool of I/O workers and
+ * returns a future that becomes ready once the request has completed.
+ * ReadPages/WritePages move many pages per call: requests are sorted by page
+ * id and runs of adjacent pages are transferred with one preadv/pwritev.
+ *
+ * The page size is chosen when the database file is created and recorded in
+ * the header page; reopening an existing file always uses the recorded size.
+ *
+ * Released pages are tracked in a free-page bitmap kept in a side file next
+ * to the database (<name>.fsm, one bit per page) and handed out again by
+ * AllocatePage before the file is extended. The bitmap is updated in place on
+ * every change, so allocation state survives a restart.
+ *
+ * Pages of one table heap or index can be kept physically together: an
+ * allocation given a hint page is served from an extent of EXTENT_SIZE
+ * contiguous pages reserved for the object the hint belongs to. Extent owners
+ * and fill levels are kept in a second side file (<name>.ext). Allocations
+ * without a hint are handed out one page at a time, as before.
+ *
+ * The durability mode decides when written pages are forced to disk:
+ * SYNC_EACH_WRITE issues an fdatasync after every write call, BATCHED stages
+ * writes in a write-behind buffer and writes and syncs them in groups of
+ * WRITE_BATCH_SIZE pages, and CHECKPOINT_ONLY leaves syncing to Sync() calls
+ * at checkpoints, relying on the log for everything in between.
+ *
+ * Pages can optionally be stored compressed with PageCodec. A compressed page
+ * still occupies its own slot in the file, but only its compressed bytes are
+ * written and read back, behind a small header holding their length and
+ * CRC32C. The slot thus describes itself: a page rewritten with another
+ * compressed length since the page map was last written is still decoded
+ * after a crash. The buffer pool only ever sees uncompressed pages.
+ *
+ * Every page write records a CRC32C of the stored bytes, and every read
+ * verifies it; a mismatch is counted and the read reports failure. Checksums
+ * of pages stored as is and compressed lengths live in a page map in a third
+ * side file (<name>.pmap), so page layouts need no checksum field of their
+ * own. Map entries are written back in runs at every sync, only for pages
+ * whose last write the sync of the db file covered. Before a page is
+ * overwritten as is, an entry on disk still holding a checksum is cleared
+ * and synced, so after a crash the map never checks a slot against the
+ * checksum of another version of the page; pages written since the last
+ * sync are then read unverified. This costs one map write and sync for the
+ * first write of a page, or a batch of pages, after every sync. Every sync
+ * covers the side files as well.
+ *
+ * In direct I/O mode the database file is opened with O_DIRECT, bypassing
+ * the kernel page cache so that the buffer pool is the only cache. Offsets
+ * and lengths must then be multiples of DIRECT_IO_ALIGNMENT, so the mode is
+ * only honoured when the page size is.
  */
 
 #pragma once
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <future>
+#include <map>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 
 namespace scudb {
 
+enum class DurabilityMode { SYNC_EACH_WRITE = 0, BATCHED, CHECKPOINT_ONLY };
+
+/**
+ * A single asynchronous page request. The caller keeps page_data alive until
+ * the future obtained from callback_ is ready.
+ */
+struct DiskRequest {
+  DiskRequest(bool is_write, page_id_t page_id, char *page_data)
+      : is_write_(is_write), page_id_(page_id), page_data_(page_data) {}
+
+  bool is_write_;
+  page_id_t page_id_;
+  char *page_data_;
+  std::promise<void> callback_;
+};
+
 class DiskManager {
 public:
-  DiskManager(const std::string &db_file);
-  ~DiskManager();
+  DiskManager(const std::string &db_file, bool direct_io = false,
+              size_t page_size = PAGE_SIZE);
+  virtual ~DiskManager();
+
+  virtual void WritePage(page_id_t page_id, const char *page_data);
+  // false if the page could not be read intact, e.g. on a checksum mismatch
+  virtual bool ReadPage(page_id_t page_id, char *page_data);
 
-  void WritePage(page_id_t page_id, const char *page_data);
-  void ReadPage(page_id_t page_id, char *page_data);
+  // force every page written so far to stable storage
+  virtual void Sync();
+  void SetDurabilityMode(DurabilityMode durability);
+  inline DurabilityMode GetDurabilityMode() const { return durability_; }
+  // system calls issued so far
+  inline int GetNumWriteCalls() const { return num_write_calls_; }
+  inline int GetNumReadCalls() const { return num_read_calls_; }
+  inline int GetNumSyncs() const { return num_syncs_; }
 
-  void WriteLog(char *log_data, int size);
-  bool ReadLog(char *log_data, int size, int offset);
+  // store pages written from now on compressed
+  inline void SetCompression(bool compress) { compress_ = compress; }
+  inline bool IsCompressed() const { return compress_; }
+  // bytes moved to and from the db file so far
+  inline uint64_t GetNumBytesRead() const { return num_bytes_read_; }
+  inline uint64_t GetNumBytesWritten() const { return num_bytes_written_; }
+  // pages whose contents did not match their checksum when read
+  inline int GetNumChecksumFailures() const { return num_checksum_failures_; }
 
-  page_id_t AllocatePage();
+  // multi-page I/O, each entry is a (page id, page buffer) pair
+  virtual void
+  WritePages(const std::vector<std::pair<page_id_t, char *>> &pages);
+  // false if any of the pages could not be read intact
+  virtual bool
+  ReadPages(const std::vector<std::pair<page_id_t, char *>> &pages);
+  inline int GetNumVectoredIOs() const { return num_vectored_ios_; }
+
+  // asynchronous page I/O, served by the background I/O workers
+  std::future<void> WritePageAsync(page_id_t page_id, const char *page_data);
+  std::future<void> ReadPageAsync(page_id_t page_id, char *page_data);
+  // submit many requests with a single wake-up of the I/O workers, the
+  // futures of each request must be taken before submission
+  void SubmitBatch(std::vector<DiskRequest> &requests);
+
+  virtual void WriteLog(char *log_data, int size);
+  virtual bool ReadLog(char *log_data, int size, int offset);
+
+  // allocate near hint_page_id, i.e. in the extent of the object owning it
+  page_id_t AllocatePage(page_id_t hint_page_id = INVALID_PAGE_ID);
   void DeallocatePage(page_id_t page_id);
+  // give back a page just allocated and never used, without leaving a hole
+  // in its extent if no page was handed out of the extent after it
+  void UnallocatePage(page_id_t page_id);
+  size_t GetNumFreePages();
+  // whether page_id was handed out by AllocatePage and not released since
+  bool IsAllocated(page_id_t page_id);
+  // release the disk blocks of deallocated pages with fallocate
+  inline void SetPunchHoles(bool punch_holes) { punch_holes_ = punch_holes; }
+
+  page_id_t GetExtentOwner(page_id_t page_id);
+
+  inline bool IsDirectIO() const { return direct_io_; }
+  inline size_t GetPageSize() const { return page_size_; }
 
   int GetNumFlushes() const;
   bool GetFlushState() const;
   inline void SetFlushLogFuture(std::future<void> *f) { flush_log_f_ = f; }
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
+protected:
+  // for backends without a db file; they start the I/O workers once they are
+  // set up and must stop them before they are torn down
+  explicit DiskManager(size_t page_size);
+  void StartIOWorkers();
+  void StopIOWorkers();
+
+  size_t page_size_;
+  // statistics, kept up to date by every backend
+  std::atomic<int> num_write_calls_;
+  std::atomic<int> num_read_calls_;
+  std::atomic<uint64_t> num_bytes_read_;
+  std::atomic<uint64_t> num_bytes_written_;
+  int num_flushes_;
+  bool flush_log_;
+  std::future<void> *flush_log_f_;
+
 private:
   int GetFileSize(const std::string &name);
+  void IOWorker();
+  void WritePageRaw(page_id_t page_id, const char *page_data);
+  bool ReadPageRaw(page_id_t page_id, char *page_data);
+  void FlushStaged();
+  void SyncFile();
+  bool VectoredIO(bool is_write,
+                  const std::vector<std::pair<page_id_t, char *>> &pages);
+  void LoadFreeMap();
+  void SetFree(page_id_t page_id, bool is_free);
+  void LoadExtentMap();
+  page_id_t AllocateInExtent(page_id_t owner);
+  void PersistExtent(size_t extent);
+  // how a page is stored on disk, one entry per page in the page map
+  struct PageMapEntry {
+    uint32_t checksum_;
+    uint16_t stored_len_; // compressed length with header, 0 if stored as is
+    uint16_t flags_;
+  };
+  static const uint16_t PAGE_CHECKSUMMED = 1;
+  // leads the slot of a compressed page
+  struct CompressedHeader {
+    uint16_t magic_;
+    uint16_t length_; // compressed bytes following the header
+    uint32_t checksum_;
+  };
+  static const uint16_t COMPRESSED_MAGIC = 0x5a43;
+
+  void LoadPageMap();
+  PageMapEntry GetPageMapEntry(page_id_t page_id);
+  void SetPageMapEntries(page_id_t first, const PageMapEntry *entries,
+                         size_t count);
+  void ClearPageMapEntries(
+      const std::vector<std::pair<page_id_t, PageMapEntry>> &pages);
+  std::vector<std::pair<page_id_t, PageMapEntry>> GetDirtyPageMapEntries();
+  void FlushPageMap(
+      const std::vector<std::pair<page_id_t, PageMapEntry>> &entries);
+  bool VerifyChecksum(page_id_t page_id, const PageMapEntry &entry,
+                      const char *stored_data);
+  size_t ReadSlot(page_id_t page_id, char *buf, size_t length);
+  bool GetCompressedHeader(const char *slot, CompressedHeader &header) const;
+  bool DecodeSlot(page_id_t page_id, const PageMapEntry &entry, char *slot,
+                  size_t read_count, char *dest);
+  size_t StoredBytes(size_t stored) const;
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  // descriptor of db file, read and written positionally
+  int db_fd_;
+  bool direct_io_;
   std::string file_name_;
   std::atomic<page_id_t> next_page_id_;
-  int num_flushes_;
-  bool flush_log_;
-  std::future<void> *flush_log_f_;
+  // free-page bitmap, its side file and the free pages as a stack
+  int fsm_fd_;
+  std::string fsm_name_;
+  std::vector<uint8_t> free_map_;
+  std::vector<page_id_t> free_pages_;
+  bool punch_holes_;
+  // per extent, the owning object (INVALID_PAGE_ID if not reserved or the
+  // object was dropped) and the number of pages handed out; plus the newest
+  // extent of every owner
+  struct ExtentInfo {
+    page_id_t owner_;
+    int32_t used_;
+  };
+  int ext_fd_;
+  std::string ext_name_;
+  std::vector<ExtentInfo> extents_;
+  std::unordered_map<page_id_t, size_t> owner_extent_;
+  std::atomic<bool> compress_;
+  int pmap_fd_;
+  std::string pmap_name_;
+  std::vector<PageMapEntry> page_map_;
+  std::set<page_id_t> pmap_dirty_; // entries not yet written back
+  std::vector<bool> pmap_armed_;   // entries on disk that verify a slot
+  std::mutex pmap_latch_;
+  std::atomic<int> num_checksum_failures_;
+  std::mutex alloc_latch_;
+  // write-behind buffer of the batched mode, ordered by page id
+  std::atomic<DurabilityMode> durability_;
+  std::map<page_id_t, std::vector<char>> staged_;
+  std::mutex stage_latch_;
+  std::atomic<int> num_syncs_;
+  std::atomic<int> num_vectored_ios_;
+  // pending asynchronous requests and the workers serving them
+  std::deque<DiskRequest> io_queue_;
+  std::mutex io_latch_;
+  std::condition_variable io_cv_;
+  std::vector<std::thread> io_workers_;
+  bool io_shutdown_;
 };
 
-} // namespace scudb
\ No newline at end of file
+} // namespace scudb
@@ -0,0 +1,41 @@
+/**
+ * memory_disk_manager.h
+ *
+ * A disk manager backend that keeps pages and log in memory, so that tests
+ * and benchmarks do not depend on the host's disk. Allocation works as for
+ * the file backend, but nothing survives the object.
+ */
+
+#pragma once
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "disk/disk_manager.h"
+
+namespace scudb {
+
+class MemoryDiskManager : public DiskManager {
+public:
+  explicit MemoryDiskManager(size_t page_size = PAGE_SIZE);
+  ~MemoryDiskManager();
+
+  void WritePage(page_id_t page_id, const char *page_data) override;
+  bool ReadPage(page_id_t page_id, char *page_data) override;
+  void
+  WritePages(const std::vector<std::pair<page_id_t, char *>> &pages) override;
+  bool
+  ReadPages(const std::vector<std::pair<page_id_t, char *>> &pages) override;
+  void Sync() override {}
+
+  void WriteLog(char *log_data, int size) override;
+  bool ReadLog(char *log_data, int size, int offset) override;
+
+private:
+  // page contents by page id, nullptr for pages never written
+  std::vector<std::unique_ptr<char[]>> pages_;
+  std::vector<char> log_;
+  std::mutex latch_;
+};
+
+} // namespace scudb
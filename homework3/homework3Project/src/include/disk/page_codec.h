@@ -0,0 +1,29 @@
+/**
+ * page_codec.h
+ *
+ * A small LZ77 codec in the style of LZ4, used to store pages compressed.
+ * Compressed data is a sequence of (literal run, back reference) pairs: a
+ * token byte holds the literal length in its high nibble and the match
+ * length minus MIN_MATCH in its low nibble, a nibble of 15 continues with
+ * extra length bytes of up to 255 each. Literals follow the token, then a
+ * 2-byte little-endian offset and the extra match length bytes. The last
+ * sequence has literals only.
+ */
+
+#pragma once
+#include <cstddef>
+
+namespace scudb {
+
+class PageCodec {
+public:
+  // compress src into dst, returns the compressed length or 0 if the result
+  // would not fit into dst_cap bytes
+  static size_t Compress(const char *src, size_t src_len, char *dst,
+                         size_t dst_cap);
+  // decompress into exactly dst_len bytes, false if src is malformed
+  static bool Decompress(const char *src, size_t src_len, char *dst,
+                         size_t dst_len);
+};
+
+} // namespace scudb
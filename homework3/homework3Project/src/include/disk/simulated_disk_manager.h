@@ -0,0 +1,62 @@
+/**
+ * simulated_disk_manager.h
+ *
+ * A disk manager backend that models a storage device on top of the memory
+ * backend. Every request is charged a fixed latency plus its transfer time
+ * at the device bandwidth; a request starting where the previous one ended
+ * pays the (lower) sequential latency instead. The charges add up on a
+ * simulated clock, which makes benchmarks deterministic. Optionally the
+ * calling thread also sleeps for the charged time.
+ */
+
+#pragma once
+#include <atomic>
+#include <mutex>
+
+#include "disk/memory_disk_manager.h"
+
+namespace scudb {
+
+struct DeviceProfile {
+  double read_latency_us_;       // random read
+  double write_latency_us_;      // random write
+  double sequential_latency_us_; // request following the previous one
+  double bandwidth_mb_s_;
+
+  // typical NVMe flash and a 7200 rpm disk
+  static DeviceProfile SSD() { return DeviceProfile{80, 20, 10, 2000}; }
+  static DeviceProfile HDD() { return DeviceProfile{8000, 8000, 50, 150}; }
+};
+
+class SimulatedDiskManager : public MemoryDiskManager {
+public:
+  SimulatedDiskManager(const DeviceProfile &profile,
+                       size_t page_size = PAGE_SIZE,
+                       bool inject_delay = false);
+
+  void WritePage(page_id_t page_id, const char *page_data) override;
+  bool ReadPage(page_id_t page_id, char *page_data) override;
+  void
+  WritePages(const std::vector<std::pair<page_id_t, char *>> &pages) override;
+  bool
+  ReadPages(const std::vector<std::pair<page_id_t, char *>> &pages) override;
+
+  // device time spent so far
+  inline uint64_t GetSimulatedNanos() const { return simulated_ns_; }
+  inline void ResetSimulatedClock() { simulated_ns_ = 0; }
+
+private:
+  void Charge(bool is_write, page_id_t first_page_id, size_t num_pages);
+  template <typename F>
+  void ForEachRun(const std::vector<std::pair<page_id_t, char *>> &pages,
+                  bool is_write, F io);
+
+  DeviceProfile profile_;
+  bool inject_delay_;
+  std::atomic<uint64_t> simulated_ns_;
+  // where the last request ended, to recognize sequential access
+  page_id_t head_page_id_;
+  std::mutex device_latch_;
+};
+
+} // namespace scudb
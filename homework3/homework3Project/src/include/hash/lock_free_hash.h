@@ -0,0 +1,52 @@
+/*
+ * lock_free_hash.h : open-addressing hash table with lock-free lookups
+ *
+ * Functionality: A fixed-capacity table with linear probing over atomic
+ * slots, meant for the buffer pool's page table. Find takes no lock and may
+ * run concurrently with a writer; Insert and Remove must be serialized by the
+ * caller (the buffer pool latch). A Find racing with a writer can miss a key,
+ * e.g. while tombstones are purged, but never returns a value that was not
+ * mapped to the key. Keys and values must be lock-free atomics, and two key
+ * values are reserved to mark empty and deleted slots.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "hash/hash_table.h"
+
+namespace scudb {
+
+template <typename K, typename V>
+class LockFreeHash : public HashTable<K, V> {
+  struct Slot {
+    std::atomic<K> key;
+    std::atomic<V> value;
+  };
+
+public:
+  // room for max_entries keys at once, empty_key and deleted_key are never
+  // inserted
+  LockFreeHash(size_t max_entries, const K &empty_key, const K &deleted_key);
+  // lookup and modifier
+  bool Find(const K &key, V &value) override;
+  bool Remove(const K &key) override;
+  void Insert(const K &key, const V &value) override;
+  inline size_t GetCapacity() const { return mask_ + 1; }
+
+private:
+  size_t HashKey(const K &key) const;
+  void PurgeDeleted();
+
+  std::unique_ptr<Slot[]> slots_;
+  size_t mask_;
+  size_t max_entries_;
+  K empty_key_;
+  K deleted_key_;
+  size_t num_entries_; // live keys
+  size_t num_used_;    // live keys plus tombstones
+};
+
+} // namespace scudb
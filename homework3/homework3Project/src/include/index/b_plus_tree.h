@@ -10,6 +10,7 @@
  */
 #pragma once
 
+#include <atomic>
 #include <queue>
 #include <vector>
 
@@ -67,7 +68,9 @@ public:
     bool Check(bool force = false);
     bool openCheck = true;
 private:
-    BPlusTreePage *FetchPage(page_id_t page_id);
+  // read crabbing down to the leaf, which is returned latched by the guard;
+  // the guard is empty if the tree is
+  ReadPageGuard FindLeafPageRead(const KeyType &key, bool leftMost);
   void StartNewTree(const KeyType &key, const ValueType &value);
 
   bool InsertIntoLeaf(const KeyType &key, const ValueType &value,
@@ -98,9 +101,11 @@ private:
 
   void UpdateRootPageId(int insert_record = false);
 
-  BPlusTreePage *CrabingProtocalFetchPage(page_id_t page_id,OpType op, page_id_t previous, Transaction *transaction);
+  // ref, if given, is the swizzled reference to page_id
+  Page *CrabingProtocalFetchPage(page_id_t page_id,OpType op, Page *previous, Transaction *transaction,
+                                 std::atomic<Page *> *ref = nullptr);
 
-  void FreePagesInTransaction(bool exclusive, Transaction *transaction, page_id_t cur = -1);
+  void FreePagesInTransaction(bool exclusive, Transaction *transaction, Page *cur = nullptr);
 
     void Lock(bool exclusive,Page * page) {
         if (exclusive) page->WLatch();
@@ -112,11 +117,6 @@ private:
         else page->RUnlatch();
     }
 
-    void Unlock(bool exclusive,page_id_t pageId) {
-        auto page = buffer_pool_manager_->FetchPage(pageId);
-        Unlock(exclusive,page);
-        buffer_pool_manager_->UnpinPage(pageId,exclusive);
-    }
     void LockRootPageId(bool exclusive) {
         if (exclusive) mutex_.WLock();
         else mutex_.RLock();
@@ -136,6 +136,9 @@ private:
   // member variable
   std::string index_name_;
   page_id_t root_page_id_;
+  // swizzled reference to the root's frame; inner pages keep theirs to
+  // their children in the buffer pool
+  std::atomic<Page *> root_frame_{nullptr};
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
   RWMutex mutex_;
@@ -3,6 +3,10 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include <memory>
+
+#include "buffer/page_guard.h"
+#include "buffer/readahead.h"
 #include "page/b_plus_tree_leaf_page.h"
 
 namespace scudb {
@@ -14,8 +18,10 @@ INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
 public:
   // you may define your own constructor based on your member variables
-  IndexIterator(B_PLUS_TREE_LEAF_PAGE_TYPE *leaf, int index, BufferPoolManager *bufferPoolManager);
-  ~IndexIterator();
+  // the iterator owns the read latched leaf, and releases it when it moves
+  // on or goes away
+  IndexIterator(ReadPageGuard leaf, int index, BufferPoolManager *bufferPoolManager);
+  IndexIterator(IndexIterator &&that) = default;
 
   bool isEnd();
 
@@ -26,10 +32,10 @@ public:
 private:
   // add your own private member variables here
   int idx_;
-  B_PLUS_TREE_LEAF_PAGE_TYPE *the_leaf_;
+  ReadPageGuard guard_;
+  const B_PLUS_TREE_LEAF_PAGE_TYPE *the_leaf_;
   BufferPoolManager *buffer_pool_manager_;
-
-  void UnlockAndUnPin();
+  std::shared_ptr<Readahead> readahead_; // along the leaf chain
 };
 
 } // namespace scudb
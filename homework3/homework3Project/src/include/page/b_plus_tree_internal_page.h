@@ -31,7 +31,8 @@ INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeInternalPage : public BPlusTreePage {
 public:
   // must call initialize method after "create" a new node
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID);
+  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID,
+            size_t page_size = PAGE_SIZE);
 
   KeyType KeyAt(int index) const;
   void SetKeyAt(int index, const KeyType &key);
@@ -39,6 +40,8 @@ public:
   ValueType ValueAt(int index) const;
 
   ValueType Lookup(const KeyType &key, const KeyComparator &comparator) const;
+  // slot of the child Lookup returns
+  int LookupIndex(const KeyType &key, const KeyComparator &comparator) const;
   void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key,
                        const ValueType &new_value);
   int InsertNodeAfter(const ValueType &old_value, const KeyType &new_key,
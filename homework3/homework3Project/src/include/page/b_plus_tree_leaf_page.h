@@ -34,13 +34,14 @@ class BPlusTreeLeafPage : public BPlusTreePage {
 public:
   // After creating a new leaf page from buffer pool, must call initialize
   // method to set default values
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID);
+  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID,
+            size_t page_size = PAGE_SIZE);
   // helper methods
   page_id_t GetNextPageId() const;
   void SetNextPageId(page_id_t next_page_id);
   KeyType KeyAt(int index) const;
   int KeyIndex(const KeyType &key, const KeyComparator &comparator) const;
-  const MappingType &GetItem(int index);
+  const MappingType &GetItem(int index) const;
 
   // insert and delete methods
   int Insert(const KeyType &key, const ValueType &value,
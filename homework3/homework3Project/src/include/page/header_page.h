@@ -3,12 +3,17 @@
  *
  * Database use the first page (page_id = 0) as header page to store metadata, in
  * our case, we will contain information about table/index name (length less than
- * 32 bytes) and their corresponding root_id
+ * 32 bytes) and their corresponding root_id. The header also records the page
+ * size the database was created with, so it can be reopened without knowing it,
+ * behind a magic number that tells this format from the older one, whose
+ * entries followed the record count directly.
  *
  * Format (size in byte):
- *  -----------------------------------------------------------------
- * | RecordCount (4) | Entry_1 name (32) | Entry_1 root_id (4) | ... |
- *  -----------------------------------------------------------------
+ *  --------------------------------------------------------------------------
+ * | RecordCount (4) | Magic (4) | PageSize (4) | Entry_1 name (32) | ... |
+ *  --------------------------------------------------------------------------
+ * | Entry_1 root_id (4) | ... |
+ *  ---------------------------
  */
 
 #pragma once
@@ -19,9 +24,20 @@
 
 namespace scudb {
 
+#define HEADER_MAGIC_OFFSET 4     // offset of the magic within header page
+#define HEADER_PAGE_SIZE_OFFSET 8 // offset of the page size within header page
+#define HEADER_MAGIC 0x42444353   // "SCDB", marks the format with a page size
+
 class HeaderPage : public Page {
 public:
-  void Init() { SetRecordCount(0); }
+  void Init(size_t page_size = PAGE_SIZE) {
+    SetRecordCount(0);
+    SetMagic();
+    SetPageSize(page_size);
+  }
+  // true if the page is in the current format, after converting one of the
+  // older format in place
+  bool CheckFormat();
   /**
    * Record related
    */
@@ -32,6 +48,7 @@ public:
   // return root_id if success
   bool GetRootId(const std::string &name, page_id_t &root_id);
   int GetRecordCount();
+  size_t GetPageSize();
 
 private:
   /**
@@ -40,5 +57,7 @@ private:
   int FindRecord(const std::string &name);
 
   void SetRecordCount(int record_count);
+  void SetMagic();
+  void SetPageSize(size_t page_size);
 };
 } // namespace scudb
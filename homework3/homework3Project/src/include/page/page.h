@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
 #include <iostream>
 
@@ -16,12 +18,15 @@
 
 namespace scudb {
 
+class BufferAccessStrategy;
+
 class Page {
   friend class BufferPoolManager;
+  static const int FRAME_CLAIMED = -1;
 
 public:
-  Page() { ResetMemory(); }
-  ~Page(){};
+  Page() {}
+  ~Page() { delete[] swizzled_.load(); }
   // get actual data page content
   inline char *GetData() { return data_; }
   // get page id
@@ -39,12 +44,25 @@ public:
 
 private:
   // method used by buffer pool manager
-  inline void ResetMemory() { memset(data_, 0, PAGE_SIZE); }
+  inline void ResetMemory(size_t page_size) { memset(data_, 0, page_size); }
   // members
-  char data_[PAGE_SIZE]; // actual data
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  int pin_count_ = 0;
-  bool is_dirty_ = false;
+  char *data_ = nullptr; // actual data, points into the buffer pool's frames
+  // atomic so that resident pages can be pinned without the buffer pool
+  // latch; a pin count of FRAME_CLAIMED marks a frame being reassigned
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+  std::atomic<int> pin_count_{0};
+  std::atomic<bool> is_dirty_{false};
+  // set while the frame is read or written back outside the buffer pool
+  // latch; threads needing the frame wait on io_cv_ with that latch
+  std::atomic<bool> io_in_progress_{false};
+  // the scan strategy whose ring holds the frame; such frames stay out of
+  // the replacer
+  std::atomic<BufferAccessStrategy *> ring_owner_{nullptr};
+  // child references of an inner page swizzled to the frames last holding
+  // the children, by slot, see FetchSwizzled; the page bytes keep page ids.
+  // Dropped when the frame is given to another page
+  std::atomic<std::atomic<Page *> *> swizzled_{nullptr};
+  std::condition_variable io_cv_;
   RWMutex rwlatch_;
 };
 
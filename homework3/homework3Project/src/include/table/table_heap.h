@@ -42,7 +42,9 @@ public:
                    Transaction *txn); // when commit delete or rollback insert
   void RollbackDelete(const RID &rid, Transaction *txn); // when rollback delete
 
-  bool GetTuple(const RID &rid, Tuple &tuple, Transaction *txn);
+  // scans pass their access strategy
+  bool GetTuple(const RID &rid, Tuple &tuple, Transaction *txn,
+                BufferAccessStrategy *strategy = nullptr);
 
   bool DeleteTableHeap();
 
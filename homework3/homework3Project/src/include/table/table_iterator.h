@@ -7,7 +7,9 @@
 #pragma once
 
 #include <cassert>
+#include <memory>
 
+#include "buffer/readahead.h"
 #include "common/rid.h"
 #include "table/tuple.h"
 
@@ -43,6 +45,9 @@ private:
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  // shared by copies; the scan's ring keeps it from flooding the pool
+  std::shared_ptr<BufferAccessStrategy> strategy_;
+  std::shared_ptr<Readahead> readahead_;
 };
 
 } // namespace scudb
\ No newline at end of file
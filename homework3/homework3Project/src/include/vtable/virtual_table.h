@@ -59,20 +59,32 @@ int VtabCommit(sqlite3_vtab *pVTab);
 
 int VtabBegin(sqlite3_vtab *pVTab);
 
+// SQL function vtable_buffer_pool_size([frames])
+void VtabBufferPoolSize(sqlite3_context *context, int argc,
+                        sqlite3_value **argv);
+
 // storage engine
 class StorageEngine {
 public:
-  StorageEngine(std::string db_file_name) {
+  StorageEngine(std::string db_file_name, size_t page_size = PAGE_SIZE,
+                DurabilityMode durability = DurabilityMode::CHECKPOINT_ONLY,
+                ReplacerPolicy policy = ReplacerPolicy::LRU,
+                FrameMemory memory = FrameMemory::DEFAULT,
+                size_t pool_size = BUFFER_POOL_SIZE,
+                size_t max_pool_size = BUFFER_POOL_MAX_SIZE) {
     ENABLE_LOGGING = false;
 
-    // storage related
-    disk_manager_ = new DiskManager(db_file_name);
+    // storage related, page_size only applies to a new database file
+    disk_manager_ = new DiskManager(db_file_name, false, page_size);
+    disk_manager_->SetDurabilityMode(durability);
 
     // log related
     log_manager_ = new LogManager(disk_manager_);
 
+    // the pool can be resized up to max_pool_size while in use
     buffer_pool_manager_ =
-        new BufferPoolManager(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
+        new BufferPoolManager(pool_size, disk_manager_, log_manager_, policy,
+                              memory, false, max_pool_size);
 
     // txn related
     lock_manager_ = new LockManager(true); // S2PL
@@ -82,8 +94,10 @@ public:
   ~StorageEngine() {
     if (ENABLE_LOGGING)
       log_manager_->StopFlushThread();
-    delete disk_manager_;
+    buffer_pool_manager_->FlushAllPages();
+    // the pool's prefetch worker may still read through the disk manager
     delete buffer_pool_manager_;
+    delete disk_manager_;
     delete log_manager_;
     delete lock_manager_;
     delete transaction_manager_;
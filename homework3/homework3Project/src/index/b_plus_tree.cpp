@@ -3,6 +3,7 @@
  */
 #include <iostream>
 #include <string>
+#include <utility>
 
 #include "common/exception.h"
 #include "common/logger.h"
@@ -43,15 +44,13 @@ INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::GetValue(const KeyType &key,
                               std::vector<ValueType> &result,
                               Transaction *transaction) {
-    //首先，找到目标页
-    auto *this_leaf = FindLeafPage(key, false, OpType::READ, transaction);
-    if(this_leaf == nullptr) return false;
+    //首先，找到目标页，离开时由guard解锁
+    ReadPageGuard guard = FindLeafPageRead(key, false);
+    if(!guard.IsValid()) return false;
     //然后，找到目标值
     result.resize(1);
-    auto state = this_leaf->Lookup(key, result[0], comparator_);
-    //后续收尾工作
-    FreePagesInTransaction(false, transaction, this_leaf->GetPageId());
-    return state;
+    return guard.As<B_PLUS_TREE_LEAF_PAGE_TYPE>()->Lookup(key, result[0],
+                                                          comparator_);
 }
 
 /*****************************************************************************
@@ -89,15 +88,14 @@ INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value)
 {
     //首先，从buffer池里找新页
-    Page *page = buffer_pool_manager_->NewPage(root_page_id_);
-    auto root = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+    BasicPageGuard page = buffer_pool_manager_->NewPageGuarded(root_page_id_);
+    auto root = page.AsMut<B_PLUS_TREE_LEAF_PAGE_TYPE>();
     //然后，更新树的根page id
     UpdateRootPageId(true);
-    root->Init(root_page_id_, INVALID_PAGE_ID);
+    root->Init(root_page_id_, INVALID_PAGE_ID,
+               buffer_pool_manager_->GetPageSize());
     //最后，插入键值
     root->Insert(key, value, comparator_);
-    //后续收尾工作
-    buffer_pool_manager_->UnpinPage(root_page_id_, true);
 }
 
 /*
@@ -144,12 +142,14 @@ template <typename N> N *BPLUSTREE_TYPE::Split(N *node, Transaction *transaction
 {
     //首先，在buffer池中找新页
     page_id_t page_id;
-    Page* const page = buffer_pool_manager_->NewPage(page_id);
+    Page* const page =
+        buffer_pool_manager_->NewPage(page_id, node->GetPageId());
     page->WLatch();
     transaction->AddIntoPageSet(page);
     //然后把一半的键值对移动到新页里
     auto new_node = reinterpret_cast<N *>(page->GetData());
-    new_node->Init(page_id);
+    new_node->Init(page_id, INVALID_PAGE_ID,
+                   buffer_pool_manager_->GetPageSize());
     node->MoveHalfTo(new_node, buffer_pool_manager_);
     //返回新节点
     return new_node;
@@ -174,25 +174,24 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node,
     if(old_node->IsRootPage())
     {
         //找新页
-        auto *page = buffer_pool_manager_->NewPage(root_page_id_);
-        auto root = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(page->GetData());
-        root->Init(root_page_id_);
+        BasicPageGuard page = buffer_pool_manager_->NewPageGuarded(
+                root_page_id_, old_node->GetPageId());
+        auto root = page.AsMut<B_PLUS_TREE_INTERNAL_PAGE>();
+        root->Init(root_page_id_, INVALID_PAGE_ID,
+                   buffer_pool_manager_->GetPageSize());
         root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
         //更新父母节点page id
         old_node->SetParentPageId(root_page_id_);
         new_node->SetParentPageId(root_page_id_);
         //更新根节点page id
         UpdateRootPageId();
-
-        buffer_pool_manager_->UnpinPage(root->GetPageId(), true);
-
     }
     else
     {
         //否则，按一般情况处理
         page_id_t parent_id = old_node->GetParentPageId();
-        auto *page = FetchPage(parent_id);
-        auto *parent = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(page);
+        BasicPageGuard page = buffer_pool_manager_->FetchPageBasic(parent_id);
+        auto *parent = page.AsMut<B_PLUS_TREE_INTERNAL_PAGE>();
         new_node->SetParentPageId(parent_id);
         //把新节点插入旧节点后面
         parent->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
@@ -201,7 +200,6 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node,
             auto *new_leaf = Split(parent, transaction);
             InsertIntoParent(parent, new_leaf->KeyAt(0), new_leaf, transaction);
         }
-        buffer_pool_manager_->UnpinPage(parent_id, true);
     }
 }
 
@@ -247,37 +245,35 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
     //一般情况时，先找兄弟节点和父母节点
     N *node2;
     bool isRightSib = FindLeftSibling(node,node2,transaction);
-    BPlusTreePage *parent = FetchPage(node->GetParentPageId());
-    B_PLUS_TREE_INTERNAL_PAGE *parentPage = static_cast<B_PLUS_TREE_INTERNAL_PAGE *>(parent);
+    BasicPageGuard parent = buffer_pool_manager_->FetchPageBasic(node->GetParentPageId());
+    B_PLUS_TREE_INTERNAL_PAGE *parentPage = parent.AsMut<B_PLUS_TREE_INTERNAL_PAGE>();
     //此时合并两节点
     if (node->GetSize() + node2->GetSize() <= node->GetMaxSize()) {
         if (isRightSib) {swap(node,node2);} //assumption node is after node2
         int removeIndex = parentPage->ValueIndex(node->GetPageId());
         Coalesce(node2,node,parentPage,removeIndex,transaction);//unpin node,node2
-        buffer_pool_manager_->UnpinPage(parentPage->GetPageId(), true);
         return true;
     }
     //此时调用重新分配函数
     int nodeInParentIndex = parentPage->ValueIndex(node->GetPageId());
     Redistribute(node2,node,nodeInParentIndex);//unpin node,node2
-    buffer_pool_manager_->UnpinPage(parentPage->GetPageId(), false);
     return false;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 bool BPLUSTREE_TYPE::FindLeftSibling(N *node, N * &sibling, Transaction *transaction) {
-    auto page = FetchPage(node->GetParentPageId());
-    B_PLUS_TREE_INTERNAL_PAGE *parent = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(page);
+    BasicPageGuard page = buffer_pool_manager_->FetchPageBasic(node->GetParentPageId());
+    auto parent = page.As<B_PLUS_TREE_INTERNAL_PAGE>();
     int index = parent->ValueIndex(node->GetPageId());
     int siblingIndex = index - 1;
     //此时说明没有左兄弟节点
     if (index == 0) {
         siblingIndex = index + 1;
     }
-    sibling = reinterpret_cast<N *>(CrabingProtocalFetchPage(
-            parent->ValueAt(siblingIndex),OpType::DELETE,-1,transaction));
-    buffer_pool_manager_->UnpinPage(parent->GetPageId(), false);
+    Page *siblingPage = CrabingProtocalFetchPage(
+            parent->ValueAt(siblingIndex),OpType::DELETE,nullptr,transaction);
+    sibling = reinterpret_cast<N *>(siblingPage->GetData());
     //为真，说明是右兄弟节点
     return index == 0;
 }
@@ -357,10 +353,8 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node)
         root_page_id_ = root->RemoveAndReturnOnlyChild();
         UpdateRootPageId();
 
-        auto *page = buffer_pool_manager_->FetchPage(root_page_id_);
-        auto new_root = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE_TYPE *>(page->GetData());
-        new_root->SetParentPageId(INVALID_PAGE_ID);
-        buffer_pool_manager_->UnpinPage(root_page_id_, true);
+        BasicPageGuard page = buffer_pool_manager_->FetchPageBasic(root_page_id_);
+        page.AsMut<BPlusTreePage>()->SetParentPageId(INVALID_PAGE_ID);
         return true;
     }
     return false;
@@ -378,8 +372,8 @@ INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin()
 {
   KeyType key;
-  TryUnlockRootPageId(false);
-  return INDEXITERATOR_TYPE(FindLeafPage(key, true), 0, buffer_pool_manager_);
+  return INDEXITERATOR_TYPE(FindLeafPageRead(key, true), 0,
+                            buffer_pool_manager_);
 }
 
 /*
@@ -389,11 +383,11 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin()
  */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
-  auto *leaf = FindLeafPage(key);
-  TryUnlockRootPageId(false);
+  ReadPageGuard leaf = FindLeafPageRead(key, false);
   int idx = 0;
-  if (leaf != nullptr) idx = leaf->KeyIndex(key, comparator_);
-  return INDEXITERATOR_TYPE(leaf, idx, buffer_pool_manager_);
+  if (leaf.IsValid())
+    idx = leaf.As<B_PLUS_TREE_LEAF_PAGE_TYPE>()->KeyIndex(key, comparator_);
+  return INDEXITERATOR_TYPE(std::move(leaf), idx, buffer_pool_manager_);
 }
 
 /*****************************************************************************
@@ -416,52 +410,87 @@ B_PLUS_TREE_LEAF_PAGE_TYPE *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
     return nullptr;
   }
 
-  auto ptr = CrabingProtocalFetchPage(root_page_id_, op, -1, transaction);
-  page_id_t next;
-  for (page_id_t cur = root_page_id_; !ptr->IsLeafPage(); ptr = CrabingProtocalFetchPage(next,op,cur,transaction),cur = next)
+  Page *pg = CrabingProtocalFetchPage(root_page_id_, op, nullptr, transaction,
+                                      &root_frame_);
+  auto ptr = reinterpret_cast<BPlusTreePage *>(pg->GetData());
+  while (!ptr->IsLeafPage())
   {
     B_PLUS_TREE_INTERNAL_PAGE *internalPage = static_cast<B_PLUS_TREE_INTERNAL_PAGE *>(ptr);
-    if (leftMost) next = internalPage->ValueAt(0);
-    else next = internalPage->Lookup(key,comparator_);
+    int slot = leftMost ? 0 : internalPage->LookupIndex(key, comparator_);
+    pg = CrabingProtocalFetchPage(internalPage->ValueAt(slot), op, pg,
+                                  transaction,
+                                  buffer_pool_manager_->GetChildRef(pg, slot));
+    ptr = reinterpret_cast<BPlusTreePage *>(pg->GetData());
   }
 
   return static_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(ptr);
 }
 
+/*
+ * Read-only descent for lookups and iterators. Each level is fetched and
+ * latched once; assigning the child's guard releases the parent after the
+ * child is latched. The root page id stays locked until the root is latched.
+ * The root and every child are reached through swizzled references, so a
+ * descent through resident pages takes no page table lookups
+ */
 INDEX_TEMPLATE_ARGUMENTS
-BPlusTreePage *BPLUSTREE_TYPE::FetchPage(page_id_t page_id)
-{
-  auto pg = buffer_pool_manager_->FetchPage(page_id);
-  return reinterpret_cast<BPlusTreePage *>(pg->GetData());
+ReadPageGuard BPLUSTREE_TYPE::FindLeafPageRead(const KeyType &key,
+                                               bool leftMost) {
+  LockRootPageId(false);
+  if (IsEmpty())
+  {
+    TryUnlockRootPageId(false);
+    return ReadPageGuard();
+  }
+  ReadPageGuard guard =
+      buffer_pool_manager_->FetchSwizzledRead(root_page_id_, &root_frame_);
+  TryUnlockRootPageId(false);
+  auto ptr = guard.As<BPlusTreePage>();
+  while (!ptr->IsLeafPage())
+  {
+    auto internalPage = static_cast<const B_PLUS_TREE_INTERNAL_PAGE *>(ptr);
+    int slot = leftMost ? 0 : internalPage->LookupIndex(key, comparator_);
+    guard = buffer_pool_manager_->FetchSwizzledRead(
+        internalPage->ValueAt(slot),
+        buffer_pool_manager_->GetChildRef(guard.GetPage(), slot));
+    ptr = guard.As<BPlusTreePage>();
+  }
+  return guard;
 }
+
 INDEX_TEMPLATE_ARGUMENTS
-BPlusTreePage *BPLUSTREE_TYPE::CrabingProtocalFetchPage(page_id_t page_id,OpType op,page_id_t previous, Transaction *transaction) {
+Page *BPLUSTREE_TYPE::CrabingProtocalFetchPage(page_id_t page_id,OpType op,Page *previous, Transaction *transaction,
+                                               std::atomic<Page *> *ref) {
   bool exclusive = (op != OpType::READ);
-  auto pg = buffer_pool_manager_->FetchPage(page_id);
+  auto pg = buffer_pool_manager_->FetchSwizzled(page_id, ref);
   Lock(exclusive, pg);
 
   auto treePage = reinterpret_cast<BPlusTreePage *>(pg->GetData());
-  if (previous > 0 && (!exclusive || treePage->IsSafe(op)))
+  if (previous != nullptr && (!exclusive || treePage->IsSafe(op)))
     FreePagesInTransaction(exclusive,transaction,previous);
   if (transaction != nullptr) transaction->AddIntoPageSet(pg);
 
-  return treePage;
+  return pg;
 }
 
+/*
+ * Pages are unpinned through their frames, which they still hold, so
+ * releasing them needs no page table lookups
+ */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::FreePagesInTransaction(bool exclusive, Transaction *transaction, page_id_t cur) {
+void BPLUSTREE_TYPE::FreePagesInTransaction(bool exclusive, Transaction *transaction, Page *cur) {
   TryUnlockRootPageId(exclusive);
   if (transaction == nullptr)
   {
-    Unlock(false,cur);
-    buffer_pool_manager_->UnpinPage(cur,false);
+    Unlock(exclusive,cur);
+    buffer_pool_manager_->UnpinPage(cur,exclusive);
   }
   else{
       for (Page *pg : *transaction->GetPageSet())
       {
           int pid = pg->GetPageId();
           Unlock(exclusive, pg);
-          buffer_pool_manager_->UnpinPage(pid, exclusive);
+          buffer_pool_manager_->UnpinPage(pg, exclusive);
           if (transaction->GetDeletedPageSet()->find(pid) != transaction->GetDeletedPageSet()->end())
           {
               buffer_pool_manager_->DeletePage(pid);
@@ -483,12 +512,13 @@ void BPLUSTREE_TYPE::FreePagesInTransaction(bool exclusive, Transaction *transac
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record)
 {
-  HeaderPage *hdPage = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+  // latched, the header page is shared by all indexes
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(HEADER_PAGE_ID);
+  HeaderPage *hdPage = static_cast<HeaderPage *>(guard.GetPage());
+  guard.SetDirty();
 
   if (insert_record) hdPage->InsertRecord(index_name_, root_page_id_);
   else hdPage->UpdateRecord(index_name_, root_page_id_);
-
-  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
 /*
@@ -500,12 +530,12 @@ std::string BPLUSTREE_TYPE::ToString(bool verbose) {
   if (IsEmpty()) return "Empty tree";
   std::queue<BPlusTreePage *> todo, tmp;
   std::stringstream tree;
-  auto node = reinterpret_cast<BPlusTreePage *>(
-          buffer_pool_manager_->FetchPage(root_page_id_));
-  if (node == nullptr) {
+  auto root = buffer_pool_manager_->FetchPage(root_page_id_);
+  if (root == nullptr) {
     throw Exception(EXCEPTION_TYPE_INDEX,
                     "all page are pinned while printing");
   }
+  auto node = reinterpret_cast<BPlusTreePage *>(root->GetData());
   todo.push(node);
   bool first = true;
   while (!todo.empty()) {
@@ -579,12 +609,13 @@ void BPLUSTREE_TYPE::RemoveFromFile(const std::string &file_name,
 INDEX_TEMPLATE_ARGUMENTS
 int BPLUSTREE_TYPE::isBalanced(page_id_t pid) {
   if (IsEmpty()) return true;
-  auto node = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(pid));
+  BasicPageGuard page = buffer_pool_manager_->FetchPageBasic(pid);
+  auto node = page.As<BPlusTreePage>();
 
   int res = 0;
   if (!node->IsLeafPage())
   {
-    auto pg = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(node);
+    auto pg = reinterpret_cast<const B_PLUS_TREE_INTERNAL_PAGE *>(node);
     int last = -2;
     for (int i = 0; i < pg->GetSize(); i++)
     {
@@ -600,7 +631,6 @@ int BPLUSTREE_TYPE::isBalanced(page_id_t pid) {
       }
     }
   }
-  buffer_pool_manager_->UnpinPage(pid,false);
   return res;
 }
 
@@ -608,12 +638,13 @@ int BPLUSTREE_TYPE::isBalanced(page_id_t pid) {
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::isPageCorr(page_id_t pid,pair<KeyType,KeyType> &out) {
   if (IsEmpty()) return true;
-  auto node = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(pid));
+  BasicPageGuard page = buffer_pool_manager_->FetchPageBasic(pid);
+  auto node = page.As<BPlusTreePage>();
 
   bool res = true;
   if (node->IsLeafPage())
   {
-    auto pg = reinterpret_cast<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *>(node);
+    auto pg = reinterpret_cast<const BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *>(node);
     int size = pg->GetSize();
       res = res && (size >= node->GetMinSize() && size <= node->GetMaxSize());
     for (int i = 1; i < size; i++)
@@ -627,7 +658,7 @@ bool BPLUSTREE_TYPE::isPageCorr(page_id_t pid,pair<KeyType,KeyType> &out) {
     out = pair<KeyType,KeyType>{pg->KeyAt(0), pg->KeyAt(size - 1)};
   }
   else {
-    auto pg = reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(node);
+    auto pg = reinterpret_cast<const BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(node);
     int siz = pg->GetSize();
       res = res && (siz >= node->GetMinSize() && siz <= node->GetMaxSize());
     pair<KeyType,KeyType> left,right;
@@ -644,7 +675,6 @@ bool BPLUSTREE_TYPE::isPageCorr(page_id_t pid,pair<KeyType,KeyType> &out) {
     }
     out = pair<KeyType,KeyType>{pg->KeyAt(0), pg->KeyAt(siz - 1)};
   }
-  buffer_pool_manager_->UnpinPage(pid,false);
   return res;
 }
 
@@ -2,6 +2,7 @@
  * index_iterator.cpp
  */
 #include <cassert>
+#include <utility>
 
 #include "index/index_iterator.h"
 
@@ -12,23 +13,15 @@ namespace scudb {
  * set your own input parameters
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::IndexIterator(B_PLUS_TREE_LEAF_PAGE_TYPE *leaf, int index, BufferPoolManager *bufferPoolManager): idx_(index),the_leaf_(leaf), buffer_pool_manager_(bufferPoolManager){}
-
-INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::~IndexIterator() {
+INDEXITERATOR_TYPE::IndexIterator(ReadPageGuard leaf, int index, BufferPoolManager *bufferPoolManager): idx_(index), guard_(std::move(leaf)),
+    the_leaf_(guard_.IsValid() ? guard_.As<B_PLUS_TREE_LEAF_PAGE_TYPE>() : nullptr),
+    buffer_pool_manager_(bufferPoolManager),
+    readahead_(std::make_shared<Readahead>(bufferPoolManager)) {
     if (the_leaf_ != nullptr) {
-        UnlockAndUnPin();
+        readahead_->Advance(guard_.GetPageId());
     }
 }
 
-INDEX_TEMPLATE_ARGUMENTS
-void INDEXITERATOR_TYPE::UnlockAndUnPin()
-{
-    buffer_pool_manager_->FetchPage(the_leaf_->GetPageId())->RUnlatch();
-    buffer_pool_manager_->UnpinPage(the_leaf_->GetPageId(), false);
-    buffer_pool_manager_->UnpinPage(the_leaf_->GetPageId(), false);
-}
-
 INDEX_TEMPLATE_ARGUMENTS
 bool IndexIterator<KeyType, ValueType, KeyComparator>::isEnd()
 {
@@ -54,15 +47,12 @@ IndexIterator<KeyType, ValueType, KeyComparator> &IndexIterator<KeyType, ValueTy
     {
         page_id_t  nextPageId = the_leaf_->GetNextPageId();
 
-        auto *pg = buffer_pool_manager_->FetchPage(nextPageId);
-
-        pg->RLatch();
-        UnlockAndUnPin();
-
-        auto nextLeaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(pg->GetData());
+        readahead_->Advance(nextPageId);
+        // the next leaf is latched before this one is released
+        guard_ = buffer_pool_manager_->FetchPageRead(nextPageId);
 
         idx_ = 0;
-        the_leaf_ = nextLeaf;
+        the_leaf_ = guard_.As<B_PLUS_TREE_LEAF_PAGE_TYPE>();
     }
     return *this;
 }
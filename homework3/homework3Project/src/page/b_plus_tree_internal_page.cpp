@@ -14,17 +14,18 @@ namespace scudb {
 /*
  * Init method after creating a new internal page
  * Including set page type, set current size, set page id, set parent id and set
- * max page size
+ * max page size, derived from the size of the page holding this node
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id,
-                                          page_id_t parent_id) {
+                                          page_id_t parent_id,
+                                          size_t page_size) {
     SetParentPageId(parent_id);
     SetPageId(page_id);
 
     SetPageType(IndexPageType::INTERNAL_PAGE);
 
-    int max_size = (PAGE_SIZE - sizeof(BPlusTreeInternalPage)) / sizeof(MappingType) - 1;
+    int max_size = (page_size - sizeof(BPlusTreeInternalPage)) / sizeof(MappingType) - 1;
     SetMaxSize(max_size);
     SetSize(0);
 }
@@ -86,6 +87,12 @@ INDEX_TEMPLATE_ARGUMENTS
 ValueType
 B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key,
                                        const KeyComparator &comparator) const {
+    return array[LookupIndex(key, comparator)].second;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::LookupIndex(
+    const KeyType &key, const KeyComparator &comparator) const {
     assert(GetSize() > 1);
     int l = 1, r = GetSize() - 1;
     while(l <= r)
@@ -96,7 +103,7 @@ B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key,
         else
             r = mid - 1;
     }
-    return array[l-1].second;
+    return l - 1;
 }
 
 /*****************************************************************************
@@ -169,10 +176,8 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(
 //        recipient->array[i - now].first = array[i].first;
 //        recipient->array[i - now].second = array[i].second;
 
-        auto thisOLdPage = buffer_pool_manager->FetchPage(array[i].second);
-        BPlusTreePage *thisNewPage = reinterpret_cast<BPlusTreePage *>(thisOLdPage->GetData());
-        thisNewPage->SetParentPageId(newPageId);
-        buffer_pool_manager->UnpinPage(array[i].second, true);
+        BasicPageGuard child = buffer_pool_manager->FetchPageBasic(array[i].second);
+        child.AsMut<BPlusTreePage>()->SetParentPageId(newPageId);
     }
 
     SetSize(now);
@@ -231,11 +236,11 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(
     int start = recipient->GetSize();
     page_id_t recipPageId = recipient->GetPageId();
     // 首先找到父母节点
-    Page *page = buffer_pool_manager->FetchPage(GetParentPageId());
-    assert(page != nullptr);
-    BPlusTreeInternalPage *parent = reinterpret_cast<BPlusTreeInternalPage *>(page->GetData());
-    SetKeyAt(0, parent->KeyAt(index_in_parent));
-    buffer_pool_manager->UnpinPage(parent->GetPageId(), false);
+    {
+        BasicPageGuard parent = buffer_pool_manager->FetchPageBasic(GetParentPageId());
+        assert(parent.IsValid());
+        SetKeyAt(0, parent.As<BPlusTreeInternalPage>()->KeyAt(index_in_parent));
+    }
 
     //把键值复制到新节点
     for (int i = 0; i < GetSize(); ++i) {
@@ -243,10 +248,8 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(
 //        recipient->array[start + i].first = array[i].first;
 //        recipient->array[start + i].second = array[i].second;
         //更新子节点的父母节点
-        auto childRawPage = buffer_pool_manager->FetchPage(array[i].second);
-        BPlusTreePage *childTreePage = reinterpret_cast<BPlusTreePage *>(childRawPage->GetData());
-        childTreePage->SetParentPageId(recipPageId);
-        buffer_pool_manager->UnpinPage(array[i].second,true);
+        BasicPageGuard child = buffer_pool_manager->FetchPageBasic(array[i].second);
+        child.AsMut<BPlusTreePage>()->SetParentPageId(recipPageId);
     }
     //更新Size值
     recipient->SetSize(start + GetSize());
@@ -284,16 +287,13 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(
 
     //更新page id
     page_id_t cPageId = pair.second;
-    Page *pg = buffer_pool_manager->FetchPage(cPageId);
-    BPlusTreePage *childPtr = reinterpret_cast<BPlusTreePage *>(pg->GetData());
-    childPtr->SetParentPageId(recipient->GetPageId());
-    buffer_pool_manager->UnpinPage(childPtr->GetPageId(), true);
+    BasicPageGuard child = buffer_pool_manager->FetchPageBasic(cPageId);
+    child.AsMut<BPlusTreePage>()->SetParentPageId(recipient->GetPageId());
 
     //更新相关的键值
-    pg = buffer_pool_manager->FetchPage(GetParentPageId());
-    B_PLUS_TREE_INTERNAL_PAGE_TYPE *parent = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE_TYPE *>(pg->GetData());
+    BasicPageGuard pg = buffer_pool_manager->FetchPageBasic(GetParentPageId());
+    auto parent = pg.AsMut<B_PLUS_TREE_INTERNAL_PAGE_TYPE>();
     parent->SetKeyAt(parent->ValueIndex(GetPageId()), array[0].first);
-    buffer_pool_manager->UnpinPage(GetParentPageId(), true);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -331,17 +331,14 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(
     array[0] = pair;
     // 更新page id
     page_id_t childPid = pair.second;
-    Page *pg = buffer_pool_manager->FetchPage(childPid);
-    assert (pg != nullptr);
-    BPlusTreePage *child = reinterpret_cast<BPlusTreePage *>(pg->GetData());
+    BasicPageGuard pg = buffer_pool_manager->FetchPageBasic(childPid);
+    assert (pg.IsValid());
+    BPlusTreePage *child = pg.AsMut<BPlusTreePage>();
     child->SetParentPageId(GetPageId());
     assert(child->GetParentPageId() == GetPageId());
-    buffer_pool_manager->UnpinPage(child->GetPageId(), true);
     //更新相关键值
-    pg = buffer_pool_manager->FetchPage(GetParentPageId());
-    B_PLUS_TREE_INTERNAL_PAGE *parent = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(pg->GetData());
-    parent->SetKeyAt(parent_index, pair.first);
-    buffer_pool_manager->UnpinPage(GetParentPageId(), true);
+    pg = buffer_pool_manager->FetchPageBasic(GetParentPageId());
+    pg.AsMut<B_PLUS_TREE_INTERNAL_PAGE>()->SetKeyAt(parent_index, pair.first);
 }
 
 /*****************************************************************************
@@ -18,10 +18,12 @@ namespace scudb {
 /**
  * Init method after creating a new leaf page
  * Including set page type, set current size to zero, set page id/parent id, set
- * next page id and set max size
+ * next page id and set max size, derived from the size of the page holding
+ * this node
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id)
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id,
+                                      size_t page_size)
 {
     SetPageType(IndexPageType::LEAF_PAGE);
     SetSize(0);
@@ -29,7 +31,7 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id)
     SetParentPageId(parent_id);
     SetNextPageId(INVALID_PAGE_ID);
 
-    int theSize = (PAGE_SIZE - sizeof(BPlusTreeLeafPage)) / sizeof(MappingType) - 1;
+    int theSize = (page_size - sizeof(BPlusTreeLeafPage)) / sizeof(MappingType) - 1;
     SetMaxSize(theSize);
 }
 
@@ -78,7 +80,7 @@ KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const
  * "index"(a.k.a array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-const MappingType &B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index)
+const MappingType &B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) const
 {
   return array[index];
 }
@@ -237,10 +239,9 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(
     memmove(array, array + 1, static_cast<size_t>(GetSize()*sizeof(MappingType)));
     recipient->CopyLastFrom(theItem);
     //更新相关的键值
-    auto *pg = buffer_pool_manager->FetchPage(GetParentPageId());
-    auto parent = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(pg->GetData());
+    BasicPageGuard pg = buffer_pool_manager->FetchPageBasic(GetParentPageId());
+    auto parent = pg.AsMut<B_PLUS_TREE_INTERNAL_PAGE>();
     parent->SetKeyAt(parent->ValueIndex(GetPageId()), theItem.first);
-    buffer_pool_manager->UnpinPage(GetParentPageId(), true);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -275,10 +276,8 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(
     array[0] = item;
 
     //更新父母节点键值
-    auto *pg = buffer_pool_manager->FetchPage(GetParentPageId());
-    auto parent = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(pg->GetData());
-    parent->SetKeyAt(parentIndex, item.first);
-    buffer_pool_manager->UnpinPage(GetParentPageId(), true);
+    BasicPageGuard pg = buffer_pool_manager->FetchPageBasic(GetParentPageId());
+    pg.AsMut<B_PLUS_TREE_INTERNAL_PAGE>()->SetKeyAt(parentIndex, item.first);
 }
 
 /*****************************************************************************
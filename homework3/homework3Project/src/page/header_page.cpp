@@ -8,6 +8,33 @@
 
 namespace scudb {
 
+// records follow the record count, the magic and the page size
+#define RECORDS_OFFSET 12
+#define RECORD_SIZE 36
+// records of the format without magic followed the record count
+#define LEGACY_RECORDS_OFFSET 4
+
+/*
+ * A header page without the magic comes from a database created before the
+ * page size was recorded, i.e. with the default page size. Its records move
+ * behind the new fields; a record count that cannot be moved means the page
+ * is not a header page at all
+ */
+bool HeaderPage::CheckFormat() {
+  uint32_t magic;
+  memcpy(&magic, GetData() + HEADER_MAGIC_OFFSET, 4);
+  if (magic == HEADER_MAGIC)
+    return true;
+  int record_num = GetRecordCount();
+  if (record_num < 0 || record_num > (PAGE_SIZE - RECORDS_OFFSET) / RECORD_SIZE)
+    return false;
+  memmove(GetData() + RECORDS_OFFSET, GetData() + LEGACY_RECORDS_OFFSET,
+          record_num * RECORD_SIZE);
+  SetMagic();
+  SetPageSize(PAGE_SIZE);
+  return true;
+}
+
 /**
  * Record related
  */
@@ -17,7 +44,7 @@ bool HeaderPage::InsertRecord(const std::string &name,
   assert(root_id > INVALID_PAGE_ID);
 
   int record_num = GetRecordCount();
-  int offset = 4 + record_num * 36;
+  int offset = RECORDS_OFFSET + record_num * RECORD_SIZE;
   // check for duplicate name
   if (FindRecord(name) != -1)
     return false;
@@ -37,9 +64,9 @@ bool HeaderPage::DeleteRecord(const std::string &name) {
   // record does not exsit
   if (index == -1)
     return false;
-  int offset = index * 36 + 4;
-  memmove(GetData() + offset, GetData() + offset + 36,
-          (record_num - index - 1) * 36);
+  int offset = RECORDS_OFFSET + index * RECORD_SIZE;
+  memmove(GetData() + offset, GetData() + offset + RECORD_SIZE,
+          (record_num - index - 1) * RECORD_SIZE);
 
   SetRecordCount(record_num - 1);
   return true;
@@ -53,7 +80,7 @@ bool HeaderPage::UpdateRecord(const std::string &name,
   // record does not exsit
   if (index == -1)
     return false;
-  int offset = index * 36 + 4;
+  int offset = RECORDS_OFFSET + index * RECORD_SIZE;
   // update record content, only root_id
   memcpy((GetData() + offset + 32), &root_id, 4);
 
@@ -67,7 +94,7 @@ bool HeaderPage::GetRootId(const std::string &name, page_id_t &root_id) {
   // record does not exsit
   if (index == -1)
     return false;
-  int offset = (index + 1) * 36;
+  int offset = RECORDS_OFFSET + index * RECORD_SIZE + 32;
   root_id = *reinterpret_cast<page_id_t *>(GetData() + offset);
 
   return true;
@@ -83,11 +110,28 @@ void HeaderPage::SetRecordCount(int record_count) {
   memcpy(GetData(), &record_count, 4);
 }
 
+// magic of the current format
+void HeaderPage::SetMagic() {
+  uint32_t magic = HEADER_MAGIC;
+  memcpy(GetData() + HEADER_MAGIC_OFFSET, &magic, 4);
+}
+
+// page size of the database
+size_t HeaderPage::GetPageSize() {
+  return *reinterpret_cast<uint32_t *>(GetData() + HEADER_PAGE_SIZE_OFFSET);
+}
+
+void HeaderPage::SetPageSize(size_t page_size) {
+  uint32_t size = page_size;
+  memcpy(GetData() + HEADER_PAGE_SIZE_OFFSET, &size, 4);
+}
+
 int HeaderPage::FindRecord(const std::string &name) {
   int record_num = GetRecordCount();
 
   for (int i = 0; i < record_num; i++) {
-    char *raw_name = reinterpret_cast<char *>(GetData() + (4 + i * 36));
+    char *raw_name =
+        reinterpret_cast<char *>(GetData() + RECORDS_OFFSET + i * RECORD_SIZE);
     if (strcmp(raw_name, name.c_str()) == 0)
       return i;
   }
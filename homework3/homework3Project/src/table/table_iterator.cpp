@@ -9,9 +9,13 @@
 namespace scudb {
 
 TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn),
+      strategy_(std::make_shared<BufferAccessStrategy>()),
+      readahead_(std::make_shared<Readahead>(table_heap->buffer_pool_manager_,
+                                             strategy_.get())) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
-    table_heap_->GetTuple(tuple_->rid_, *tuple_, txn_);
+    readahead_->Advance(rid.GetPageId());
+    table_heap_->GetTuple(tuple_->rid_, *tuple_, txn_, strategy_.get());
   }
 };
 
@@ -27,33 +31,31 @@ Tuple *TableIterator::operator->() {
 
 TableIterator &TableIterator::operator++() {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(
-      buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
-  cur_page->RLatch();
-  assert(cur_page != nullptr); // all pages are pinned
+  ReadPageGuard guard = buffer_pool_manager->FetchPageRead(
+      tuple_->rid_.GetPageId(), strategy_.get());
+  assert(guard.IsValid()); // all pages are pinned
+  auto cur_page = static_cast<TablePage *>(guard.GetPage());
 
   RID next_tuple_rid;
   if (!cur_page->GetNextTupleRid(tuple_->rid_,
                                  next_tuple_rid)) { // end of this page
     while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(
-          buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetPageId(), false);
-      cur_page = next_page;
-      cur_page->RLatch();
+      // the next page is latched before this one is released
+      guard = buffer_pool_manager->FetchPageRead(cur_page->GetNextPageId(),
+                                                 strategy_.get());
+      cur_page = static_cast<TablePage *>(guard.GetPage());
+      readahead_->Advance(cur_page->GetPageId());
       if (cur_page->GetFirstTupleRid(next_tuple_rid))
         break;
     }
   }
   tuple_->rid_ = next_tuple_rid;
 
+  // the tuple is read from the page already latched, not fetched again
   if (*this != table_heap_->end()) {
-    table_heap_->GetTuple(tuple_->rid_, *tuple_, txn_);
+    cur_page->GetTuple(tuple_->rid_, *tuple_, txn_,
+                       table_heap_->lock_manager_);
   }
-  // release until copy the tuple
-  cur_page->RUnlatch();
-  buffer_pool_manager->UnpinPage(cur_page->GetPageId(), false);
   return *this;
 }
 
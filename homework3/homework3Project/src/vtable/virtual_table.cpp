@@ -2,6 +2,7 @@
  * virtual_table.cpp
  */
 #include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <sys/stat.h>
@@ -306,6 +307,29 @@ int VtabBegin(sqlite3_vtab *pVTab) {
   return SQLITE_OK;
 }
 
+/*
+ * Resize the buffer pool to the given number of frames, if any, and return
+ * its size, e.g. SELECT vtable_buffer_pool_size(4096). Fails for a size
+ * outside 1..VTABLE_BUFFER_POOL_MAX_SIZE
+ */
+void VtabBufferPoolSize(sqlite3_context *context, int argc,
+                        sqlite3_value **argv) {
+  auto buffer_pool_manager = storage_engine_->buffer_pool_manager_;
+  if (argc == 1) {
+    sqlite3_int64 frames = sqlite3_value_int64(argv[0]);
+    if (frames <= 0 || static_cast<size_t>(frames) >
+                           buffer_pool_manager->GetMaxPoolSize()) {
+      sqlite3_result_error(context, "buffer pool size out of range", -1);
+      return;
+    }
+    // a shrink held up by pinned pages stops short, the size reached is
+    // returned
+    buffer_pool_manager->Resize(static_cast<size_t>(frames));
+  }
+  sqlite3_result_int64(
+      context, static_cast<sqlite3_int64>(buffer_pool_manager->GetPoolSize()));
+}
+
 int VtabCommit(sqlite3_vtab *pVTab) {
   // LOG_DEBUG("VtabCommit");
   auto transaction = GetTransaction();
@@ -357,21 +381,77 @@ __declspec(dllexport)
   std::string db_file_name = "vtable.db";
   struct stat buffer;
   bool is_file_exist = (stat(db_file_name.c_str(), &buffer) == 0);
+  // page size of a new database, e.g. VTABLE_PAGE_SIZE=8192
+  size_t page_size = PAGE_SIZE;
+  if (const char *setting = getenv("VTABLE_PAGE_SIZE"))
+    page_size = strtoul(setting, nullptr, 10);
+  // when data pages reach the disk: VTABLE_DURABILITY=sync|batched|checkpoint
+  DurabilityMode durability = DurabilityMode::CHECKPOINT_ONLY;
+  if (const char *setting = getenv("VTABLE_DURABILITY")) {
+    if (strcmp(setting, "sync") == 0)
+      durability = DurabilityMode::SYNC_EACH_WRITE;
+    else if (strcmp(setting, "batched") == 0)
+      durability = DurabilityMode::BATCHED;
+  }
+  // buffer replacement policy: VTABLE_REPLACER=lru|clock|lru-k|2q|arc
+  ReplacerPolicy policy = ReplacerPolicy::LRU;
+  if (const char *setting = getenv("VTABLE_REPLACER"))
+    ParseReplacerPolicy(setting, policy);
+  // memory behind the frames: VTABLE_FRAME_MEMORY=default|thp|hugetlb
+  FrameMemory memory = FrameMemory::DEFAULT;
+  if (const char *setting = getenv("VTABLE_FRAME_MEMORY"))
+    ParseFrameMemory(setting, memory);
+  // frames of the buffer pool at start, VTABLE_BUFFER_POOL_SIZE, and the most
+  // vtable_buffer_pool_size() may resize it to, VTABLE_BUFFER_POOL_MAX_SIZE
+  size_t pool_size = BUFFER_POOL_SIZE;
+  if (const char *setting = getenv("VTABLE_BUFFER_POOL_SIZE"))
+    pool_size = std::max<size_t>(1, strtoul(setting, nullptr, 10));
+  size_t max_pool_size = BUFFER_POOL_MAX_SIZE;
+  if (const char *setting = getenv("VTABLE_BUFFER_POOL_MAX_SIZE"))
+    max_pool_size = strtoul(setting, nullptr, 10);
 
   // init storage engine
-  storage_engine_ = new StorageEngine(db_file_name);
+  storage_engine_ =
+      new StorageEngine(db_file_name, page_size, durability, policy, memory,
+                        pool_size, max_pool_size);
+  // bytes of evicted pages kept compressed below the pool, none by default:
+  // VTABLE_COMPRESSED_CACHE_SIZE=1048576
+  if (const char *setting = getenv("VTABLE_COMPRESSED_CACHE_SIZE"))
+    storage_engine_->buffer_pool_manager_->SetCompressedCacheBudget(
+        strtoul(setting, nullptr, 10));
   // start the logging
   storage_engine_->log_manager_->RunFlushThread();
   // create header page from BufferPoolManager if necessary
   if (!is_file_exist) {
     page_id_t header_page_id;
-    storage_engine_->buffer_pool_manager_->NewPage(header_page_id);
+    auto header_page = static_cast<HeaderPage *>(
+        storage_engine_->buffer_pool_manager_->NewPage(header_page_id));
 
     assert(header_page_id == HEADER_PAGE_ID);
+    // record the page size so that reopening the database can find it
+    header_page->Init(storage_engine_->buffer_pool_manager_->GetPageSize());
     storage_engine_->buffer_pool_manager_->UnpinPage(header_page_id, true);
+  } else {
+    // bring the header page of an older database up to the current format
+    auto header_page = static_cast<HeaderPage *>(
+        storage_engine_->buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+    bool valid = header_page != nullptr && header_page->CheckFormat();
+    if (header_page != nullptr)
+      storage_engine_->buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, valid);
+    if (!valid) {
+      *pzErrMsg = sqlite3_mprintf("%s has no valid header page",
+                                  db_file_name.c_str());
+      delete storage_engine_;
+      storage_engine_ = nullptr;
+      return SQLITE_ERROR;
+    }
   }
 
   int rc = sqlite3_create_module(db, "vtable", &VtableModule, nullptr);
+  for (int num_args = 0; rc == SQLITE_OK && num_args <= 1; ++num_args)
+    rc = sqlite3_create_function(db, "vtable_buffer_pool_size", num_args,
+                                 SQLITE_UTF8, nullptr, VtabBufferPoolSize,
+                                 nullptr, nullptr);
   return rc;
 }
 
@@ -0,0 +1,151 @@
+/**
+ * array_lru_replacer_test.cpp
+ *
+ * The array-based LRU replacer, and a microbenchmark against the node-based
+ * LRUReplacer that also counts heap allocations.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <new>
+#include <random>
+
+#include "buffer/array_lru_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "page/page.h"
+#include "gtest/gtest.h"
+
+// count every allocation of this test program
+static std::atomic<uint64_t> num_allocations(0);
+
+void *operator new(size_t size) {
+  ++num_allocations;
+  if (void *ptr = malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+namespace scudb {
+
+TEST(ArrayLRUReplacerTest, SampleTest) {
+  ArrayLRUReplacer<int> lru_replacer(10);
+
+  lru_replacer.Insert(1);
+  lru_replacer.Insert(2);
+  lru_replacer.Insert(3);
+  lru_replacer.Insert(4);
+  lru_replacer.Insert(5);
+  lru_replacer.Insert(6);
+  lru_replacer.Insert(1);
+  EXPECT_EQ(6u, lru_replacer.Size());
+
+  int value;
+  lru_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+  lru_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  lru_replacer.Victim(value);
+  EXPECT_EQ(4, value);
+
+  EXPECT_EQ(false, lru_replacer.Erase(4));
+  EXPECT_EQ(true, lru_replacer.Erase(6));
+  EXPECT_EQ(2u, lru_replacer.Size());
+
+  std::vector<int> peeked;
+  lru_replacer.PeekVictims(peeked, 10);
+  EXPECT_EQ(std::vector<int>({5, 1}), peeked);
+  lru_replacer.Victim(value);
+  EXPECT_EQ(5, value);
+  lru_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  EXPECT_EQ(false, lru_replacer.Victim(value));
+  EXPECT_EQ(0u, lru_replacer.Size());
+}
+
+TEST(ArrayLRUReplacerTest, FrameTest) {
+  const size_t num_frames = 8;
+  Page *frames = new Page[num_frames];
+  ArrayLRUReplacer<Page *> lru_replacer(num_frames, frames);
+  for (size_t i = 0; i < num_frames; ++i) {
+    lru_replacer.Insert(&frames[num_frames - 1 - i]);
+  }
+  lru_replacer.Insert(&frames[7]);
+  EXPECT_EQ(true, lru_replacer.Erase(&frames[6]));
+  Page *value = nullptr;
+  EXPECT_EQ(true, lru_replacer.Victim(value));
+  EXPECT_EQ(&frames[5], value);
+  for (int i = 4; i >= 0; --i) {
+    EXPECT_EQ(true, lru_replacer.Victim(value));
+    EXPECT_EQ(&frames[i], value);
+  }
+  EXPECT_EQ(true, lru_replacer.Victim(value));
+  EXPECT_EQ(&frames[7], value);
+  EXPECT_EQ(false, lru_replacer.Victim(value));
+  delete[] frames;
+}
+
+/*
+ * The unpin, pin and evict mix of a buffer pool over num_frames frames, run
+ * on both replacers. Returns the nanoseconds per operation and sets the
+ * allocations the run took
+ */
+static double RunMix(Replacer<int> *replacer, int num_frames, int num_ops,
+                     uint64_t &allocations) {
+  std::mt19937 rng(15445);
+  std::vector<uint32_t> choices(num_ops);
+  for (auto &choice : choices) {
+    choice = rng();
+  }
+  for (int i = 0; i < num_frames; ++i) {
+    replacer->Insert(i);
+  }
+  uint64_t before = num_allocations;
+  auto start = std::chrono::steady_clock::now();
+  int value;
+  for (int i = 0; i < num_ops; ++i) {
+    int frame = static_cast<int>(choices[i] % num_frames);
+    switch (choices[i] >> 30) {
+    case 0: // hit: pin and unpin
+      replacer->Erase(frame);
+      replacer->Insert(frame);
+      break;
+    case 1: // miss: evict and unpin the new page
+      if (replacer->Victim(value)) {
+        replacer->Insert(value);
+      }
+      break;
+    default: // unpin of a page that stayed in the list
+      replacer->Insert(frame);
+    }
+  }
+  double ns = std::chrono::duration<double, std::nano>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+  allocations = num_allocations - before;
+  return ns / num_ops;
+}
+
+TEST(ArrayLRUReplacerTest, Microbenchmark) {
+  const int num_frames = 4096, num_ops = 1000000;
+  uint64_t node_allocations, array_allocations;
+  LRUReplacer<int> node_replacer;
+  double node_ns = RunMix(&node_replacer, num_frames, num_ops,
+                          node_allocations);
+  ArrayLRUReplacer<int> array_replacer(num_frames);
+  double array_ns = RunMix(&array_replacer, num_frames, num_ops,
+                           array_allocations);
+  printf("node-based LRU:  %6.1f ns per operation, %8lu allocations\n",
+         node_ns, static_cast<unsigned long>(node_allocations));
+  printf("array-based LRU: %6.1f ns per operation, %8lu allocations\n",
+         array_ns, static_cast<unsigned long>(array_allocations));
+  EXPECT_EQ(0u, array_allocations);
+  EXPECT_LT(0u, node_allocations);
+}
+
+} // namespace scudb
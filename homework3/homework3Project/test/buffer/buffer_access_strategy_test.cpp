@@ -0,0 +1,69 @@
+/**
+ * buffer_access_strategy_test.cpp
+ */
+
+#include <cstdio>
+#include <cstring>
+
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_manager.h"
+#include "disk/memory_disk_manager.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(BufferAccessStrategyTest, RingTest) {
+  const int num_hot = 16, num_pages = 216;
+  page_id_t temp_page_id;
+  MemoryDiskManager *disk_manager = new MemoryDiskManager();
+  BufferPoolManager *bpm = new BufferPoolManager(64, disk_manager);
+  for (int i = 0; i < num_pages; ++i) {
+    auto page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+  }
+  bpm->FlushAllPages();
+  delete bpm;
+
+  char expected[PAGE_SIZE];
+  for (bool use_strategy : {true, false}) {
+    bpm = new BufferPoolManager(64, disk_manager);
+    for (int i = 0; i < num_hot; ++i) {
+      ASSERT_NE(nullptr, bpm->FetchPage(i));
+      EXPECT_EQ(true, bpm->UnpinPage(i, false));
+    }
+    {
+      // a scan over three times the pool
+      BufferAccessStrategy strategy;
+      for (int i = num_hot; i < num_pages; ++i) {
+        auto page = bpm->FetchPage(i, use_strategy ? &strategy : nullptr);
+        ASSERT_NE(nullptr, page);
+        snprintf(expected, PAGE_SIZE, "page %d", i);
+        EXPECT_EQ(0, strcmp(page->GetData(), expected));
+        EXPECT_EQ(true, bpm->UnpinPage(i, false));
+      }
+      // a ring takes an eighth of the pool
+      EXPECT_EQ(use_strategy ? num_pages - num_hot - 8u : 0u,
+                strategy.GetNumReused());
+    }
+    // only a scan without a ring pushes the hot pages out
+    int num_reads = disk_manager->GetNumReadCalls();
+    for (int i = 0; i < num_hot; ++i) {
+      ASSERT_NE(nullptr, bpm->FetchPage(i));
+      EXPECT_EQ(true, bpm->UnpinPage(i, false));
+    }
+    EXPECT_EQ(use_strategy ? 0 : num_hot,
+              disk_manager->GetNumReadCalls() - num_reads);
+
+    // the ring's frames went back to the replacer
+    for (int i = 0; i < 64; ++i) {
+      ASSERT_NE(nullptr, bpm->NewPage(temp_page_id));
+    }
+    EXPECT_EQ(nullptr, bpm->NewPage(temp_page_id));
+    delete bpm;
+  }
+  delete disk_manager;
+}
+
+} // namespace scudb
@@ -2,9 +2,16 @@
  * buffer_pool_manager_test.cpp
  */
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
+#include <cstring>
+#include <thread>
 
 #include "buffer/buffer_pool_manager.h"
+#include "disk/memory_disk_manager.h"
+#include "disk/testing_disk_util.h"
 #include "gtest/gtest.h"
 
 namespace scudb {
@@ -45,7 +52,7 @@ TEST(BufferPoolManagerTest, SampleTest) {
   // check read content
   EXPECT_EQ(0, strcmp(page_zero->GetData(), "Hello"));
 
-  remove("test.db");
+  RemoveDatabase("test.db");
 }
 
 TEST(BufferPoolManagerTest, SampleTest2) {
@@ -95,8 +102,336 @@ TEST(BufferPoolManagerTest, SampleTest2) {
   // check read content
   EXPECT_EQ(0, strcmp(page_zero->GetData(), "Hello"));
 
-  remove("test.db");
+  RemoveDatabase("test.db");
 }
 
 
+TEST(BufferPoolManagerTest, FlushAllAndPrefetchTest) {
+  page_id_t temp_page_id;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager);
+
+  for (int i = 0; i < 10; ++i) {
+    auto page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+  }
+  // all ten dirty pages are adjacent on disk
+  bpm->FlushAllPages();
+  EXPECT_EQ(1, disk_manager->GetNumVectoredIOs());
+  delete bpm;
+
+  // prefetched pages are served without further reads
+  bpm = new BufferPoolManager(10, disk_manager);
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 10; ++i) {
+    page_ids.push_back(i);
+  }
+  bpm->Prefetch(page_ids);
+  EXPECT_EQ(2, disk_manager->GetNumVectoredIOs());
+  char expected[PAGE_SIZE];
+  for (int i = 0; i < 10; ++i) {
+    auto page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+  }
+  // nothing is prefetched while every frame is pinned
+  page_ids.assign(1, 10);
+  bpm->Prefetch(page_ids);
+  EXPECT_EQ(2, disk_manager->GetNumVectoredIOs());
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  delete bpm;
+  delete disk_manager;
+  RemoveDatabase("test.db");
+}
+
+// holds every read until released, to observe the buffer pool mid-I/O
+class BlockingDiskManager : public MemoryDiskManager {
+public:
+  bool ReadPage(page_id_t page_id, char *page_data) override {
+    {
+      std::unique_lock<std::mutex> lck(latch_);
+      ++num_blocked_;
+      cv_.notify_all();
+      cv_.wait(lck, [this] { return released_; });
+    }
+    return MemoryDiskManager::ReadPage(page_id, page_data);
+  }
+  void WaitForBlockedRead() {
+    std::unique_lock<std::mutex> lck(latch_);
+    cv_.wait(lck, [this] { return num_blocked_ > 0; });
+  }
+  void Release() {
+    std::lock_guard<std::mutex> lck(latch_);
+    released_ = true;
+    cv_.notify_all();
+  }
+  int num_blocked_ = 0;
+
+private:
+  bool released_ = false;
+  std::mutex latch_;
+  std::condition_variable cv_;
+};
+
+TEST(BufferPoolManagerTest, IOOutsideLatchTest) {
+  page_id_t temp_page_id;
+  BlockingDiskManager *disk_manager = new BlockingDiskManager();
+  BufferPoolManager *bpm = new BufferPoolManager(2, disk_manager);
+
+  // page 0 is written back and evicted, page 2 stays resident
+  for (int i = 0; i < 3; ++i) {
+    auto page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+  }
+  Page *pages[2] = {nullptr, nullptr};
+  std::thread loader([&] { pages[0] = bpm->FetchPage(0); });
+  disk_manager->WaitForBlockedRead();
+
+  // resident pages are served while the read is outstanding
+  auto resident = bpm->FetchPage(2);
+  ASSERT_NE(nullptr, resident);
+  EXPECT_EQ(0, strcmp(resident->GetData(), "page 2"));
+  EXPECT_EQ(true, bpm->UnpinPage(2, false));
+
+  // a second fetch of the loading page waits for the same frame
+  std::thread waiter([&] { pages[1] = bpm->FetchPage(0); });
+  disk_manager->Release();
+  loader.join();
+  waiter.join();
+  ASSERT_NE(nullptr, pages[0]);
+  EXPECT_EQ(pages[0], pages[1]);
+  EXPECT_EQ(1, disk_manager->num_blocked_);
+  EXPECT_EQ(0, strcmp(pages[0]->GetData(), "page 0"));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, ConcurrentFetchTest) {
+  const int num_pages = 16;
+  page_id_t temp_page_id;
+  MemoryDiskManager *disk_manager = new MemoryDiskManager();
+  BufferPoolManager *bpm = new BufferPoolManager(8, disk_manager);
+
+  for (int i = 0; i < num_pages; ++i) {
+    auto page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+  }
+  // twice as many pages as frames: hits pinned lock-free race with
+  // evictions, each fetch must still return the requested page
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t] {
+      char expected[PAGE_SIZE];
+      for (int i = 0; i < 5000; ++i) {
+        page_id_t page_id = (i * 7 + t) % num_pages;
+        auto page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        EXPECT_EQ(page_id, page->GetPageId());
+        snprintf(expected, PAGE_SIZE, "page %d", page_id);
+        EXPECT_EQ(0, strcmp(page->GetData(), expected));
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpined());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, CleanerTest) {
+  page_id_t temp_page_id;
+  MemoryDiskManager *disk_manager = new MemoryDiskManager();
+  BufferPoolManager *bpm = new BufferPoolManager(16, disk_manager);
+
+  for (int i = 0; i < 16; ++i) {
+    auto page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+  }
+  // every frame is dirty, far above the high ratio
+  bpm->StartCleaner();
+  for (int i = 0; i < 1000 && bpm->GetNumPagesCleaned() < 16; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(16u, bpm->GetNumPagesCleaned());
+
+  // the next pages replace clean victims only
+  for (int i = 0; i < 16; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, false));
+  }
+  EXPECT_EQ(0u, bpm->GetNumDirtyEvictions());
+  bpm->StopCleaner();
+
+  char expected[PAGE_SIZE];
+  for (int i = 0; i < 16; ++i) {
+    auto page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_EQ(true, bpm->UnpinPage(i, true));
+  }
+  // without the cleaner dirty victims are written by the faulting thread
+  for (int i = 0; i < 16; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, false));
+  }
+  EXPECT_EQ(16u, bpm->GetNumDirtyEvictions());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+/*
+ * The checkpoint writer sorts and coalesces the dirty pages, reports what it
+ * wrote, and lets other threads fetch and modify pages while it runs
+ */
+TEST(BufferPoolManagerTest, CheckpointTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(100, disk_manager);
+  page_id_t temp_page_id;
+  for (int i = 0; i < 60; ++i) {
+    auto page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, i % 10 != 9));
+  }
+  bpm->FlushAllPages();
+  // every tenth page stays clean, which splits the rest into six runs
+  for (int i = 0; i < 60; ++i) {
+    auto page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(i, i % 10 != 9));
+  }
+  int num_ios = disk_manager->GetNumVectoredIOs();
+  FlushStats stats = bpm->FlushAllPages();
+  EXPECT_EQ(54u, stats.num_pages_);
+  EXPECT_EQ(6u, stats.num_runs_);
+  EXPECT_EQ(54u * PAGE_SIZE, stats.num_bytes_);
+  EXPECT_LE(0, stats.elapsed_ms_);
+  EXPECT_EQ(num_ios + 6, disk_manager->GetNumVectoredIOs());
+  stats = bpm->FlushAllPages();
+  EXPECT_EQ(0u, stats.num_pages_);
+
+  // a writer keeps counting in every page while checkpoints run
+  std::atomic<bool> done{false};
+  std::thread writer([bpm, &done] {
+    for (int round = 0; round < 200 || !done; ++round) {
+      for (page_id_t id = 0; id < 60; ++id) {
+        auto page = bpm->FetchPage(id);
+        page->WLatch();
+        reinterpret_cast<int *>(page->GetData() + PAGE_SIZE)[-1]++;
+        page->WUnlatch();
+        bpm->UnpinPage(page, true);
+      }
+    }
+  });
+  for (int i = 0; i < 20; ++i) {
+    bpm->FlushAllPages();
+  }
+  done = true;
+  writer.join();
+  bpm->FlushAllPages();
+  std::vector<int> counts;
+  for (page_id_t id = 0; id < 60; ++id) {
+    auto page = bpm->FetchPage(id);
+    counts.push_back(reinterpret_cast<int *>(page->GetData() + PAGE_SIZE)[-1]);
+    EXPECT_LE(200, counts.back());
+    EXPECT_EQ(true, bpm->UnpinPage(page, false));
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpined());
+  delete bpm;
+
+  // what was checkpointed is what the pages held
+  bpm = new BufferPoolManager(100, disk_manager);
+  char expected[PAGE_SIZE];
+  for (page_id_t id = 0; id < 60; ++id) {
+    auto page = bpm->FetchPage(id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(counts[id],
+              reinterpret_cast<int *>(page->GetData() + PAGE_SIZE)[-1]);
+    snprintf(expected, PAGE_SIZE, "page %d", id);
+    EXPECT_STREQ(expected, page->GetData());
+    EXPECT_EQ(true, bpm->UnpinPage(page, false));
+  }
+
+  delete bpm;
+  delete disk_manager;
+  RemoveDatabase("test.db");
+}
+
+/*
+ * A page damaged on disk is not handed out: every fetch of it fails, also
+ * after a prefetch, and the frames it was read into are not lost
+ */
+TEST(BufferPoolManagerTest, ChecksumFailureTest) {
+  page_id_t temp_page_id;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(4, disk_manager);
+  for (int i = 0; i < 4; ++i) {
+    auto page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+  }
+  bpm->FlushAllPages();
+  delete bpm;
+  delete disk_manager;
+
+  // flip a byte of page 2 behind the disk manager's back
+  FILE *file = fopen("test.db", "r+b");
+  ASSERT_NE(nullptr, file);
+  fseek(file, 2 * PAGE_SIZE + 3, SEEK_SET);
+  fputc('X', file);
+  fclose(file);
+
+  disk_manager = new DiskManager("test.db");
+  bpm = new BufferPoolManager(4, disk_manager);
+  EXPECT_EQ(nullptr, bpm->FetchPage(2));
+  EXPECT_FALSE(bpm->FetchPageRead(2).IsValid());
+  bpm->Prefetch({1, 2, 3});
+  EXPECT_EQ(nullptr, bpm->FetchPage(2));
+  EXPECT_LE(3, disk_manager->GetNumChecksumFailures());
+
+  // the other pages read fine, and every frame can still be pinned
+  std::vector<Page *> pages;
+  for (page_id_t id : {0, 1, 3}) {
+    pages.push_back(bpm->FetchPage(id));
+    ASSERT_NE(nullptr, pages.back());
+    char expected[PAGE_SIZE];
+    snprintf(expected, PAGE_SIZE, "page %d", id);
+    EXPECT_STREQ(expected, pages.back()->GetData());
+  }
+  EXPECT_NE(nullptr, bpm->NewPage(temp_page_id));
+  EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, false));
+  for (Page *page : pages) {
+    EXPECT_EQ(true, bpm->UnpinPage(page, false));
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpined());
+
+  delete bpm;
+  delete disk_manager;
+  RemoveDatabase("test.db");
+}
+
 } // namespace scudb
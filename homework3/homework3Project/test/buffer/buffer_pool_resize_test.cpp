@@ -0,0 +1,246 @@
+/**
+ * buffer_pool_resize_test.cpp
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "disk/memory_disk_manager.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(BufferPoolResizeTest, SampleTest) {
+  MemoryDiskManager *disk_manager = new MemoryDiskManager();
+  BufferPoolManager *bpm = new BufferPoolManager(
+      4, disk_manager, nullptr, ReplacerPolicy::LRU, FrameMemory::DEFAULT,
+      false, 16);
+  EXPECT_EQ(4u, bpm->GetPoolSize());
+  EXPECT_EQ(16u, bpm->GetMaxPoolSize());
+  EXPECT_FALSE(bpm->Resize(0));
+  EXPECT_FALSE(bpm->Resize(17));
+
+  // growing adds free frames
+  page_id_t page_ids[8];
+  for (int i = 0; i < 4; ++i) {
+    Page *page = bpm->NewPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), 16, "page %d", page_ids[i]);
+  }
+  page_id_t temp_page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(temp_page_id));
+  EXPECT_TRUE(bpm->Resize(8));
+  EXPECT_EQ(8u, bpm->GetPoolSize());
+  for (int i = 4; i < 8; ++i) {
+    Page *page = bpm->NewPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), 16, "page %d", page_ids[i]);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(temp_page_id));
+  for (page_id_t page_id : page_ids) {
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // shrinking writes the pages of the frames given up back
+  EXPECT_TRUE(bpm->Resize(2));
+  EXPECT_EQ(2u, bpm->GetPoolSize());
+  for (page_id_t page_id : page_ids) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    char expected[16];
+    snprintf(expected, sizeof(expected), "page %d", page_id);
+    EXPECT_STREQ(expected, page->GetData());
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  Page *page0 = bpm->FetchPage(page_ids[0]);
+  Page *page1 = bpm->FetchPage(page_ids[1]);
+  ASSERT_NE(nullptr, page0);
+  ASSERT_NE(nullptr, page1);
+  EXPECT_EQ(nullptr, bpm->FetchPage(page_ids[2]));
+  EXPECT_TRUE(bpm->UnpinPage(page0, false));
+  EXPECT_TRUE(bpm->UnpinPage(page1, false));
+
+  // and the frames given up can be used again
+  EXPECT_TRUE(bpm->Resize(16));
+  std::vector<Page *> pages;
+  for (int i = 0; i < 16; ++i) {
+    Page *page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    pages.push_back(page);
+  }
+  for (Page *page : pages) {
+    EXPECT_TRUE(bpm->UnpinPage(page, false));
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpined());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+/*
+ * A shrink waits for pages pinned in the frames it gives up
+ */
+TEST(BufferPoolResizeTest, PinnedTest) {
+  MemoryDiskManager *disk_manager = new MemoryDiskManager();
+  BufferPoolManager *bpm = new BufferPoolManager(
+      4, disk_manager, nullptr, ReplacerPolicy::LRU, FrameMemory::DEFAULT,
+      false, 4);
+  page_id_t page_ids[4];
+  Page *pages[4];
+  for (int i = 0; i < 4; ++i) {
+    pages[i] = bpm->NewPage(page_ids[i]);
+    ASSERT_NE(nullptr, pages[i]);
+  }
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(bpm->UnpinPage(pages[i], false));
+  }
+
+  auto resized = std::async(std::launch::async, [bpm] { return bpm->Resize(1); });
+  EXPECT_EQ(std::future_status::timeout,
+            resized.wait_for(std::chrono::milliseconds(50)));
+  strcpy(pages[3]->GetData(), "pinned");
+  EXPECT_TRUE(bpm->UnpinPage(pages[3], true));
+  EXPECT_TRUE(resized.get());
+  EXPECT_EQ(1u, bpm->GetPoolSize());
+
+  Page *page = bpm->FetchPage(page_ids[3]);
+  ASSERT_NE(nullptr, page);
+  EXPECT_STREQ("pinned", page->GetData());
+  EXPECT_TRUE(bpm->UnpinPage(page, false));
+  EXPECT_TRUE(bpm->CheckAllUnpined());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+/*
+ * A shrink gives up waiting for pages that stay pinned, keeping the frames
+ * up to the last of them; lock-free pins of the frames given up meanwhile
+ * still find their pages
+ */
+TEST(BufferPoolResizeTest, StalledTest) {
+  MemoryDiskManager *disk_manager = new MemoryDiskManager();
+  BufferPoolManager *bpm = new BufferPoolManager(
+      4, disk_manager, nullptr, ReplacerPolicy::LRU, FrameMemory::DEFAULT,
+      false, 4);
+  page_id_t page_ids[4];
+  Page *pages[4];
+  for (int i = 0; i < 4; ++i) {
+    pages[i] = bpm->NewPage(page_ids[i]);
+    ASSERT_NE(nullptr, pages[i]);
+    snprintf(pages[i]->GetData(), 16, "page %d", page_ids[i]);
+  }
+  EXPECT_TRUE(bpm->UnpinPage(pages[0], true));
+  EXPECT_TRUE(bpm->UnpinPage(pages[1], true));
+
+  // two pinned pages, so at least one sits past the first frame
+  EXPECT_FALSE(bpm->Resize(1));
+  EXPECT_LE(2u, bpm->GetPoolSize());
+  EXPECT_GE(4u, bpm->GetPoolSize());
+  for (int i = 0; i < 4; ++i) {
+    Page *page = bpm->FetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    char expected[16];
+    snprintf(expected, sizeof(expected), "page %d", page_ids[i]);
+    EXPECT_STREQ(expected, page->GetData());
+    EXPECT_TRUE(bpm->UnpinPage(page, false));
+  }
+
+  EXPECT_TRUE(bpm->UnpinPage(pages[2], true));
+  EXPECT_TRUE(bpm->UnpinPage(pages[3], true));
+  EXPECT_TRUE(bpm->Resize(1));
+  EXPECT_EQ(1u, bpm->GetPoolSize());
+  for (int i = 0; i < 4; ++i) {
+    Page *page = bpm->FetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    char expected[16];
+    snprintf(expected, sizeof(expected), "page %d", page_ids[i]);
+    EXPECT_STREQ(expected, page->GetData());
+    EXPECT_TRUE(bpm->UnpinPage(page, false));
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpined());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+/*
+ * Threads keep reading and writing pages while the pool shrinks and grows
+ * under them; every page keeps the last value written to it
+ */
+TEST(BufferPoolResizeTest, ConcurrentTest) {
+  const int num_threads = 4, num_pages = 200, num_ops = 20000;
+  for (size_t num_instances : {1, 4}) {
+    MemoryDiskManager *disk_manager = new MemoryDiskManager();
+    BufferPoolManager *bpm =
+        num_instances == 1
+            ? new BufferPoolManager(64, disk_manager, nullptr,
+                                    ReplacerPolicy::LRU, FrameMemory::DEFAULT,
+                                    false, 256)
+            : new ParallelBufferPoolManager(num_instances, 64, disk_manager,
+                                            nullptr, ReplacerPolicy::LRU,
+                                            FrameMemory::DEFAULT, false, 256);
+    page_id_t page_id;
+    for (int i = 0; i < num_pages; ++i) {
+      Page *page = bpm->NewPage(page_id);
+      ASSERT_NE(nullptr, page);
+      memset(page->GetData(), 0, sizeof(int));
+      EXPECT_TRUE(bpm->UnpinPage(page, true));
+    }
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+      threads.emplace_back([bpm, t] {
+        std::mt19937 rng(t);
+        // each thread increments its own slot of every page
+        for (int i = 0; i < num_ops; ++i) {
+          Page *page = nullptr;
+          while ((page = bpm->FetchPage(rng() % num_pages)) == nullptr) {
+            std::this_thread::yield();
+          }
+          page->WLatch();
+          reinterpret_cast<int *>(page->GetData())[t]++;
+          page->WUnlatch();
+          bpm->UnpinPage(page, true);
+        }
+      });
+    }
+    std::thread resizer([bpm, &done] {
+      std::mt19937 rng(15445);
+      while (!done) {
+        EXPECT_TRUE(bpm->Resize(8 + rng() % 248));
+      }
+    });
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    done = true;
+    resizer.join();
+
+    EXPECT_TRUE(bpm->Resize(32));
+    EXPECT_EQ(32u, bpm->GetPoolSize());
+    int total = 0;
+    for (page_id_t id = 0; id < num_pages; ++id) {
+      Page *page = bpm->FetchPage(id);
+      ASSERT_NE(nullptr, page);
+      for (int t = 0; t < num_threads; ++t) {
+        total += reinterpret_cast<int *>(page->GetData())[t];
+      }
+      EXPECT_TRUE(bpm->UnpinPage(page, false));
+    }
+    EXPECT_EQ(num_threads * num_ops, total);
+    EXPECT_TRUE(bpm->CheckAllUnpined());
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+} // namespace scudb
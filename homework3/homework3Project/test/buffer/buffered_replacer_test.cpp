@@ -0,0 +1,93 @@
+/**
+ * buffered_replacer_test.cpp
+ */
+
+#include <thread>
+#include <vector>
+
+#include "buffer/buffered_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(BufferedReplacerTest, SampleTest) {
+  BufferedReplacer<int> replacer(new LRUReplacer<int>);
+
+  for (int i = 1; i <= 6; ++i) {
+    replacer.Insert(i);
+  }
+  replacer.Insert(1);
+  EXPECT_EQ(6u, replacer.Size());
+
+  // buffered inserts are applied in order before a victim is picked
+  int value;
+  replacer.Victim(value);
+  EXPECT_EQ(2, value);
+  replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  replacer.Victim(value);
+  EXPECT_EQ(4, value);
+
+  EXPECT_EQ(false, replacer.Erase(4));
+  EXPECT_EQ(true, replacer.Erase(6));
+  EXPECT_EQ(2u, replacer.Size());
+  replacer.Insert(5);
+  replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  replacer.Victim(value);
+  EXPECT_EQ(5, value);
+  EXPECT_EQ(false, replacer.Victim(value));
+}
+
+TEST(BufferedReplacerTest, AdmitTest) {
+  // only even values are still wanted when the buffer is drained
+  BufferedReplacer<int> replacer(
+      new LRUReplacer<int>, [](const int &value) { return value % 2 == 0; });
+  for (int i = 1; i <= 6; ++i) {
+    replacer.Insert(i);
+  }
+  EXPECT_EQ(3u, replacer.Size());
+  int value;
+  for (int expected : {2, 4, 6}) {
+    EXPECT_EQ(true, replacer.Victim(value));
+    EXPECT_EQ(expected, value);
+  }
+}
+
+TEST(BufferedReplacerTest, FullBufferTest) {
+  BufferedReplacer<int> replacer(new LRUReplacer<int>);
+  for (int i = 0; i < ACCESS_BUFFER_SIZE; ++i) {
+    EXPECT_EQ(true, replacer.TryInsert(i));
+  }
+  EXPECT_EQ(false, replacer.TryInsert(ACCESS_BUFFER_SIZE));
+  // Insert drains the full buffer instead
+  replacer.Insert(ACCESS_BUFFER_SIZE);
+  EXPECT_EQ(ACCESS_BUFFER_SIZE + 1u, replacer.Size());
+  EXPECT_EQ(true, replacer.TryInsert(0));
+  int value;
+  EXPECT_EQ(true, replacer.Victim(value));
+  EXPECT_EQ(1, value);
+}
+
+TEST(BufferedReplacerTest, ConcurrentTest) {
+  const int num_threads = 8, num_values = 1000;
+  BufferedReplacer<int> replacer(new LRUReplacer<int>);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.push_back(std::thread([&replacer, tid] {
+      for (int i = 0; i < num_values; ++i) {
+        replacer.Insert(tid * num_values + i);
+        if (i % 10 == 0) {
+          replacer.Erase(tid * num_values + i);
+        }
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * num_values * 9u / 10, replacer.Size());
+}
+
+} // namespace scudb
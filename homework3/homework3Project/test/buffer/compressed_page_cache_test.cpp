@@ -0,0 +1,265 @@
+/**
+ * compressed_page_cache_test.cpp
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "buffer/compressed_page_cache.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "disk/memory_disk_manager.h"
+#include "disk/simulated_disk_manager.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(CompressedPageCacheTest, SampleTest) {
+  const size_t page_size = 4096;
+  CompressedPageCache cache(1024, page_size);
+  char page[page_size], data[page_size];
+  memset(page, 0, page_size);
+  snprintf(page, 16, "page 1");
+
+  EXPECT_FALSE(cache.Take(1, data));
+  EXPECT_TRUE(cache.Put(1, page));
+  CompressedCacheStats stats = cache.GetStats();
+  EXPECT_EQ(1u, stats.num_pages_);
+  EXPECT_LT(0u, stats.used_bytes_);
+  EXPECT_GT(page_size / 16, stats.used_bytes_);
+
+  // a page is taken once
+  memset(data, 'x', page_size);
+  EXPECT_TRUE(cache.Take(1, data));
+  EXPECT_EQ(0, memcmp(page, data, page_size));
+  EXPECT_FALSE(cache.Take(1, data));
+  stats = cache.GetStats();
+  EXPECT_EQ(0u, stats.num_pages_);
+  EXPECT_EQ(0u, stats.used_bytes_);
+  EXPECT_EQ(1u, stats.num_hits_);
+  EXPECT_EQ(2u, stats.num_misses_);
+  EXPECT_DOUBLE_EQ(1.0 / 3, stats.GetHitRatio());
+
+  // pages that do not compress are not kept, and replace older copies
+  EXPECT_TRUE(cache.Put(2, page));
+  std::mt19937 rng(15445);
+  char noise[page_size];
+  for (auto &c : noise) {
+    c = static_cast<char>(rng());
+  }
+  EXPECT_FALSE(cache.Put(2, noise));
+  EXPECT_FALSE(cache.Take(2, data));
+  EXPECT_EQ(1u, cache.GetStats().num_rejected_);
+
+  // the least recently stored pages make room within the budget
+  for (page_id_t page_id = 0; page_id < 100; ++page_id) {
+    snprintf(page, 16, "page %d", page_id);
+    EXPECT_TRUE(cache.Put(page_id, page));
+  }
+  stats = cache.GetStats();
+  EXPECT_GE(1024u, stats.used_bytes_);
+  EXPECT_LT(0u, stats.num_dropped_);
+  EXPECT_EQ(100u, stats.num_pages_ + stats.num_dropped_);
+  EXPECT_FALSE(cache.Take(0, data));
+  EXPECT_TRUE(cache.Take(99, data));
+  EXPECT_STREQ("page 99", data);
+
+  cache.Erase(98);
+  EXPECT_FALSE(cache.Take(98, data));
+  cache.SetBudget(0);
+  stats = cache.GetStats();
+  EXPECT_EQ(0u, stats.num_pages_);
+  EXPECT_EQ(0u, stats.used_bytes_);
+  EXPECT_FALSE(cache.Put(1, page));
+}
+
+// counts pages read from the disk
+class CountingDiskManager : public MemoryDiskManager {
+public:
+  explicit CountingDiskManager(size_t page_size)
+      : MemoryDiskManager(page_size) {}
+
+  bool ReadPage(page_id_t page_id, char *page_data) override {
+    num_reads_++;
+    return MemoryDiskManager::ReadPage(page_id, page_data);
+  }
+  bool
+  ReadPages(const std::vector<std::pair<page_id_t, char *>> &pages) override {
+    num_reads_ += static_cast<int>(pages.size());
+    return MemoryDiskManager::ReadPages(pages);
+  }
+
+  std::atomic<int> num_reads_{0};
+};
+
+/*
+ * Pages evicted from a small pool come back from the compressed tier
+ * instead of the disk, with the contents they were last written with
+ */
+TEST(CompressedPageCacheTest, BufferPoolTest) {
+  const size_t page_size = 4096;
+  const int num_pages = 64;
+  CountingDiskManager *disk_manager = new CountingDiskManager(page_size);
+  BufferPoolManager *bpm = new BufferPoolManager(8, disk_manager);
+  EXPECT_EQ(0u, bpm->GetCompressedCacheStats().budget_bytes_);
+  bpm->SetCompressedCacheBudget(num_pages * page_size / 4);
+
+  page_id_t page_id;
+  for (int i = 0; i < num_pages; ++i) {
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), 16, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page, true));
+  }
+  for (int round = 0; round < 3; ++round) {
+    for (page_id_t id = 0; id < num_pages; ++id) {
+      Page *page = bpm->FetchPage(id);
+      ASSERT_NE(nullptr, page);
+      char expected[16];
+      snprintf(expected, sizeof(expected), "page %d", id);
+      EXPECT_STREQ(expected, page->GetData());
+      // pages change while they are away from the disk
+      page->GetData()[page_size - 1] = static_cast<char>(round + 1);
+      EXPECT_TRUE(bpm->UnpinPage(page, true));
+    }
+  }
+  EXPECT_EQ(0, disk_manager->num_reads_);
+  CompressedCacheStats stats = bpm->GetCompressedCacheStats();
+  EXPECT_EQ(3u * num_pages, stats.num_hits_);
+  EXPECT_EQ(0u, stats.num_misses_);
+  EXPECT_DOUBLE_EQ(1.0, stats.GetHitRatio());
+  EXPECT_EQ(static_cast<size_t>(num_pages - 8), stats.num_pages_);
+
+  // deleted pages leave the tier
+  Page *page = bpm->NewPage(page_id);
+  EXPECT_TRUE(bpm->UnpinPage(page, false));
+  EXPECT_TRUE(bpm->DeletePage(0));
+  EXPECT_EQ(static_cast<size_t>(num_pages - 8),
+            bpm->GetCompressedCacheStats().num_pages_);
+
+  // a budget too small for all pages sends the rest to the disk
+  bpm->SetCompressedCacheBudget(1024);
+  stats = bpm->GetCompressedCacheStats();
+  EXPECT_GE(1024u, stats.used_bytes_);
+  for (page_id_t id = 1; id < num_pages; ++id) {
+    page = bpm->FetchPage(id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(3, page->GetData()[page_size - 1]);
+    EXPECT_TRUE(bpm->UnpinPage(page, false));
+  }
+  EXPECT_LT(0, disk_manager->num_reads_);
+  EXPECT_TRUE(bpm->CheckAllUnpined());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+/*
+ * Threads update pages of a pool much smaller than them while the tier
+ * holds part of the rest; no update is lost
+ */
+TEST(CompressedPageCacheTest, ConcurrentTest) {
+  const int num_threads = 4, num_pages = 200, num_ops = 20000;
+  for (size_t num_instances : {1, 4}) {
+    MemoryDiskManager *disk_manager = new MemoryDiskManager(1024);
+    BufferPoolManager *bpm =
+        num_instances == 1
+            ? new BufferPoolManager(32, disk_manager)
+            : new ParallelBufferPoolManager(num_instances, 32, disk_manager);
+    bpm->SetCompressedCacheBudget(num_pages * 16);
+    page_id_t page_id;
+    for (int i = 0; i < num_pages; ++i) {
+      Page *page = bpm->NewPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_TRUE(bpm->UnpinPage(page, true));
+    }
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+      threads.emplace_back([bpm, t] {
+        std::mt19937 rng(t);
+        // each thread increments its own slot of every page
+        for (int i = 0; i < num_ops; ++i) {
+          Page *page = nullptr;
+          while ((page = bpm->FetchPage(rng() % num_pages)) == nullptr) {
+            std::this_thread::yield();
+          }
+          page->WLatch();
+          reinterpret_cast<int *>(page->GetData())[t]++;
+          page->WUnlatch();
+          bpm->UnpinPage(page, true);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    int total = 0;
+    for (page_id_t id = 0; id < num_pages; ++id) {
+      Page *page = bpm->FetchPage(id);
+      ASSERT_NE(nullptr, page);
+      for (int t = 0; t < num_threads; ++t) {
+        total += reinterpret_cast<int *>(page->GetData())[t];
+      }
+      EXPECT_TRUE(bpm->UnpinPage(page, false));
+    }
+    EXPECT_EQ(num_threads * num_ops, total);
+    CompressedCacheStats stats = bpm->GetCompressedCacheStats();
+    EXPECT_LT(0u, stats.num_hits_);
+    EXPECT_GE(static_cast<size_t>(num_pages * 16), stats.used_bytes_);
+    printf("%zu instances: hit ratio %.2f, %zu pages in %zu bytes\n",
+           num_instances, stats.GetHitRatio(), stats.num_pages_,
+           stats.used_bytes_);
+    EXPECT_TRUE(bpm->CheckAllUnpined());
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+/*
+ * Random reads over four times the pool, on a simulated SSD, without the
+ * tier and with one that holds every page
+ */
+TEST(CompressedPageCacheTest, Benchmark) {
+  const size_t page_size = 4096;
+  const int pool_size = 256, num_pages = 1024, num_ops = 100000;
+  for (size_t budget : {static_cast<size_t>(0), num_pages * page_size}) {
+    SimulatedDiskManager *disk_manager =
+        new SimulatedDiskManager(DeviceProfile::SSD(), page_size);
+    BufferPoolManager *bpm = new BufferPoolManager(pool_size, disk_manager);
+    bpm->SetCompressedCacheBudget(budget);
+    page_id_t page_id;
+    for (int i = 0; i < num_pages; ++i) {
+      Page *page = bpm->NewPage(page_id);
+      ASSERT_NE(nullptr, page);
+      // half of a page is text, the rest zeros
+      for (size_t j = 0; j < page_size / 2; j += 16) {
+        snprintf(page->GetData() + j, 16, "%d:%zu", page_id, j);
+      }
+      EXPECT_TRUE(bpm->UnpinPage(page, true));
+    }
+    disk_manager->ResetSimulatedClock();
+    std::mt19937 rng(15445);
+    for (int i = 0; i < num_ops; ++i) {
+      Page *page = bpm->FetchPage(rng() % num_pages);
+      ASSERT_NE(nullptr, page);
+      EXPECT_TRUE(bpm->UnpinPage(page, false));
+    }
+    CompressedCacheStats stats = bpm->GetCompressedCacheStats();
+    printf("budget %7zu: %8.1f ms of device time, hit ratio %.2f, %zu "
+           "bytes for %zu pages\n",
+           budget, disk_manager->GetSimulatedNanos() / 1e6,
+           stats.GetHitRatio(), stats.used_bytes_, stats.num_pages_);
+    if (budget > 0) {
+      EXPECT_LT(0.9, stats.GetHitRatio());
+    }
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+} // namespace scudb
@@ -0,0 +1,201 @@
+/**
+ * frame_arena_test.cpp
+ *
+ * Frame memory of the buffer pool, and a benchmark of random page accesses
+ * over a large pool with ordinary and huge-page-backed frames that reports
+ * dTLB misses where the kernel lets us count them.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <random>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/frame_arena.h"
+#include "disk/memory_disk_manager.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(FrameArenaTest, NameTest) {
+  for (FrameMemory memory :
+       {FrameMemory::DEFAULT, FrameMemory::TRANSPARENT_HUGE,
+        FrameMemory::EXPLICIT_HUGE}) {
+    FrameMemory parsed = FrameMemory::DEFAULT;
+    EXPECT_TRUE(ParseFrameMemory(FrameMemoryName(memory), parsed));
+    EXPECT_EQ(memory, parsed);
+  }
+  FrameMemory parsed = FrameMemory::DEFAULT;
+  EXPECT_FALSE(ParseFrameMemory("huge", parsed));
+}
+
+TEST(FrameArenaTest, ArenaTest) {
+  EXPECT_LE(1, GetNumNumaNodes());
+  EXPECT_LE(0, GetCurrentNumaNode());
+  EXPECT_GT(GetNumNumaNodes(), GetCurrentNumaNode());
+
+  const size_t num_frames = 1000, frame_size = 4096;
+  for (FrameMemory memory :
+       {FrameMemory::DEFAULT, FrameMemory::TRANSPARENT_HUGE,
+        FrameMemory::EXPLICIT_HUGE}) {
+    for (bool numa_aware : {false, true}) {
+      FrameArena arena(num_frames, frame_size, memory, numa_aware);
+      printf("%-8s numa %-3s: got %s, %zu bytes mapped, %d nodes\n",
+             FrameMemoryName(memory), numa_aware ? "on" : "off",
+             FrameMemoryName(arena.GetMemory()), arena.GetMappedBytes(),
+             arena.GetNumNodes());
+      EXPECT_EQ(numa_aware ? GetNumNumaNodes() : 1, arena.GetNumNodes());
+      if (memory != FrameMemory::DEFAULT &&
+          arena.GetMemory() != FrameMemory::DEFAULT) {
+        EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(arena.GetFrame(0)) %
+                          HUGE_PAGE_SIZE);
+        EXPECT_EQ(0u, arena.GetMappedBytes() % HUGE_PAGE_SIZE);
+      }
+      int last_node = 0;
+      for (size_t i = 0; i < num_frames; ++i) {
+        char *frame = arena.GetFrame(i);
+        EXPECT_EQ(0u,
+                  reinterpret_cast<uintptr_t>(frame) % DIRECT_IO_ALIGNMENT);
+        memset(frame, static_cast<int>(i), frame_size);
+        // nodes own consecutive frames
+        int node = arena.GetNode(i);
+        EXPECT_LE(last_node, node);
+        EXPECT_GT(arena.GetNumNodes(), node);
+        last_node = node;
+      }
+      for (size_t i = 0; i < num_frames; ++i) {
+        EXPECT_EQ(static_cast<char>(i), arena.GetFrame(i)[frame_size - 1]);
+      }
+    }
+  }
+}
+
+TEST(FrameArenaTest, BufferPoolTest) {
+  MemoryDiskManager *disk_manager = new MemoryDiskManager(4096);
+  BufferPoolManager *bpm =
+      new BufferPoolManager(64, disk_manager, nullptr, ReplacerPolicy::LRU,
+                            FrameMemory::TRANSPARENT_HUGE, true);
+  EXPECT_NE(FrameMemory::EXPLICIT_HUGE, bpm->GetFrameMemory());
+  page_id_t page_id;
+  for (int i = 0; i < 256; ++i) {
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), 16, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  for (page_id_t id = 0; id < 256; id += 7) {
+    Page *page = bpm->FetchPage(id);
+    ASSERT_NE(nullptr, page);
+    char expected[16];
+    snprintf(expected, sizeof(expected), "page %d", id);
+    EXPECT_STREQ(expected, page->GetData());
+    EXPECT_TRUE(bpm->UnpinPage(id, false));
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpined());
+  delete bpm;
+  delete disk_manager;
+}
+
+// dTLB load misses of this thread in user space, if perf events are allowed
+class DtlbMissCounter {
+public:
+  DtlbMissCounter() {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+  ~DtlbMissCounter() {
+    if (fd_ >= 0)
+      close(fd_);
+  }
+  inline bool IsAvailable() const { return fd_ >= 0; }
+  void Start() {
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+  uint64_t Stop() {
+    uint64_t count = 0;
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(fd_, &count, sizeof(count)) != sizeof(count))
+        count = 0;
+    }
+    return count;
+  }
+
+private:
+  int fd_;
+};
+
+/*
+ * Random reads of resident pages in a 128 MiB pool, each touching one cache
+ * line of its frame
+ */
+TEST(FrameArenaTest, TlbBenchmark) {
+  const int num_frames = 32768, num_ops = 2000000;
+  const size_t page_size = 4096;
+  std::mt19937 rng(15445);
+  std::vector<uint32_t> choices(num_ops);
+  for (auto &choice : choices) {
+    choice = rng();
+  }
+  DtlbMissCounter counter;
+  for (FrameMemory memory :
+       {FrameMemory::DEFAULT, FrameMemory::TRANSPARENT_HUGE,
+        FrameMemory::EXPLICIT_HUGE}) {
+    MemoryDiskManager *disk_manager = new MemoryDiskManager(page_size);
+    BufferPoolManager *bpm = new BufferPoolManager(
+        num_frames, disk_manager, nullptr, ReplacerPolicy::LRU, memory);
+    page_id_t page_id;
+    for (int i = 0; i < num_frames; ++i) {
+      ASSERT_NE(nullptr, bpm->NewPage(page_id));
+      bpm->UnpinPage(page_id, false);
+    }
+    uint64_t sum = 0;
+    counter.Start();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_ops; ++i) {
+      Page *page =
+          bpm->FetchPage(static_cast<page_id_t>(choices[i] % num_frames));
+      sum += page->GetData()[(choices[i] >> 16) % (page_size / 64) * 64];
+      bpm->UnpinPage(page, false);
+    }
+    double ns = std::chrono::duration<double, std::nano>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+    uint64_t misses = counter.Stop();
+    EXPECT_EQ(0u, sum);
+    if (counter.IsAvailable()) {
+      printf("%-7s (got %-7s): %6.1f ns per access, %5.2f dTLB misses per "
+             "access\n",
+             FrameMemoryName(memory), FrameMemoryName(bpm->GetFrameMemory()),
+             ns / num_ops, static_cast<double>(misses) / num_ops);
+    } else {
+      printf("%-7s (got %-7s): %6.1f ns per access, dTLB misses not "
+             "countable here\n",
+             FrameMemoryName(memory), FrameMemoryName(bpm->GetFrameMemory()),
+             ns / num_ops);
+    }
+    EXPECT_TRUE(bpm->CheckAllUnpined());
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+} // namespace scudb
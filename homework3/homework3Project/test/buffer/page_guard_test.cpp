@@ -0,0 +1,219 @@
+/**
+ * page_guard_test.cpp
+ */
+
+#include <cstring>
+#include <utility>
+
+#include "buffer/page_guard.h"
+#include "disk/simulated_disk_manager.h"
+#include "index/b_plus_tree.h"
+#include "logging/common.h"
+#include "page/header_page.h"
+#include "table/table_heap.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(PageGuardTest, SampleTest) {
+  MemoryDiskManager *disk_manager = new MemoryDiskManager();
+  BufferPoolManager *bpm = new BufferPoolManager(4, disk_manager);
+  page_id_t page_id0, page_id1;
+  Page *page0 = bpm->NewPage(page_id0);
+  Page *page1 = bpm->NewPage(page_id1);
+  bpm->UnpinPage(page_id0, false);
+  bpm->UnpinPage(page_id1, false);
+
+  {
+    BasicPageGuard guard = bpm->FetchPageBasic(page_id0);
+    EXPECT_EQ(page0, guard.GetPage());
+    EXPECT_EQ(1, page0->GetPinCount());
+    // moving hands over the pin
+    BasicPageGuard moved(std::move(guard));
+    EXPECT_FALSE(guard.IsValid());
+    EXPECT_EQ(page_id0, moved.GetPageId());
+    EXPECT_EQ(1, page0->GetPinCount());
+    moved.Release();
+    EXPECT_EQ(0, page0->GetPinCount());
+    moved.Release();
+    EXPECT_EQ(0, page0->GetPinCount());
+  }
+
+  {
+    // readers share the latch
+    ReadPageGuard reader0 = bpm->FetchPageRead(page_id0);
+    ReadPageGuard reader1 = bpm->FetchPageRead(page_id0);
+    EXPECT_EQ(2, page0->GetPinCount());
+    // assignment drops the old page
+    reader1 = bpm->FetchPageRead(page_id1);
+    EXPECT_EQ(1, page0->GetPinCount());
+    EXPECT_EQ(1, page1->GetPinCount());
+    reader0 = std::move(reader1);
+    EXPECT_FALSE(reader1.IsValid());
+    EXPECT_EQ(0, page0->GetPinCount());
+    EXPECT_EQ(1, page1->GetPinCount());
+  }
+  EXPECT_EQ(0, page1->GetPinCount());
+
+  {
+    WritePageGuard writer = bpm->FetchPageWrite(page_id0);
+    strcpy(writer.AsMut<char>(), "Hello");
+  }
+  // the page is written back when it is evicted
+  page_id_t temp_page_id;
+  {
+    BasicPageGuard guards[4];
+    for (auto &guard : guards) {
+      guard = bpm->NewPageGuarded(temp_page_id);
+      EXPECT_TRUE(guard.IsValid());
+    }
+  }
+  {
+    ReadPageGuard reader = bpm->FetchPageRead(page_id0);
+    EXPECT_EQ(0, strcmp(reader.As<char>(), "Hello"));
+  }
+
+  {
+    // nothing to evict, the guard is empty
+    BasicPageGuard guards[4];
+    for (auto &guard : guards) {
+      guard = bpm->NewPageGuarded(temp_page_id);
+      EXPECT_TRUE(guard.IsValid());
+    }
+    ReadPageGuard reader = bpm->FetchPageRead(page_id0);
+    EXPECT_FALSE(reader.IsValid());
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpined());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// counts page table lookups by the kind of call that takes them
+class CountingBufferPoolManager : public BufferPoolManager {
+public:
+  CountingBufferPoolManager(size_t pool_size, DiskManager *disk_manager)
+      : BufferPoolManager(pool_size, disk_manager) {}
+
+  Page *FetchPage(page_id_t page_id,
+                  BufferAccessStrategy *strategy = nullptr) override {
+    num_fetches_++;
+    return BufferPoolManager::FetchPage(page_id, strategy);
+  }
+  Page *NewPage(page_id_t &page_id,
+                page_id_t hint_page_id = INVALID_PAGE_ID) override {
+    num_new_pages_++;
+    return BufferPoolManager::NewPage(page_id, hint_page_id);
+  }
+  bool UnpinPage(page_id_t page_id, bool is_dirty) override {
+    num_unpins_by_id_++;
+    return BufferPoolManager::UnpinPage(page_id, is_dirty);
+  }
+  bool UnpinPage(Page *page, bool is_dirty) override {
+    num_unpins_by_frame_++;
+    return BufferPoolManager::UnpinPage(page, is_dirty);
+  }
+
+  void ResetCounts() {
+    num_fetches_ = num_new_pages_ = num_unpins_by_id_ = num_unpins_by_frame_ =
+        0;
+  }
+
+  int num_fetches_ = 0;
+  int num_new_pages_ = 0;
+  int num_unpins_by_id_ = 0;
+  int num_unpins_by_frame_ = 0;
+};
+
+/*
+ * Every page the b+ tree and the table heap touch is looked up at most once
+ * when it is fetched, or reached through a swizzled reference, and handed
+ * back through its frame
+ */
+TEST(PageGuardTest, LookupTest) {
+  MemoryDiskManager *disk_manager = new MemoryDiskManager();
+  CountingBufferPoolManager *bpm =
+      new CountingBufferPoolManager(64, disk_manager);
+  page_id_t page_id;
+  auto header_page = static_cast<HeaderPage *>(bpm->NewPage(page_id));
+  header_page->Init(bpm->GetPageSize());
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  bpm->ResetCounts();
+  uint64_t swizzled_hits = bpm->GetNumSwizzledHits();
+
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  {
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                             comparator);
+    GenericKey<8> index_key;
+    RID rid;
+    Transaction *transaction = new Transaction(0);
+    const int64_t num_keys = 2000;
+    for (int64_t key = 0; key < num_keys; ++key) {
+      rid.Set(0, key);
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, rid, transaction);
+    }
+    std::vector<RID> rids;
+    for (int64_t key = 0; key < num_keys; ++key) {
+      rids.clear();
+      index_key.SetFromInteger(key);
+      EXPECT_TRUE(tree.GetValue(index_key, rids));
+    }
+    for (int64_t key = 0; key < num_keys; key += 2) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key, transaction);
+    }
+    int64_t current_key = 1;
+    for (auto iterator = tree.Begin(); !iterator.isEnd(); ++iterator) {
+      EXPECT_EQ(current_key, (*iterator).second.GetSlotNum());
+      current_key += 2;
+    }
+    EXPECT_EQ(num_keys + 1, current_key);
+    delete transaction;
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpined());
+  EXPECT_EQ(0, bpm->num_unpins_by_id_);
+  EXPECT_LT(0u, bpm->GetNumSwizzledHits() - swizzled_hits);
+  EXPECT_EQ(bpm->num_fetches_ + bpm->num_new_pages_ +
+                (bpm->GetNumSwizzledHits() - swizzled_hits),
+            static_cast<uint64_t>(bpm->num_unpins_by_frame_));
+  delete key_schema;
+
+  bpm->ResetCounts();
+  {
+    Schema *schema = ParseCreateStatement("a bigint, b varchar(16)");
+    Tuple tuple = ConstructTuple(schema);
+    Transaction *transaction = new Transaction(0);
+    LockManager *lock_manager = new LockManager(false);
+    TableHeap table(bpm, lock_manager, nullptr, transaction);
+    RID rid;
+    for (int i = 0; i < 1000; ++i) {
+      EXPECT_TRUE(table.InsertTuple(tuple, rid, transaction));
+    }
+    Tuple result;
+    EXPECT_TRUE(table.GetTuple(rid, result, transaction));
+    EXPECT_TRUE(table.MarkDelete(rid, transaction));
+    table.RollbackDelete(rid, transaction);
+    int num_tuples = 0;
+    for (auto iterator = table.begin(transaction); iterator != table.end();
+         ++iterator) {
+      num_tuples++;
+    }
+    EXPECT_EQ(1000, num_tuples);
+    delete lock_manager;
+    delete transaction;
+    delete schema;
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpined());
+  EXPECT_EQ(0, bpm->num_unpins_by_id_);
+  EXPECT_EQ(bpm->num_fetches_ + bpm->num_new_pages_,
+            bpm->num_unpins_by_frame_);
+
+  delete bpm;
+  delete disk_manager;
+}
+
+} // namespace scudb
@@ -0,0 +1,143 @@
+/**
+ * parallel_buffer_pool_manager_test.cpp
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "disk/memory_disk_manager.h"
+#include "disk/testing_disk_util.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(ParallelBufferPoolManagerTest, SampleTest) {
+  page_id_t temp_page_id;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  ParallelBufferPoolManager *bpm =
+      new ParallelBufferPoolManager(4, 12, disk_manager);
+
+  for (int i = 0; i < 12; ++i) {
+    auto page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, temp_page_id);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+  }
+  // every instance is pinned full, the page id is given back
+  EXPECT_EQ(nullptr, bpm->NewPage(temp_page_id));
+  EXPECT_EQ(1, disk_manager->GetNumFreePages());
+  EXPECT_FALSE(bpm->CheckAllUnpined());
+
+  // dirty pages of all instances are written in one run
+  for (int i = 0; i < 12; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, true));
+  }
+  FlushStats stats = bpm->FlushAllPages();
+  EXPECT_EQ(1, disk_manager->GetNumVectoredIOs());
+  EXPECT_EQ(12u, stats.num_pages_);
+  EXPECT_EQ(1u, stats.num_runs_);
+
+  // evict through new pages, then read back
+  for (int i = 0; i < 12; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, false));
+  }
+  char expected[PAGE_SIZE];
+  for (int i = 0; i < 12; ++i) {
+    auto page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  EXPECT_TRUE(bpm->DeletePage(3));
+  EXPECT_TRUE(bpm->CheckAllUnpined());
+
+  delete bpm;
+  delete disk_manager;
+  RemoveDatabase("test.db");
+}
+
+/*
+ * A page allocated near a hint for an instance without a free frame goes back
+ * to its extent, the object's pages stay contiguous
+ */
+TEST(ParallelBufferPoolManagerTest, HintTest) {
+  page_id_t first, page_id, next;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  ParallelBufferPoolManager *bpm =
+      new ParallelBufferPoolManager(4, 4, disk_manager);
+  ASSERT_NE(nullptr, bpm->NewPage(first));
+
+  // the extent starts at a multiple of the instance count, like first
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id, first));
+  EXPECT_EQ(0, page_id % EXTENT_SIZE);
+  EXPECT_FALSE(disk_manager->IsAllocated(page_id));
+  EXPECT_EQ(true, bpm->UnpinPage(first, false));
+
+  EXPECT_NE(nullptr, bpm->NewPage(next, first));
+  EXPECT_EQ(page_id, next);
+  EXPECT_EQ(first, disk_manager->GetExtentOwner(next));
+  EXPECT_NE(nullptr, bpm->NewPage(next, first));
+  EXPECT_EQ(page_id + 1, next);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  EXPECT_EQ(true, bpm->UnpinPage(next, false));
+
+  delete bpm;
+  delete disk_manager;
+  RemoveDatabase("test.db");
+}
+
+TEST(ParallelBufferPoolManagerTest, ScalingBenchmark) {
+  const int num_pages = 256;
+  const int ops_per_thread = 200000;
+  MemoryDiskManager *disk_manager = new MemoryDiskManager();
+
+  for (size_t num_instances : {0, 16}) {
+    BufferPoolManager *bpm =
+        num_instances == 0
+            ? new BufferPoolManager(num_pages, disk_manager)
+            : new ParallelBufferPoolManager(num_instances, num_pages,
+                                            disk_manager);
+    page_id_t page_id;
+    std::vector<page_id_t> page_ids;
+    for (int i = 0; i < num_pages; ++i) {
+      ASSERT_NE(nullptr, bpm->NewPage(page_id));
+      bpm->UnpinPage(page_id, false);
+      page_ids.push_back(page_id);
+    }
+
+    // every page is resident, only the latches are measured
+    for (int num_threads : {1, 2, 4, 8}) {
+      std::vector<std::thread> threads;
+      auto start = std::chrono::steady_clock::now();
+      for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t] {
+          std::mt19937 rng(t);
+          for (int i = 0; i < ops_per_thread; ++i) {
+            page_id_t id = page_ids[rng() % num_pages];
+            bpm->FetchPage(id);
+            bpm->UnpinPage(id, false);
+          }
+        });
+      }
+      for (auto &thread : threads)
+        thread.join();
+      double seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+      printf("%2zu instances, %d threads: %10.0f fetch/unpin per second\n",
+             std::max<size_t>(num_instances, 1), num_threads,
+             num_threads * ops_per_thread / seconds);
+    }
+    EXPECT_TRUE(bpm->CheckAllUnpined());
+    delete bpm;
+  }
+  delete disk_manager;
+}
+
+} // namespace scudb
@@ -0,0 +1,132 @@
+/**
+ * readahead_test.cpp
+ */
+
+#include <chrono>
+#include <cstdio>
+
+#include "buffer/readahead.h"
+#include "disk/simulated_disk_manager.h"
+#include "index/b_plus_tree.h"
+#include "page/header_page.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(ReadaheadTest, WindowTest) {
+  page_id_t temp_page_id;
+  MemoryDiskManager *disk_manager = new MemoryDiskManager();
+  BufferPoolManager *bpm = new BufferPoolManager(64, disk_manager);
+  for (int i = 0; i < 64; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+  }
+  bpm->FlushAllPages();
+  delete bpm;
+
+  // a cold pool
+  bpm = new BufferPoolManager(64, disk_manager);
+  {
+    Readahead readahead(bpm);
+    readahead.Advance(0);
+    readahead.Advance(1);
+    EXPECT_EQ(0u, readahead.GetWindow());
+    readahead.Advance(2);
+    EXPECT_EQ(4u, readahead.GetWindow());
+    // pages 3 to 6 are requested, the next window starts at page 4
+    readahead.Advance(3);
+    EXPECT_EQ(4u, readahead.GetWindow());
+    readahead.Advance(4);
+    EXPECT_EQ(8u, readahead.GetWindow());
+    // a jump starts over
+    readahead.Advance(40);
+    EXPECT_EQ(0u, readahead.GetWindow());
+  }
+  // pages 3 to 12 were read ahead, page 13 was not
+  int num_reads = disk_manager->GetNumReadCalls();
+  for (int i = 3; i <= 12; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  EXPECT_EQ(num_reads, disk_manager->GetNumReadCalls());
+  ASSERT_NE(nullptr, bpm->FetchPage(13));
+  EXPECT_EQ(true, bpm->UnpinPage(13, false));
+  EXPECT_EQ(num_reads + 1, disk_manager->GetNumReadCalls());
+
+  // pages never allocated are not read ahead, only page 63 is
+  num_reads = disk_manager->GetNumReadCalls();
+  {
+    Readahead readahead(bpm);
+    for (page_id_t page_id = 60; page_id < 63; ++page_id)
+      readahead.Advance(page_id);
+  }
+  EXPECT_EQ(num_reads + 1, disk_manager->GetNumReadCalls());
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(ReadaheadTest, ColdScanBenchmark) {
+  const int64_t num_keys = 50000;
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  SimulatedDiskManager *disk_manager =
+      new SimulatedDiskManager(DeviceProfile::SSD(), 4096, true);
+
+  BufferPoolManager *bpm = new BufferPoolManager(256, disk_manager);
+  page_id_t page_id;
+  auto header_page = static_cast<HeaderPage *>(bpm->NewPage(page_id));
+  header_page->Init(bpm->GetPageSize());
+  {
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                             comparator);
+    GenericKey<8> index_key;
+    RID rid;
+    Transaction *transaction = new Transaction(0);
+    for (int64_t key = 0; key < num_keys; ++key) {
+      rid.Set(0, key);
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, rid, transaction);
+    }
+    delete transaction;
+  }
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  bpm->FlushAllPages();
+  delete bpm;
+
+  for (bool readahead : {false, true}) {
+    // every scan starts from a cold pool
+    bpm = new BufferPoolManager(256, disk_manager);
+    bpm->SetReadahead(readahead);
+    page_id_t root_page_id;
+    header_page = static_cast<HeaderPage *>(bpm->FetchPage(HEADER_PAGE_ID));
+    ASSERT_TRUE(header_page->GetRootId("foo_pk", root_page_id));
+    bpm->UnpinPage(HEADER_PAGE_ID, false);
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree(
+        "foo_pk", bpm, comparator, root_page_id);
+
+    disk_manager->ResetSimulatedClock();
+    int num_reads = disk_manager->GetNumReadCalls();
+    auto start = std::chrono::steady_clock::now();
+    int64_t current_key = 0;
+    for (auto iterator = tree.Begin(); iterator.isEnd() == false;
+         ++iterator) {
+      EXPECT_EQ(current_key, (*iterator).second.GetSlotNum());
+      current_key++;
+    }
+    double scan_s = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+    EXPECT_EQ(num_keys, current_key);
+    printf("readahead %-3s: %8.1f ms scan, %8.1f ms device time, %5d read "
+           "calls\n",
+           readahead ? "on" : "off", scan_s * 1e3,
+           disk_manager->GetSimulatedNanos() / 1e6,
+           disk_manager->GetNumReadCalls() - num_reads);
+    delete bpm;
+  }
+  delete disk_manager;
+  delete key_schema;
+}
+
+} // namespace scudb
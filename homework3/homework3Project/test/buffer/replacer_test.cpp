@@ -0,0 +1,417 @@
+/**
+ * replacer_test.cpp
+ *
+ * The CLOCK, LRU-K, 2Q and ARC replacement policies, a buffer pool built
+ * with each of them, and a benchmark replaying page access traces recorded
+ * from index and table workloads against every policy.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_set>
+
+#include "buffer/arc_replacer.h"
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffered_replacer.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/replacer_factory.h"
+#include "buffer/two_q_replacer.h"
+#include "disk/memory_disk_manager.h"
+#include "index/b_plus_tree.h"
+#include "table/table_heap.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+static const ReplacerPolicy ALL_POLICIES[] = {
+    ReplacerPolicy::LRU, ReplacerPolicy::CLOCK, ReplacerPolicy::LRU_K,
+    ReplacerPolicy::TWO_Q, ReplacerPolicy::ARC};
+
+/*
+ * Replay trace on a cache of capacity pages run by replacer, the way the
+ * buffer pool drives it: a hit pins and unpins the page, a miss evicts a
+ * victim once the cache is full. Returns the number of hits
+ */
+static size_t Replay(Replacer<int> *replacer, size_t capacity,
+                     const std::vector<page_id_t> &trace) {
+  std::unordered_set<page_id_t> resident;
+  size_t hits = 0;
+  for (page_id_t page_id : trace) {
+    if (resident.count(page_id) > 0) {
+      ++hits;
+      replacer->Erase(page_id);
+    } else {
+      int victim;
+      if (resident.size() >= capacity && replacer->Victim(victim)) {
+        resident.erase(victim);
+      }
+      resident.insert(page_id);
+    }
+    replacer->Insert(page_id);
+  }
+  return hits;
+}
+
+TEST(ReplacerTest, CommonTest) {
+  for (auto policy : {ReplacerPolicy::CLOCK, ReplacerPolicy::LRU_K,
+                      ReplacerPolicy::TWO_Q, ReplacerPolicy::ARC}) {
+    std::unique_ptr<Replacer<int>> replacer(CreateReplacer<int>(policy, 8));
+    int value;
+    EXPECT_EQ(false, replacer->Victim(value));
+    for (int i = 1; i <= 6; ++i) {
+      replacer->Insert(i);
+    }
+    replacer->Insert(2);
+    EXPECT_EQ(true, replacer->Erase(3));
+    EXPECT_EQ(false, replacer->Erase(3));
+    EXPECT_EQ(5u, replacer->Size()) << ReplacerPolicyName(policy);
+
+    // peeking predicts the victims without taking them
+    std::vector<int> peeked;
+    replacer->PeekVictims(peeked, 10);
+    EXPECT_EQ(5u, peeked.size());
+    EXPECT_EQ(5u, replacer->Size());
+    for (int expected : peeked) {
+      EXPECT_EQ(true, replacer->Victim(value));
+      EXPECT_EQ(expected, value) << ReplacerPolicyName(policy);
+    }
+    EXPECT_EQ(false, replacer->Victim(value));
+    EXPECT_EQ(0u, replacer->Size());
+  }
+  for (auto policy : ALL_POLICIES) {
+    ReplacerPolicy parsed;
+    EXPECT_EQ(true, ParseReplacerPolicy(ReplacerPolicyName(policy), parsed));
+    EXPECT_EQ(policy, parsed);
+  }
+}
+
+TEST(ReplacerTest, ClockTest) {
+  ClockReplacer<int> clock_replacer;
+  int value;
+  clock_replacer.Insert(1);
+  clock_replacer.Insert(2);
+  clock_replacer.Insert(3);
+  // every bit is set, a full turn clears them
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(1, value);
+  // 2 gets a second chance, 1 comes in behind the hand
+  clock_replacer.Insert(2);
+  clock_replacer.Insert(1);
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(3, value);
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(2, value);
+  EXPECT_EQ(true, clock_replacer.Erase(1));
+  EXPECT_EQ(false, clock_replacer.Victim(value));
+}
+
+TEST(ReplacerTest, LRUKTest) {
+  LRUKReplacer<int> lru_k_replacer(2, 4);
+  int value;
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(3);
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(2);
+  // 3 was seen once, then the older second-latest access goes first
+  EXPECT_EQ(true, lru_k_replacer.Victim(value));
+  EXPECT_EQ(3, value);
+  EXPECT_EQ(true, lru_k_replacer.Victim(value));
+  EXPECT_EQ(1, value);
+
+  // history outlives pinning and eviction
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(4);
+  EXPECT_EQ(true, lru_k_replacer.Erase(2));
+  lru_k_replacer.Insert(2);
+  EXPECT_EQ(true, lru_k_replacer.Victim(value));
+  EXPECT_EQ(4, value);
+}
+
+TEST(ReplacerTest, TwoQTest) {
+  TwoQReplacer<int> two_q_replacer(8);
+  int value;
+  // A1in holds two values before it is evicted first
+  for (int i = 1; i <= 3; ++i) {
+    two_q_replacer.Insert(i);
+  }
+  // a correlated access does not move 1 out of A1in
+  two_q_replacer.Insert(1);
+  EXPECT_EQ(true, two_q_replacer.Victim(value));
+  EXPECT_EQ(1, value);
+  // remembered in A1out, so 1 comes back hot into Am
+  two_q_replacer.Insert(1);
+  two_q_replacer.Insert(4);
+  EXPECT_EQ(true, two_q_replacer.Victim(value));
+  EXPECT_EQ(2, value);
+  // an erased value keeps its place but is skipped
+  EXPECT_EQ(true, two_q_replacer.Erase(3));
+  EXPECT_EQ(true, two_q_replacer.Victim(value));
+  EXPECT_EQ(1, value);
+  EXPECT_EQ(true, two_q_replacer.Victim(value));
+  EXPECT_EQ(4, value);
+  EXPECT_EQ(false, two_q_replacer.Victim(value));
+}
+
+TEST(ReplacerTest, ARCTest) {
+  ARCReplacer<int> arc_replacer(4);
+  int value;
+  for (int i = 1; i <= 4; ++i) {
+    arc_replacer.Insert(i);
+  }
+  arc_replacer.Insert(2);
+  EXPECT_EQ(true, arc_replacer.Victim(value));
+  EXPECT_EQ(1, value);
+  EXPECT_EQ(0u, arc_replacer.GetTarget());
+  // a hit in B1 grows the target of T1 and goes to T2
+  arc_replacer.Insert(1);
+  EXPECT_EQ(1u, arc_replacer.GetTarget());
+  EXPECT_EQ(true, arc_replacer.Victim(value));
+  EXPECT_EQ(3, value);
+  // T1 is down to its target, T2 gives the victims
+  EXPECT_EQ(true, arc_replacer.Victim(value));
+  EXPECT_EQ(2, value);
+  EXPECT_EQ(true, arc_replacer.Victim(value));
+  EXPECT_EQ(1, value);
+  // a hit in B2 shrinks the target again
+  arc_replacer.Insert(2);
+  EXPECT_EQ(0u, arc_replacer.GetTarget());
+}
+
+/*
+ * Hot pages probed between stretches of a scan stay cached under the
+ * scan-resistant policies, but not under LRU
+ */
+TEST(ReplacerTest, ScanResistanceTest) {
+  std::vector<page_id_t> trace;
+  for (int round = 0; round < 3; ++round) {
+    for (int hot = 1000; hot < 1004; ++hot) {
+      trace.push_back(hot);
+    }
+  }
+  page_id_t scan_page = 0;
+  for (int round = 0; round < 20; ++round) {
+    for (int hot = 1000; hot < 1004; ++hot) {
+      trace.push_back(hot);
+    }
+    for (int i = 0; i < 6; ++i) {
+      trace.push_back(scan_page++);
+    }
+  }
+  std::unique_ptr<Replacer<int>> lru(
+      CreateReplacer<int>(ReplacerPolicy::LRU, 8));
+  size_t lru_hits = Replay(lru.get(), 8, trace);
+  for (auto policy :
+       {ReplacerPolicy::LRU_K, ReplacerPolicy::TWO_Q, ReplacerPolicy::ARC}) {
+    std::unique_ptr<Replacer<int>> replacer(CreateReplacer<int>(policy, 8));
+    size_t hits = Replay(replacer.get(), 8, trace);
+    EXPECT_LE(lru_hits + 70, hits) << ReplacerPolicyName(policy);
+  }
+}
+
+/*
+ * Frames handed to the replacers stand for the pages they hold, also after
+ * a frame was reused for another page
+ */
+TEST(ReplacerTest, BufferPoolTest) {
+  const int num_pages = 100;
+  char expected[PAGE_SIZE];
+  std::mt19937 rng(15445);
+  for (auto policy : ALL_POLICIES) {
+    MemoryDiskManager *disk_manager = new MemoryDiskManager();
+    BufferPoolManager *bpm =
+        new BufferPoolManager(10, disk_manager, nullptr, policy);
+    page_id_t page_id;
+    for (int i = 0; i < num_pages; ++i) {
+      auto page = bpm->NewPage(page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    }
+    for (int i = 0; i < 2000; ++i) {
+      // skewed towards low page ids
+      page_id = static_cast<page_id_t>(rng() % (rng() % num_pages + 1));
+      auto page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page) << ReplacerPolicyName(policy);
+      snprintf(expected, PAGE_SIZE, "page %d", page_id);
+      EXPECT_EQ(0, strcmp(page->GetData(), expected));
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      if (i % 50 == 0) {
+        // a short-lived page leaves its frame to the free list
+        ASSERT_NE(nullptr, bpm->NewPage(page_id));
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+        EXPECT_EQ(true, bpm->DeletePage(page_id));
+      }
+    }
+    EXPECT_EQ(true, bpm->CheckAllUnpined());
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+/*
+ * Records the id of every page fetched or created
+ */
+class TracingBufferPoolManager : public BufferPoolManager {
+public:
+  TracingBufferPoolManager(size_t pool_size, DiskManager *disk_manager)
+      : BufferPoolManager(pool_size, disk_manager) {}
+
+  Page *FetchPage(page_id_t page_id,
+                  BufferAccessStrategy *strategy = nullptr) override {
+    if (!in_swizzled_fetch_) {
+      trace_.push_back(page_id);
+    }
+    return BufferPoolManager::FetchPage(page_id, strategy);
+  }
+  // a swizzled fetch falls back to FetchPage, which is one access
+  Page *FetchSwizzled(page_id_t page_id, std::atomic<Page *> *ref) override {
+    trace_.push_back(page_id);
+    in_swizzled_fetch_ = true;
+    Page *page = BufferPoolManager::FetchSwizzled(page_id, ref);
+    in_swizzled_fetch_ = false;
+    return page;
+  }
+  Page *NewPage(page_id_t &page_id,
+                page_id_t hint_page_id = INVALID_PAGE_ID) override {
+    Page *page = BufferPoolManager::NewPage(page_id, hint_page_id);
+    if (page != nullptr) {
+      trace_.push_back(page_id);
+    }
+    return page;
+  }
+
+  std::vector<page_id_t> trace_;
+  bool in_swizzled_fetch_ = false;
+};
+
+/*
+ * Record the page accesses of an index load, of skewed index probes, and of
+ * the same probes interleaved with table scans, then replay each trace on
+ * every policy, directly and behind a BufferedReplacer, and report hit
+ * ratio and time per access. A trace file with one page id per line can be
+ * added with REPLACER_TRACE=<file>
+ */
+TEST(ReplacerTest, TraceBenchmark) {
+  const size_t page_size = 1024, frames = 64;
+  const int64_t num_keys = 20000;
+  std::vector<std::pair<std::string, std::vector<page_id_t>>> traces;
+
+  MemoryDiskManager *disk_manager = new MemoryDiskManager(page_size);
+  TracingBufferPoolManager *bpm =
+      new TracingBufferPoolManager(4096, disk_manager);
+  LockManager *lock_manager = new LockManager(true);
+  LogManager *log_manager = new LogManager(disk_manager);
+  Transaction *transaction = new Transaction(0);
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  Schema *schema = ParseCreateStatement("a varchar(64), b int");
+  page_id_t page_id;
+  bpm->NewPage(page_id); // header page
+  bpm->UnpinPage(page_id, true);
+
+  std::vector<int64_t> keys(num_keys);
+  for (int64_t i = 0; i < num_keys; ++i)
+    keys[i] = i;
+  std::mt19937 rng(15445);
+  std::shuffle(keys.begin(), keys.end(), rng);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  GenericKey<8> index_key;
+  RID rid;
+  for (auto key : keys) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+  TableHeap *table = new TableHeap(bpm, lock_manager, log_manager, transaction);
+  for (int i = 0; i < 5000; ++i) {
+    std::vector<Value> values{Value(TypeId::VARCHAR, "customer"),
+                              Value(TypeId::INTEGER, i)};
+    table->InsertTuple(Tuple(values, schema), rid, transaction);
+  }
+  traces.emplace_back("load", std::move(bpm->trace_));
+
+  // probes on a zipf-like key distribution, the second time with a table
+  // scan after every 2000 probes
+  std::vector<RID> rids;
+  for (bool with_scans : {false, true}) {
+    bpm->trace_.clear();
+    for (int i = 0; i < 20000; ++i) {
+      double skew = std::pow(static_cast<double>(rng()) / rng.max(), 3);
+      index_key.SetFromInteger(keys[static_cast<int64_t>(skew * (num_keys - 1))]);
+      rids.clear();
+      tree.GetValue(index_key, rids);
+      if (with_scans && i % 2000 == 1999) {
+        for (auto itr = table->begin(transaction); itr != table->end(); ++itr) {
+        }
+      }
+    }
+    traces.emplace_back(with_scans ? "probes+scans" : "probes",
+                        std::move(bpm->trace_));
+  }
+  if (const char *file = getenv("REPLACER_TRACE")) {
+    std::ifstream in(file);
+    std::vector<page_id_t> trace;
+    for (page_id_t id; in >> id;)
+      trace.push_back(id);
+    traces.emplace_back(file, std::move(trace));
+  }
+
+  for (auto &trace : traces) {
+    std::unordered_set<page_id_t> distinct(trace.second.begin(),
+                                           trace.second.end());
+    printf("%s: %zu accesses to %zu pages, %zu frames\n", trace.first.c_str(),
+           trace.second.size(), distinct.size(), frames);
+    for (auto policy : ALL_POLICIES) {
+      // the policy itself, then behind buffered inserts
+      size_t hits[2];
+      double ns[2];
+      for (int buffered = 0; buffered < 2; ++buffered) {
+        std::unique_ptr<Replacer<int>> replacer(
+            CreateReplacer<int>(policy, frames));
+        if (buffered) {
+          replacer.reset(new BufferedReplacer<int>(replacer.release()));
+        }
+        auto start = std::chrono::steady_clock::now();
+        hits[buffered] = Replay(replacer.get(), frames, trace.second);
+        ns[buffered] = std::chrono::duration<double, std::nano>(
+                           std::chrono::steady_clock::now() - start)
+                           .count() /
+                       std::max<size_t>(trace.second.size(), 1);
+      }
+      double ratio[2];
+      for (int buffered = 0; buffered < 2; ++buffered) {
+        ratio[buffered] = 100.0 * hits[buffered] /
+                          std::max<size_t>(trace.second.size(), 1);
+      }
+      printf("  %-6s hit ratio %6.2f%%, %6.1f ns per access; buffered "
+             "%6.2f%%, %6.1f ns\n",
+             ReplacerPolicyName(policy), ratio[0], ns[0], ratio[1], ns[1]);
+      EXPECT_LT(0u, hits[0]);
+      // a single thread sees the exact policy
+      EXPECT_EQ(hits[0], hits[1]);
+    }
+  }
+
+  delete table;
+  delete transaction;
+  delete bpm;
+  delete log_manager;
+  delete lock_manager;
+  delete schema;
+  delete key_schema;
+  delete disk_manager;
+}
+
+} // namespace scudb
@@ -0,0 +1,156 @@
+/**
+ * swizzle_test.cpp
+ */
+
+#include <atomic>
+
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "disk/memory_disk_manager.h"
+#include "index/b_plus_tree.h"
+#include "page/header_page.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(SwizzleTest, SampleTest) {
+  MemoryDiskManager *disk_manager = new MemoryDiskManager();
+  BufferPoolManager *bpm = new BufferPoolManager(4, disk_manager);
+  page_id_t page_id0, page_id1, temp_page_id;
+  Page *page0 = bpm->NewPage(page_id0);
+  Page *page1 = bpm->NewPage(page_id1);
+  bpm->UnpinPage(page0, false);
+  bpm->UnpinPage(page1, false);
+
+  // the first fetch swizzles the ref, later ones pin its frame
+  std::atomic<Page *> ref{nullptr};
+  EXPECT_EQ(page0, bpm->FetchSwizzled(page_id0, &ref));
+  EXPECT_EQ(page0, ref.load());
+  EXPECT_EQ(0u, bpm->GetNumSwizzledHits());
+  EXPECT_EQ(page0, bpm->FetchSwizzled(page_id0, &ref));
+  EXPECT_EQ(1u, bpm->GetNumSwizzledHits());
+  EXPECT_EQ(2, page0->GetPinCount());
+  bpm->UnpinPage(page0, false);
+  bpm->UnpinPage(page0, false);
+
+  // a ref to a frame holding another page is not followed
+  Page *page = bpm->FetchSwizzled(page_id1, &ref);
+  EXPECT_EQ(page1, page);
+  EXPECT_EQ(page1, ref.load());
+  EXPECT_EQ(1u, bpm->GetNumSwizzledHits());
+  bpm->UnpinPage(page, false);
+
+  // child refs live with the parent's frame until it gets another page
+  EXPECT_EQ(nullptr, bpm->GetChildRef(page0, -1));
+  EXPECT_EQ(nullptr, bpm->GetChildRef(
+                         page0, static_cast<int>(bpm->GetPageSize())));
+  bpm->FetchPage(page_id0);
+  std::atomic<Page *> *child_ref = bpm->GetChildRef(page0, 3);
+  ASSERT_NE(nullptr, child_ref);
+  EXPECT_EQ(nullptr, child_ref->load());
+  EXPECT_EQ(page1, bpm->FetchSwizzled(page_id1, child_ref));
+  EXPECT_EQ(child_ref, bpm->GetChildRef(page0, 3));
+  EXPECT_EQ(page1, bpm->GetChildRef(page0, 3)->load());
+  bpm->UnpinPage(page1, false);
+  bpm->UnpinPage(page0, false);
+  for (int i = 0; i < 4; ++i) {
+    bpm->UnpinPage(bpm->NewPage(temp_page_id), false);
+  }
+  // page0's frame now holds another page and the refs are gone; page1 was
+  // evicted too, so its ref fails the check
+  EXPECT_NE(page_id0, page0->GetPageId());
+  page = bpm->FetchPage(page0->GetPageId());
+  EXPECT_EQ(nullptr, bpm->GetChildRef(page, 3)->load());
+  bpm->UnpinPage(page, false);
+  uint64_t hits = bpm->GetNumSwizzledHits();
+  page = bpm->FetchSwizzled(page_id1, &ref);
+  EXPECT_EQ(page_id1, page->GetPageId());
+  EXPECT_EQ(hits, bpm->GetNumSwizzledHits());
+  bpm->UnpinPage(page, false);
+  EXPECT_TRUE(bpm->CheckAllUnpined());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// counts fetches that go through the page table
+class FetchCountingBufferPoolManager : public ParallelBufferPoolManager {
+public:
+  FetchCountingBufferPoolManager(size_t num_instances, size_t pool_size,
+                                 DiskManager *disk_manager)
+      : ParallelBufferPoolManager(num_instances, pool_size, disk_manager) {}
+
+  Page *FetchPage(page_id_t page_id,
+                  BufferAccessStrategy *strategy = nullptr) override {
+    num_fetches_++;
+    return ParallelBufferPoolManager::FetchPage(page_id, strategy);
+  }
+
+  std::atomic<int> num_fetches_{0};
+};
+
+/*
+ * Once a hot index is resident, descents reach every level through
+ * swizzled references
+ */
+TEST(SwizzleTest, BPlusTreeTest) {
+  MemoryDiskManager *disk_manager = new MemoryDiskManager();
+  FetchCountingBufferPoolManager *bpm =
+      new FetchCountingBufferPoolManager(4, 1000, disk_manager);
+  page_id_t page_id;
+  auto header_page = static_cast<HeaderPage *>(bpm->NewPage(page_id));
+  header_page->Init(bpm->GetPageSize());
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  GenericKey<8> index_key;
+  RID rid;
+  Transaction *transaction = new Transaction(0);
+  const int64_t num_keys = 2000;
+  for (int64_t key = 0; key < num_keys; ++key) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < num_keys; ++key) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.GetValue(index_key, rids));
+  }
+
+  bpm->num_fetches_ = 0;
+  uint64_t hits = bpm->GetNumSwizzledHits();
+  for (int64_t key = 0; key < num_keys; ++key) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.GetValue(index_key, rids));
+    EXPECT_EQ(key, rids[0].GetSlotNum());
+  }
+  EXPECT_EQ(0, bpm->num_fetches_);
+  // at least the root and a leaf per lookup
+  EXPECT_LE(static_cast<uint64_t>(2 * num_keys),
+            bpm->GetNumSwizzledHits() - hits);
+
+  // updates move slots; stale refs are caught and lookups stay right
+  for (int64_t key = 0; key < num_keys; key += 2) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+  }
+  for (int64_t key = 0; key < num_keys; ++key) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(key % 2 == 1, tree.GetValue(index_key, rids));
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpined());
+
+  delete transaction;
+  delete key_schema;
+  delete bpm;
+  delete disk_manager;
+}
+
+} // namespace scudb
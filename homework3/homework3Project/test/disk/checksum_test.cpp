@@ -0,0 +1,200 @@
+/**
+ * checksum_test.cpp
+ *
+ * Page checksums: known answers, detection of damaged pages, and the cost of
+ * checksumming a page compared to reading it.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "disk/checksum.h"
+#include "disk/disk_manager.h"
+#include "disk/testing_disk_util.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(ChecksumTest, Crc32cTest) {
+  EXPECT_EQ(0xe3069283, Crc32c("123456789", 9));
+  EXPECT_EQ(0xe3069283, Crc32cPortable("123456789", 9));
+  EXPECT_EQ(0, Crc32c("", 0));
+
+  // both routines agree on every length and alignment
+  std::vector<char> data(16000);
+  std::mt19937 rng(15445);
+  for (auto &c : data)
+    c = static_cast<char>(rng());
+  for (size_t start = 0; start < 8; ++start) {
+    for (size_t len = 0; len + start <= data.size(); len += 137) {
+      EXPECT_EQ(Crc32cPortable(data.data() + start, len),
+                Crc32c(data.data() + start, len));
+    }
+  }
+}
+
+TEST(ChecksumTest, DetectCorruptionTest) {
+  char data[PAGE_SIZE] = {0};
+  char buf[PAGE_SIZE] = {0};
+  char buf2[PAGE_SIZE] = {0};
+  DiskManager *disk_manager = new DiskManager("test.db");
+  strcpy(data, "A test string.");
+  disk_manager->WritePage(1, data);
+  std::vector<std::pair<page_id_t, char *>> pages{{2, buf}, {3, buf2}};
+  memcpy(buf, data, PAGE_SIZE);
+  memcpy(buf2, data, PAGE_SIZE);
+  disk_manager->WritePages(pages);
+  EXPECT_TRUE(disk_manager->ReadPage(1, buf));
+  EXPECT_TRUE(disk_manager->ReadPages(pages));
+  EXPECT_EQ(0, disk_manager->GetNumChecksumFailures());
+
+  // flip a byte of page 1 and page 3 behind the disk manager's back
+  FILE *file = fopen("test.db", "r+b");
+  ASSERT_NE(nullptr, file);
+  for (page_id_t page_id : {1, 3}) {
+    fseek(file, page_id * PAGE_SIZE + 5, SEEK_SET);
+    fputc('X', file);
+  }
+  fclose(file);
+
+  EXPECT_FALSE(disk_manager->ReadPage(1, buf));
+  EXPECT_EQ(1, disk_manager->GetNumChecksumFailures());
+  EXPECT_FALSE(disk_manager->ReadPages(pages));
+  EXPECT_EQ(2, disk_manager->GetNumChecksumFailures());
+
+  // checksums are persistent, a freed page is no longer checked
+  delete disk_manager;
+  disk_manager = new DiskManager("test.db");
+  EXPECT_FALSE(disk_manager->ReadPage(1, buf));
+  EXPECT_EQ(1, disk_manager->GetNumChecksumFailures());
+  disk_manager->DeallocatePage(1);
+  EXPECT_TRUE(disk_manager->ReadPage(1, buf));
+  EXPECT_EQ(1, disk_manager->GetNumChecksumFailures());
+  delete disk_manager;
+
+  RemoveDatabase("test.db");
+}
+
+static void CopyFile(const std::string &from, const std::string &to) {
+  std::ifstream src(from, std::ios::binary);
+  std::ofstream dst(to, std::ios::binary | std::ios::trunc);
+  dst << src.rdbuf();
+}
+
+/*
+ * Pages overwritten as is since the last sync, one by one or in a run, or
+ * compressed at the sync, still read back after a crash: the page map on disk
+ * no longer checks them against the versions of the last sync
+ */
+TEST(ChecksumTest, CrashTest) {
+  std::mt19937 rng(7);
+  std::vector<char> before(4 * PAGE_SIZE), after(4 * PAGE_SIZE);
+  for (auto &c : before)
+    c = static_cast<char>(rng());
+  for (auto &c : after)
+    c = static_cast<char>(rng());
+  char compressible[PAGE_SIZE] = {0};
+  strcpy(compressible, "A test string.");
+  char buf[PAGE_SIZE] = {0};
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  disk_manager->WritePage(1, &before[0]);
+  std::vector<std::pair<page_id_t, char *>> pages{
+      {2, &before[PAGE_SIZE]}, {3, &before[2 * PAGE_SIZE]}};
+  disk_manager->WritePages(pages);
+  disk_manager->SetCompression(true);
+  disk_manager->WritePage(4, compressible);
+  disk_manager->Sync();
+
+  // random contents do not compress, every page goes out as is
+  disk_manager->WritePage(1, &after[0]);
+  pages = {{2, &after[PAGE_SIZE]}, {3, &after[2 * PAGE_SIZE]}};
+  disk_manager->WritePages(pages);
+  disk_manager->WritePage(4, &after[3 * PAGE_SIZE]);
+  for (const char *suffix : {".db", ".fsm", ".ext", ".pmap"})
+    CopyFile(std::string("test") + suffix, std::string("crash") + suffix);
+  delete disk_manager;
+
+  DiskManager *recovered = new DiskManager("crash.db");
+  for (page_id_t i = 1; i < 5; ++i) {
+    EXPECT_TRUE(recovered->ReadPage(i, buf));
+    EXPECT_EQ(0, memcmp(buf, &after[(i - 1) * PAGE_SIZE], PAGE_SIZE));
+  }
+  EXPECT_EQ(0, recovered->GetNumChecksumFailures());
+  delete recovered;
+
+  RemoveDatabase("test.db");
+  RemoveDatabase("crash.db");
+}
+
+TEST(ChecksumTest, OverheadBenchmark) {
+  const size_t page_size = 4096;
+  const int num_pages = 256;
+  const int rounds = 20;
+  DiskManager *disk_manager = new DiskManager("test.db", false, page_size);
+  std::vector<char> data(page_size);
+  std::mt19937 rng(15445);
+  // page writes incl. checksum; their page map entries go out with the
+  // checkpoint, in one call for the adjacent pages
+  double write_ns = 0;
+  for (int i = 0; i < num_pages; ++i) {
+    for (auto &c : data)
+      c = static_cast<char>(rng());
+    auto start = std::chrono::steady_clock::now();
+    disk_manager->WritePage(i, data.data());
+    write_ns += std::chrono::duration<double, std::nano>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+  }
+  EXPECT_EQ(num_pages, disk_manager->GetNumWriteCalls());
+  disk_manager->Sync();
+  EXPECT_EQ(num_pages + 1, disk_manager->GetNumWriteCalls());
+
+  // page reads served from the kernel cache, i.e. the cheapest case
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; ++r)
+    for (int i = 0; i < num_pages; ++i)
+      disk_manager->ReadPage(i, data.data());
+  double read_ns = std::chrono::duration<double, std::nano>(
+                       std::chrono::steady_clock::now() - start)
+                       .count() /
+                   (rounds * num_pages);
+
+  uint32_t sum = 0;
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds * num_pages; ++r)
+    sum += Crc32c(data.data(), page_size);
+  double crc_ns = std::chrono::duration<double, std::nano>(
+                      std::chrono::steady_clock::now() - start)
+                      .count() /
+                  (rounds * num_pages);
+
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds * num_pages; ++r)
+    sum += Crc32cPortable(data.data(), page_size);
+  double portable_ns = std::chrono::duration<double, std::nano>(
+                           std::chrono::steady_clock::now() - start)
+                           .count() /
+                       (rounds * num_pages);
+
+  printf("page write incl. checksum: %7.0f ns, %.2f write calls per page\n",
+         write_ns / num_pages,
+         static_cast<double>(disk_manager->GetNumWriteCalls()) / num_pages);
+  printf("page read incl. checksum: %8.0f ns\n", read_ns);
+  printf("crc32c %-8s        : %8.0f ns (%.1f%% of a read)\n",
+         Crc32cHardwareAvailable() ? "sse4.2" : "portable", crc_ns,
+         100 * crc_ns / read_ns);
+  printf("crc32c portable         : %8.0f ns (%.1f%% of a read) [%u]\n",
+         portable_ns, 100 * portable_ns / read_ns, sum & 1);
+  EXPECT_EQ(0, disk_manager->GetNumChecksumFailures());
+
+  delete disk_manager;
+  RemoveDatabase("test.db");
+}
+
+} // namespace scudb
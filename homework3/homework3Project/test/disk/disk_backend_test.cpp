@@ -0,0 +1,162 @@
+/**
+ * disk_backend_test.cpp
+ *
+ * The in-memory and simulated-device disk manager backends, and a
+ * deterministic comparison of index and table workloads on modelled devices.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "buffer/buffer_pool_manager.h"
+#include "disk/memory_disk_manager.h"
+#include "disk/simulated_disk_manager.h"
+#include "index/b_plus_tree.h"
+#include "table/table_heap.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(DiskBackendTest, MemoryBackendTest) {
+  DiskManager *disk_manager = new MemoryDiskManager();
+  BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager);
+
+  // pages survive eviction
+  page_id_t page_id;
+  for (int i = 0; i < 20; ++i) {
+    auto page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, page_id);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    bpm->UnpinPage(page_id, true);
+  }
+  char expected[PAGE_SIZE];
+  for (int i = 0; i < 20; ++i) {
+    auto page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    bpm->UnpinPage(i, false);
+  }
+
+  // asynchronous requests and the log go through the backend too
+  char buf[PAGE_SIZE] = {0};
+  disk_manager->ReadPageAsync(3, buf).wait();
+  EXPECT_EQ(0, strcmp(buf, "page 3"));
+  char log[16] = "log record";
+  disk_manager->WriteLog(log, 11);
+  memset(buf, 0, PAGE_SIZE);
+  EXPECT_TRUE(disk_manager->ReadLog(buf, 32, 0));
+  EXPECT_EQ(0, strcmp(buf, "log record"));
+  EXPECT_FALSE(disk_manager->ReadLog(buf, 32, 11));
+  EXPECT_EQ(1, disk_manager->GetNumFlushes());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(DiskBackendTest, SimulatedDeviceTest) {
+  SimulatedDiskManager *disk_manager =
+      new SimulatedDiskManager(DeviceProfile::HDD(), 4096);
+  std::vector<char> data(64 * 4096);
+  std::vector<std::pair<page_id_t, char *>> pages;
+  for (int i = 0; i < 64; ++i)
+    pages.emplace_back(i, data.data() + i * 4096);
+
+  // one coalesced request is far cheaper than scattered single pages
+  disk_manager->WritePages(pages);
+  uint64_t batched = disk_manager->GetSimulatedNanos();
+  disk_manager->ResetSimulatedClock();
+  for (int i = 63; i >= 0; --i)
+    disk_manager->WritePage(i, data.data() + i * 4096);
+  EXPECT_LT(10 * batched, disk_manager->GetSimulatedNanos());
+
+  // sequential single reads only pay the sequential latency
+  disk_manager->ResetSimulatedClock();
+  disk_manager->ReadPage(0, data.data());
+  uint64_t first = disk_manager->GetSimulatedNanos();
+  for (int i = 1; i < 64; ++i)
+    disk_manager->ReadPage(i, data.data());
+  EXPECT_GT(first, disk_manager->GetSimulatedNanos() - first);
+  delete disk_manager;
+}
+
+TEST(DiskBackendTest, DeviceBenchmark) {
+  const size_t page_size = 4096;
+  const int64_t num_keys = 20000;
+  std::vector<int64_t> keys(num_keys);
+  for (int64_t i = 0; i < num_keys; ++i)
+    keys[i] = i;
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  Schema *schema = ParseCreateStatement("a varchar(64), b int");
+  LockManager *lock_manager = new LockManager(true);
+
+  for (auto device : {std::make_pair("ssd", DeviceProfile::SSD()),
+                      std::make_pair("hdd", DeviceProfile::HDD())}) {
+    SimulatedDiskManager *disk_manager =
+        new SimulatedDiskManager(device.second, page_size);
+    LogManager *log_manager = new LogManager(disk_manager);
+    BufferPoolManager *bpm = new BufferPoolManager(16, disk_manager);
+    Transaction *transaction = new Transaction(0);
+    page_id_t page_id;
+    bpm->NewPage(page_id); // header page
+    bpm->UnpinPage(page_id, true);
+
+    // random inserts and lookups into an index larger than the pool
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                             comparator);
+    GenericKey<8> index_key;
+    RID rid;
+    for (auto key : keys) {
+      rid.Set(0, key);
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, rid, transaction);
+    }
+    uint64_t insert_ns = disk_manager->GetSimulatedNanos();
+    disk_manager->ResetSimulatedClock();
+    std::vector<RID> rids;
+    for (int64_t i = 0; i < num_keys; i += 10) {
+      rids.clear();
+      index_key.SetFromInteger(keys[i]);
+      tree.GetValue(index_key, rids);
+    }
+    uint64_t lookup_ns = disk_manager->GetSimulatedNanos();
+
+    // load and scan a table heap
+    disk_manager->ResetSimulatedClock();
+    TableHeap *table =
+        new TableHeap(bpm, lock_manager, log_manager, transaction);
+    for (int i = 0; i < 5000; ++i) {
+      std::vector<Value> values{Value(TypeId::VARCHAR, "customer"),
+                                Value(TypeId::INTEGER, i)};
+      table->InsertTuple(Tuple(values, schema), rid, transaction);
+    }
+    bpm->FlushAllPages();
+    disk_manager->ResetSimulatedClock();
+    int count = 0;
+    for (auto itr = table->begin(transaction); itr != table->end(); ++itr)
+      ++count;
+    EXPECT_EQ(5000, count);
+    uint64_t scan_ns = disk_manager->GetSimulatedNanos();
+
+    printf("%s: %8.1f ms b+ tree inserts, %8.1f ms lookups, %8.1f ms table "
+           "scan\n",
+           device.first, insert_ns / 1e6, lookup_ns / 1e6, scan_ns / 1e6);
+    delete table;
+    delete transaction;
+    delete bpm;
+    delete log_manager;
+    delete disk_manager;
+  }
+
+  delete lock_manager;
+  delete schema;
+  delete key_schema;
+}
+
+} // namespace scudb
@@ -0,0 +1,364 @@
+/**
+ * disk_manager_test.cpp
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "disk/testing_disk_util.h"
+#include "page/header_page.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(DiskManagerTest, ReadWriteTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  DiskManager *disk_manager = new DiskManager("test.db");
+
+  strcpy(data, "A test string.");
+  // tolerate empty read
+  disk_manager->ReadPage(0, buf);
+
+  disk_manager->WritePage(0, data);
+  disk_manager->ReadPage(0, buf);
+  EXPECT_EQ(0, memcmp(buf, data, PAGE_SIZE));
+
+  memset(buf, 0, PAGE_SIZE);
+  disk_manager->WritePage(5, data);
+  disk_manager->ReadPage(5, buf);
+  EXPECT_EQ(0, memcmp(buf, data, PAGE_SIZE));
+
+  delete disk_manager;
+  RemoveDatabase("test.db");
+}
+
+TEST(DiskManagerTest, DirectIOTest) {
+  char buf[PAGE_SIZE + 1] = {0};
+  char data[PAGE_SIZE + 1] = {0};
+  DiskManager *disk_manager = new DiskManager("test.db", true);
+  // direct I/O is only used when pages are suitably aligned
+  if (PAGE_SIZE % DIRECT_IO_ALIGNMENT != 0) {
+    EXPECT_FALSE(disk_manager->IsDirectIO());
+  }
+
+  // unaligned buffers are bounced internally
+  strcpy(data + 1, "A test string.");
+  disk_manager->WritePage(3, data + 1);
+  disk_manager->ReadPage(3, buf + 1);
+  EXPECT_EQ(0, memcmp(buf + 1, data + 1, PAGE_SIZE));
+
+  delete disk_manager;
+  RemoveDatabase("test.db");
+}
+
+TEST(DiskManagerTest, PageSizeTest) {
+  const size_t page_size = 8192;
+  DiskManager *disk_manager = new DiskManager("test.db", false, page_size);
+  BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager);
+  EXPECT_EQ(page_size, disk_manager->GetPageSize());
+  EXPECT_EQ(page_size, bpm->GetPageSize());
+
+  // header page records the page size chosen at creation
+  page_id_t header_page_id;
+  auto header_page = static_cast<HeaderPage *>(bpm->NewPage(header_page_id));
+  ASSERT_NE(nullptr, header_page);
+  header_page->Init(bpm->GetPageSize());
+  EXPECT_TRUE(header_page->InsertRecord("foo", 1));
+  bpm->UnpinPage(header_page_id, true);
+  bpm->FlushPage(header_page_id);
+  delete bpm;
+  delete disk_manager;
+
+  // reopening ignores the requested size in favour of the recorded one
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(page_size, disk_manager->GetPageSize());
+  std::vector<char> buf(page_size);
+  disk_manager->ReadPage(HEADER_PAGE_ID, buf.data());
+  EXPECT_EQ(page_size, *reinterpret_cast<uint32_t *>(buf.data() +
+                                                     HEADER_PAGE_SIZE_OFFSET));
+  delete disk_manager;
+
+  // invalid sizes fall back to the default
+  disk_manager = new DiskManager("test2.db", false, 1000);
+  EXPECT_EQ(PAGE_SIZE, disk_manager->GetPageSize());
+  delete disk_manager;
+
+  RemoveDatabase("test.db");
+  RemoveDatabase("test2.db");
+}
+
+TEST(DiskManagerTest, AsyncBatchTest) {
+  const int num_pages = 64;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  std::vector<std::vector<char>> data(num_pages, std::vector<char>(PAGE_SIZE));
+  std::vector<std::vector<char>> buf(num_pages, std::vector<char>(PAGE_SIZE));
+
+  // write every page in one batch
+  std::vector<DiskRequest> requests;
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < num_pages; ++i) {
+    snprintf(data[i].data(), PAGE_SIZE, "page %d", i);
+    requests.emplace_back(true, i, data[i].data());
+    futures.push_back(requests.back().callback_.get_future());
+  }
+  disk_manager->SubmitBatch(requests);
+  EXPECT_TRUE(requests.empty());
+  for (auto &f : futures)
+    f.wait();
+  futures.clear();
+
+  // read them back from several threads at once
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = t; i < num_pages; i += 4) {
+        disk_manager->ReadPageAsync(i, buf[i].data()).wait();
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+  for (int i = 0; i < num_pages; ++i) {
+    EXPECT_EQ(0, memcmp(buf[i].data(), data[i].data(), PAGE_SIZE));
+  }
+
+  delete disk_manager;
+  RemoveDatabase("test.db");
+}
+
+TEST(DiskManagerTest, VectoredIOTest) {
+  const int num_pages = 8;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  std::vector<std::vector<char>> data(num_pages, std::vector<char>(PAGE_SIZE));
+  std::vector<std::vector<char>> buf(num_pages, std::vector<char>(PAGE_SIZE));
+
+  // pages 0-2 and 5-7 out of order, two runs
+  std::vector<std::pair<page_id_t, char *>> writes;
+  for (int i : {6, 1, 7, 0, 5, 2}) {
+    snprintf(data[i].data(), PAGE_SIZE, "page %d", i);
+    writes.emplace_back(i, data[i].data());
+  }
+  disk_manager->WritePages(writes);
+  EXPECT_EQ(2, disk_manager->GetNumVectoredIOs());
+
+  // one run, the missing pages and those past the end read as zeroes
+  std::vector<std::pair<page_id_t, char *>> reads;
+  for (int i = 0; i < num_pages; ++i) {
+    memset(buf[i].data(), 'x', PAGE_SIZE);
+    reads.emplace_back(i, buf[i].data());
+  }
+  reads.emplace_back(num_pages, data[3].data());
+  disk_manager->ReadPages(reads);
+  EXPECT_EQ(3, disk_manager->GetNumVectoredIOs());
+  for (int i = 0; i < num_pages; ++i) {
+    EXPECT_EQ(0, memcmp(buf[i].data(), data[i].data(), PAGE_SIZE));
+  }
+
+  delete disk_manager;
+  RemoveDatabase("test.db");
+}
+
+TEST(DiskManagerTest, DurabilityTest) {
+  char data[PAGE_SIZE] = {0};
+  char buf[PAGE_SIZE] = {0};
+  DiskManager *disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(DurabilityMode::CHECKPOINT_ONLY,
+            disk_manager->GetDurabilityMode());
+
+  // checkpoint-only: one write per page, syncs only on request
+  for (int i = 0; i < 2 * WRITE_BATCH_SIZE; ++i)
+    disk_manager->WritePage(i, data);
+  EXPECT_EQ(2 * WRITE_BATCH_SIZE, disk_manager->GetNumWriteCalls());
+  EXPECT_EQ(0, disk_manager->GetNumSyncs());
+  disk_manager->Sync();
+  EXPECT_EQ(1, disk_manager->GetNumSyncs());
+
+  // sync-each-write: one sync per page; the checkpoint wrote the page map
+  // entries of all pages with one call, and rewriting the same contents
+  // neither clears nor changes them
+  disk_manager->SetDurabilityMode(DurabilityMode::SYNC_EACH_WRITE);
+  for (int i = 0; i < 2 * WRITE_BATCH_SIZE; ++i)
+    disk_manager->WritePage(i, data);
+  EXPECT_EQ(4 * WRITE_BATCH_SIZE + 1, disk_manager->GetNumWriteCalls());
+  EXPECT_EQ(2 * WRITE_BATCH_SIZE + 1, disk_manager->GetNumSyncs());
+
+  // batched: staged pages are readable, full batches go out together
+  disk_manager->SetDurabilityMode(DurabilityMode::BATCHED);
+  int write_calls = disk_manager->GetNumWriteCalls();
+  int syncs = disk_manager->GetNumSyncs();
+  strcpy(data, "A test string.");
+  for (int i = 0; i < WRITE_BATCH_SIZE - 1; ++i)
+    disk_manager->WritePage(i, data);
+  disk_manager->ReadPage(3, buf);
+  EXPECT_EQ(0, memcmp(buf, data, PAGE_SIZE));
+  EXPECT_EQ(write_calls, disk_manager->GetNumWriteCalls());
+  // one write to clear the old page map entries, one for the pages and one
+  // for their new entries
+  disk_manager->WritePage(WRITE_BATCH_SIZE - 1, data);
+  EXPECT_EQ(write_calls + 3, disk_manager->GetNumWriteCalls());
+  EXPECT_EQ(syncs + 1, disk_manager->GetNumSyncs());
+
+  // staged pages are not lost on shutdown
+  disk_manager->WritePage(2 * WRITE_BATCH_SIZE, data);
+  delete disk_manager;
+  disk_manager = new DiskManager("test.db");
+  memset(buf, 0, PAGE_SIZE);
+  disk_manager->ReadPage(2 * WRITE_BATCH_SIZE, buf);
+  EXPECT_EQ(0, memcmp(buf, data, PAGE_SIZE));
+
+  // but a staged page freed meanwhile is dropped
+  disk_manager->SetDurabilityMode(DurabilityMode::BATCHED);
+  page_id_t page_id = disk_manager->AllocatePage();
+  disk_manager->WritePage(page_id, data);
+  disk_manager->DeallocatePage(page_id);
+  uint64_t bytes_written = disk_manager->GetNumBytesWritten();
+  disk_manager->Sync();
+  EXPECT_EQ(bytes_written, disk_manager->GetNumBytesWritten());
+  EXPECT_TRUE(disk_manager->ReadPage(page_id, buf));
+  EXPECT_NE(0, memcmp(buf, data, PAGE_SIZE));
+  delete disk_manager;
+
+  RemoveDatabase("test.db");
+}
+
+/*
+ * A sync leaves the page map and allocation state on disk with the pages,
+ * so a second instance opened without a shutdown of the first, as after a
+ * crash, decodes compressed pages and sees freed ones
+ */
+TEST(DiskManagerTest, SyncSideFilesTest) {
+  const size_t page_size = 4096;
+  std::vector<char> data(page_size), buf(page_size);
+  DiskManager *disk_manager = new DiskManager("test.db", false, page_size);
+  *reinterpret_cast<uint32_t *>(data.data() + HEADER_MAGIC_OFFSET) =
+      HEADER_MAGIC;
+  *reinterpret_cast<uint32_t *>(data.data() + HEADER_PAGE_SIZE_OFFSET) =
+      page_size;
+  disk_manager->WritePage(disk_manager->AllocatePage(), data.data());
+  disk_manager->SetCompression(true);
+  for (int i = 1; i < 4; ++i) {
+    page_id_t page_id = disk_manager->AllocatePage();
+    snprintf(data.data(), 16, "page %d", page_id);
+    disk_manager->WritePage(page_id, data.data());
+  }
+  disk_manager->DeallocatePage(2);
+  disk_manager->Sync();
+
+  DiskManager *recovered = new DiskManager("test.db");
+  EXPECT_EQ(page_size, recovered->GetPageSize());
+  EXPECT_EQ(1, recovered->GetNumFreePages());
+  for (page_id_t page_id : {1, 3}) {
+    EXPECT_TRUE(recovered->ReadPage(page_id, buf.data()));
+    snprintf(data.data(), 16, "page %d", page_id);
+    EXPECT_STREQ(data.data(), buf.data());
+  }
+  EXPECT_EQ(0, recovered->GetNumChecksumFailures());
+  delete recovered;
+  delete disk_manager;
+
+  RemoveDatabase("test.db");
+}
+
+TEST(DiskManagerTest, FreePageTest) {
+  char data[PAGE_SIZE] = {0};
+  DiskManager *disk_manager = new DiskManager("test.db");
+  for (page_id_t i = 0; i < 10; ++i) {
+    EXPECT_EQ(i, disk_manager->AllocatePage());
+    disk_manager->WritePage(i, data);
+  }
+
+  // freed pages are reused most recent first, double frees are ignored
+  disk_manager->DeallocatePage(3);
+  disk_manager->DeallocatePage(7);
+  disk_manager->DeallocatePage(7);
+  disk_manager->DeallocatePage(42);
+  EXPECT_EQ(2, disk_manager->GetNumFreePages());
+  EXPECT_EQ(7, disk_manager->AllocatePage());
+  disk_manager->DeallocatePage(5);
+  delete disk_manager;
+
+  // allocation state survives a restart
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(2, disk_manager->GetNumFreePages());
+  EXPECT_EQ(5, disk_manager->AllocatePage());
+  EXPECT_EQ(3, disk_manager->AllocatePage());
+  EXPECT_EQ(10, disk_manager->AllocatePage());
+
+  // punched holes read back as zeroes
+  disk_manager->SetPunchHoles(true);
+  strcpy(data, "A test string.");
+  disk_manager->WritePage(4, data);
+  disk_manager->DeallocatePage(4);
+  char buf[PAGE_SIZE];
+  memset(buf, 'x', PAGE_SIZE);
+  EXPECT_TRUE(disk_manager->ReadPage(4, buf));
+  EXPECT_TRUE(std::all_of(buf, buf + PAGE_SIZE, [](char c) { return c == 0; }));
+  delete disk_manager;
+
+  RemoveDatabase("test.db");
+}
+
+TEST(DiskManagerTest, ExtentTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  page_id_t first_a = disk_manager->AllocatePage();
+  page_id_t first_b = disk_manager->AllocatePage();
+  EXPECT_EQ(INVALID_PAGE_ID, disk_manager->GetExtentOwner(first_a));
+
+  // interleaved growth of two objects stays contiguous per object
+  std::vector<page_id_t> pages_a{first_a}, pages_b{first_b};
+  for (int i = 0; i < EXTENT_SIZE + 10; ++i) {
+    pages_a.push_back(disk_manager->AllocatePage(pages_a.back()));
+    pages_b.push_back(disk_manager->AllocatePage(pages_b.back()));
+  }
+  for (size_t i = 2; i < pages_a.size(); ++i) {
+    if (pages_a[i] % EXTENT_SIZE != 0) {
+      EXPECT_EQ(pages_a[i - 1] + 1, pages_a[i]);
+      EXPECT_EQ(pages_b[i - 1] + 1, pages_b[i]);
+    }
+  }
+  EXPECT_EQ(0, pages_a[1] % EXTENT_SIZE);
+  EXPECT_EQ(first_a, disk_manager->GetExtentOwner(pages_a.back()));
+  EXPECT_EQ(first_b, disk_manager->GetExtentOwner(pages_b.back()));
+  // pages skipped to align the first extent are not lost
+  EXPECT_EQ(EXTENT_SIZE - 2, disk_manager->GetNumFreePages());
+  delete disk_manager;
+
+  // owners and fill levels survive a restart
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(first_a, disk_manager->GetExtentOwner(pages_a.back()));
+  EXPECT_EQ(pages_a.back() + 1, disk_manager->AllocatePage(pages_a.back()));
+  EXPECT_EQ(pages_b.back() + 1, disk_manager->AllocatePage(first_b));
+
+  // an object reusing the first page of a dropped one gets its own extent,
+  // the unused rest of the old one is freed
+  size_t num_free = disk_manager->GetNumFreePages();
+  disk_manager->DeallocatePage(first_b);
+  EXPECT_LT(num_free + 1, disk_manager->GetNumFreePages());
+  EXPECT_EQ(INVALID_PAGE_ID, disk_manager->GetExtentOwner(pages_b[1]));
+  EXPECT_EQ(INVALID_PAGE_ID, disk_manager->GetExtentOwner(pages_b.back()));
+  EXPECT_EQ(first_b, disk_manager->AllocatePage());
+  page_id_t page_id = disk_manager->AllocatePage(first_b);
+  EXPECT_EQ(0, page_id % EXTENT_SIZE);
+  EXPECT_LT(std::max(pages_a.back(), pages_b.back()), page_id);
+  // a hint into an extent of the dropped object does not lead to the new one
+  page_id_t stray = disk_manager->AllocatePage(pages_b[1]);
+  EXPECT_EQ(pages_b[1], disk_manager->GetExtentOwner(stray));
+  EXPECT_EQ(page_id + EXTENT_SIZE, stray);
+  delete disk_manager;
+
+  // also after a restart
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(INVALID_PAGE_ID, disk_manager->GetExtentOwner(pages_b.back()));
+  EXPECT_EQ(page_id + 1, disk_manager->AllocatePage(first_b));
+  EXPECT_EQ(stray + 1, disk_manager->AllocatePage(stray));
+  delete disk_manager;
+
+  RemoveDatabase("test.db");
+}
+
+} // namespace scudb
@@ -0,0 +1,83 @@
+/**
+ * lock_free_hash_test.cpp
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "hash/lock_free_hash.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(LockFreeHashTest, SampleTest) {
+  LockFreeHash<int, int> test(4, -1, -2);
+  EXPECT_EQ(8u, test.GetCapacity());
+
+  for (int i = 0; i < 4; ++i) {
+    test.Insert(i, i * 10);
+  }
+  int result = 0;
+  EXPECT_TRUE(test.Find(3, result));
+  EXPECT_EQ(30, result);
+  EXPECT_FALSE(test.Find(4, result));
+  // overwrite an existing key
+  test.Insert(3, 33);
+  EXPECT_TRUE(test.Find(3, result));
+  EXPECT_EQ(33, result);
+
+  EXPECT_TRUE(test.Remove(3));
+  EXPECT_FALSE(test.Remove(3));
+  EXPECT_FALSE(test.Find(3, result));
+
+  test.Insert(3, 30);
+
+  // churn far beyond the capacity, tombstones are reused or purged
+  for (int i = 4; i < 1000; ++i) {
+    EXPECT_TRUE(test.Remove(i - 4));
+    test.Insert(i, i * 10);
+  }
+  for (int i = 996; i < 1000; ++i) {
+    EXPECT_TRUE(test.Find(i, result));
+    EXPECT_EQ(i * 10, result);
+  }
+  EXPECT_FALSE(test.Find(995, result));
+}
+
+TEST(LockFreeHashTest, ConcurrentReadTest) {
+  const int num_keys = 64;
+  LockFreeHash<int, int> test(num_keys, -1, -2);
+  for (int i = 0; i < num_keys; i += 2) {
+    test.Insert(i, i * 10);
+  }
+  // readers run against a single writer that moves odd keys in and out
+  std::atomic<bool> done(false);
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 3; ++t) {
+    readers.emplace_back([&] {
+      while (!done) {
+        for (int i = 0; i < num_keys; ++i) {
+          int result = 0;
+          if (test.Find(i, result)) {
+            EXPECT_EQ(i * 10, result);
+          }
+        }
+      }
+    });
+  }
+  for (int round = 0; round < 2000; ++round) {
+    for (int i = 1; i < num_keys; i += 2) {
+      test.Insert(i, i * 10);
+    }
+    for (int i = 1; i < num_keys; i += 2) {
+      test.Remove(i);
+    }
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+}
+
+} // namespace scudb
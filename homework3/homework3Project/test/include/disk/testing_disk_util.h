@@ -0,0 +1,21 @@
+/**
+ * testing_disk_util.h
+ */
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+
+namespace scudb {
+
+// remove a database file with the log and side files DiskManager keeps next
+// to it, their names derive from the db file in the same way
+inline void RemoveDatabase(const std::string &db_file) {
+  std::string base = db_file.substr(0, db_file.find("."));
+  for (const char *suffix : {".log", ".fsm", ".ext", ".pmap"})
+    std::remove((base + suffix).c_str());
+  std::remove(db_file.c_str());
+}
+
+} // namespace scudb
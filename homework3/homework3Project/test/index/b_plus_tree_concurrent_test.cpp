@@ -12,6 +12,7 @@
 
 #include "buffer/buffer_pool_manager.h"
 #include "common/logger.h"
+#include "disk/testing_disk_util.h"
 #include "index/b_plus_tree.h"
 #include "vtable/virtual_table.h"
 #include "gtest/gtest.h"
@@ -203,8 +204,7 @@ TEST(BPlusTreeConcurrentTest, InsertTest1) {
   delete key_schema;
   delete disk_manager;
   delete bpm;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 
 TEST(BPlusTreeConcurrentTest, InsertTest2) {
@@ -258,8 +258,7 @@ TEST(BPlusTreeConcurrentTest, InsertTest2) {
   delete key_schema;
   delete disk_manager;
   delete bpm;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 
 TEST(BPlusTreeConcurrentTest, InsertAndGetTest) {
@@ -315,8 +314,7 @@ TEST(BPlusTreeConcurrentTest, InsertAndGetTest) {
   delete key_schema;
   delete disk_manager;
   delete bpm;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 
 TEST(BPlusTreeConcurrentTest, DeleteTest1) {
@@ -362,8 +360,7 @@ TEST(BPlusTreeConcurrentTest, DeleteTest1) {
   delete key_schema;
   delete disk_manager;
   delete bpm;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 TEST(BPlusTreeConcurrentTest, DeleteAndGetTest) {
   // create KeyComparator and index schema
@@ -408,8 +405,7 @@ TEST(BPlusTreeConcurrentTest, DeleteAndGetTest) {
   delete key_schema;
   delete disk_manager;
   delete bpm;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 TEST(BPlusTreeConcurrentTest, DeleteTest2) {
   // create KeyComparator and index schema
@@ -455,8 +451,7 @@ TEST(BPlusTreeConcurrentTest, DeleteTest2) {
   delete key_schema;
   delete disk_manager;
   delete bpm;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 
 TEST(BPlusTreeConcurrentTest, DeleteTest3) {
@@ -505,7 +500,7 @@ TEST(BPlusTreeConcurrentTest, DeleteTest3) {
   delete key_schema;
   delete disk_manager;
   delete bpm;
-  remove("test.db");
+  RemoveDatabase("test.db");
 }
 
 TEST(BPlusTreeConcurrentTest, DeleteTest4) {
@@ -556,7 +551,7 @@ TEST(BPlusTreeConcurrentTest, DeleteTest4) {
   delete key_schema;
   delete disk_manager;
   delete bpm;
-  remove("test.db");
+  RemoveDatabase("test.db");
 }
 
 TEST(BPlusTreeConcurrentTest, DeleteTest5) {
@@ -610,7 +605,7 @@ TEST(BPlusTreeConcurrentTest, DeleteTest5) {
   delete bpm;
   delete key_schema;
   delete disk_manager;
-  remove("test.db");
+  RemoveDatabase("test.db");
 }
 
 
@@ -659,8 +654,7 @@ TEST(BPlusTreeConcurrentTest, MixTest) {
   delete key_schema;
   delete disk_manager;
   delete bpm;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 TEST(BPlusTreeConcurrentTest, MixTest2) {
   // create KeyComparator and index schema
@@ -724,8 +718,7 @@ TEST(BPlusTreeConcurrentTest, MixTest2) {
   delete key_schema;
   delete disk_manager;
   delete bpm;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 TEST(BPlusTreeConcurrentTest, MixTest3) {
   // create KeyComparator and index schema
@@ -819,8 +812,7 @@ TEST(BPlusTreeConcurrentTest, MixTest3) {
   delete key_schema;
   delete disk_manager;
   delete bpm;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 
 } // namespace scudb
@@ -9,6 +9,7 @@
 
 #include "buffer/buffer_pool_manager.h"
 #include "common/logger.h"
+#include "disk/testing_disk_util.h"
 #include "index/b_plus_tree.h"
 #include "vtable/virtual_table.h"
 #include "gtest/gtest.h"
@@ -97,8 +98,7 @@ TEST(BPlusTreeDeleteTests, DeleteTest1) {
   delete disk_manager;
   delete bpm;
   delete key_schema;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 
 TEST(BPlusTreeDeleteTests, DeleteTest2) {
@@ -179,8 +179,7 @@ TEST(BPlusTreeDeleteTests, DeleteTest2) {
   delete disk_manager;
   delete bpm;
   delete key_schema;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 TEST(BPlusTreeDeleteTests, DeleteBasic) {
   // create KeyComparator and index schema
@@ -255,8 +254,7 @@ TEST(BPlusTreeDeleteTests, DeleteBasic) {
   delete disk_manager;
   delete bpm;
   delete key_schema;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 
 TEST(BPlusTreeDeleteTests, DeleteScale) {
@@ -341,8 +339,7 @@ TEST(BPlusTreeDeleteTests, DeleteScale) {
   delete disk_manager;
   delete bpm;
   delete key_schema;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 TEST(BPlusTreeDeleteTests, DeleteRandom) {
   // create KeyComparator and index schema
@@ -391,8 +388,7 @@ TEST(BPlusTreeDeleteTests, DeleteRandom) {
   delete disk_manager;
   delete bpm;
   delete key_schema;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 
 } // namespace scudb
@@ -9,6 +9,7 @@
 
 #include "buffer/buffer_pool_manager.h"
 #include "common/logger.h"
+#include "disk/testing_disk_util.h"
 #include "index/b_plus_tree.h"
 #include "vtable/virtual_table.h"
 #include "gtest/gtest.h"
@@ -75,8 +76,7 @@ TEST(BPlusTreeInsertTests, InsertTest1) {
   delete disk_manager;
   delete bpm;
   delete key_schema;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 
 TEST(BPlusTreeInsertTests, InsertTest2) {
@@ -147,12 +147,10 @@ TEST(BPlusTreeInsertTests, InsertTest2) {
   delete disk_manager;
   delete bpm;
   delete key_schema;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 TEST(BPlusTreeInsertTests, InsertScale) {
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
   GenericComparator<16> comparator(key_schema);
@@ -218,13 +216,11 @@ TEST(BPlusTreeInsertTests, InsertScale) {
   delete disk_manager;
   delete bpm;
   delete key_schema;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 
 TEST(BPlusTreeInsertTests, InsertReverse) {
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
   GenericComparator<16> comparator(key_schema);
@@ -289,8 +285,7 @@ TEST(BPlusTreeInsertTests, InsertReverse) {
   delete disk_manager;
   delete bpm;
   delete key_schema;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 
 TEST(BPlusTreeInsertTests, InsertRandom) {
@@ -362,8 +357,7 @@ TEST(BPlusTreeInsertTests, InsertRandom) {
   delete disk_manager;
   delete bpm;
   delete key_schema;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 
 
@@ -0,0 +1,85 @@
+/**
+ * b_plus_tree_page_size_test.cpp
+ *
+ * Compare point lookup and range scan throughput of the b+ tree across the
+ * page sizes a database may be created with.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#include "buffer/buffer_pool_manager.h"
+#include "disk/testing_disk_util.h"
+#include "index/b_plus_tree.h"
+#include "page/header_page.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(BPlusTreePageSizeTest, LookupScanBenchmark) {
+  const int64_t num_keys = 20000;
+  std::vector<int64_t> keys(num_keys);
+  for (int64_t i = 0; i < num_keys; ++i)
+    keys[i] = i;
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  for (size_t page_size : {4096, 8192, 16384, 32768}) {
+    DiskManager *disk_manager = new DiskManager("test.db", false, page_size);
+    BufferPoolManager *bpm = new BufferPoolManager(64, disk_manager);
+    ASSERT_EQ(page_size, bpm->GetPageSize());
+
+    page_id_t page_id;
+    auto header_page = static_cast<HeaderPage *>(bpm->NewPage(page_id));
+    header_page->Init(bpm->GetPageSize());
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                             comparator);
+    GenericKey<8> index_key;
+    RID rid;
+    Transaction *transaction = new Transaction(0);
+    for (auto key : keys) {
+      rid.Set(0, key);
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, rid, transaction);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<RID> rids;
+    for (auto key : keys) {
+      rids.clear();
+      index_key.SetFromInteger(key);
+      tree.GetValue(index_key, rids);
+      EXPECT_EQ(key, rids[0].GetSlotNum());
+    }
+    auto lookup = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    int64_t current_key = 0;
+    for (auto iterator = tree.Begin(); iterator.isEnd() == false;
+         ++iterator) {
+      EXPECT_EQ(current_key, (*iterator).second.GetSlotNum());
+      current_key++;
+    }
+    auto scan = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(num_keys, current_key);
+
+    double lookup_s = std::chrono::duration<double>(lookup).count();
+    double scan_s = std::chrono::duration<double>(scan).count();
+    printf("page size %6zu: %10.0f lookups/s %12.0f scanned keys/s\n",
+           page_size, num_keys / lookup_s, num_keys / scan_s);
+
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+    delete transaction;
+    delete bpm;
+    delete disk_manager;
+    RemoveDatabase("test.db");
+  }
+  delete key_schema;
+}
+
+} // namespace scudb
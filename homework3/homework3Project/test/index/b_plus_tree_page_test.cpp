@@ -8,6 +8,7 @@
 #include "buffer/buffer_pool_manager.h"
 #include "common/logger.h"
 #include "common/config.h"
+#include "disk/testing_disk_util.h"
 #include "page/b_plus_tree_leaf_page.h"
 #include "vtable/virtual_table.h"
 
@@ -95,8 +96,7 @@ TEST(BPlusTreePageTests, testInternalPage) {
   delete disk_manager;
   delete bpm;
   delete key_schema;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 TEST(BPlusTreePageTests, testLeafPage) {
   char *leaf_ptr = new char[300];
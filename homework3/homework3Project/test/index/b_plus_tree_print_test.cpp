@@ -8,6 +8,7 @@
 
 #include "buffer/buffer_pool_manager.h"
 #include "common/logger.h"
+#include "disk/testing_disk_util.h"
 #include "index/b_plus_tree.h"
 #include "vtable/virtual_table.h"
 #include "gtest/gtest.h"
@@ -119,7 +120,6 @@ TEST(BptTreeTest, UnitTest) {
   delete bpm;
   delete transaction;
   delete disk_manager;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 } // namespace scudb
@@ -9,6 +9,7 @@
 
 #include "buffer/buffer_pool_manager.h"
 #include "common/logger.h"
+#include "disk/testing_disk_util.h"
 #include "index/b_plus_tree.h"
 #include "vtable/virtual_table.h"
 #include "gtest/gtest.h"
@@ -94,8 +95,7 @@ TEST(BPlusTreeTests, ScaleTest) {
   delete transaction;
   delete disk_manager;
   delete bpm;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 TEST(BPlusTreeTests, RandomTest) {
   // create KeyComparator and index schema
@@ -180,7 +180,6 @@ TEST(BPlusTreeTests, RandomTest) {
   delete transaction;
   delete disk_manager;
   delete bpm;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 } // namespace scudb
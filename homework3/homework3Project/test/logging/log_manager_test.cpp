@@ -2,6 +2,7 @@
 #include <cstdio>
 #include <cstdlib>
 
+#include "disk/testing_disk_util.h"
 #include "logging/common.h"
 #include "logging/log_recovery.h"
 #include "vtable/virtual_table.h"
@@ -53,8 +54,7 @@ TEST(LogManagerTest, BasicLogging) {
   delete txn;
   delete storage_engine;
   LOG_DEBUG("Teared down the system");
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 
 // actually LogRecovery
@@ -120,8 +120,7 @@ TEST(LogManagerTest, RedoTestWithOneTxn) {
 
   delete storage_engine;
   LOG_DEBUG("Teared down the system");
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
 }
 
 } // namespace scudb
@@ -1,7 +1,9 @@
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 #include "buffer/buffer_pool_manager.h"
+#include "disk/testing_disk_util.h"
 #include "page/header_page.h"
 #include "gtest/gtest.h"
 
@@ -52,7 +54,54 @@ TEST(HeaderPageTest, UnitTest) {
 
   delete buffer_pool_manager;
   delete disk_manager;
-  remove("test.db");
-  remove("test.log");
+  RemoveDatabase("test.db");
+}
+
+/*
+ * A database written before the header recorded its page size opens with the
+ * default page size whatever the caller asks for, and its header page keeps
+ * its records once converted
+ */
+TEST(HeaderPageTest, LegacyFormatTest) {
+  char data[PAGE_SIZE] = {0};
+  int record_count = 2;
+  page_id_t root_ids[] = {5, 7};
+  memcpy(data, &record_count, 4);
+  strcpy(data + 4, "foo");
+  memcpy(data + 4 + 32, &root_ids[0], 4);
+  strcpy(data + 40, "bar");
+  memcpy(data + 40 + 32, &root_ids[1], 4);
+  DiskManager *disk_manager = new DiskManager("test.db");
+  disk_manager->WritePage(HEADER_PAGE_ID, data);
+  delete disk_manager;
+
+  disk_manager = new DiskManager("test.db", false, 4 * PAGE_SIZE);
+  EXPECT_EQ(PAGE_SIZE, disk_manager->GetPageSize());
+  BufferPoolManager *buffer_pool_manager =
+      new BufferPoolManager(20, disk_manager);
+  HeaderPage *page =
+      static_cast<HeaderPage *>(buffer_pool_manager->FetchPage(HEADER_PAGE_ID));
+  ASSERT_NE(nullptr, page);
+  EXPECT_TRUE(page->CheckFormat());
+  EXPECT_EQ(2, page->GetRecordCount());
+  EXPECT_EQ(PAGE_SIZE, page->GetPageSize());
+  page_id_t root_id;
+  EXPECT_TRUE(page->GetRootId("foo", root_id));
+  EXPECT_EQ(5, root_id);
+  EXPECT_TRUE(page->GetRootId("bar", root_id));
+  EXPECT_EQ(7, root_id);
+  // converting is done once
+  EXPECT_TRUE(page->CheckFormat());
+  EXPECT_TRUE(page->GetRootId("bar", root_id));
+  EXPECT_EQ(7, root_id);
+
+  // a page that is not a header page is rejected
+  memset(page->GetData(), 'x', PAGE_SIZE);
+  EXPECT_FALSE(page->CheckFormat());
+  buffer_pool_manager->UnpinPage(HEADER_PAGE_ID, false);
+
+  delete buffer_pool_manager;
+  delete disk_manager;
+  RemoveDatabase("test.db");
 }
 } // namespace scudb
@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "disk/testing_disk_util.h"
 #include "logging/common.h"
 #include "table/table_heap.h"
 #include "table/tuple.h"
@@ -53,12 +54,11 @@ TEST(TupleTest, TableHeapTest) {
     // std::cout << i++ << std::endl;
     assert(table->MarkDelete(rid, transaction) == 1);
   }
-  remove("test.db"); // remove db file
-  remove("test.log");
   delete schema;
   delete table;
   delete buffer_pool_manager;
   delete disk_manager;
+  RemoveDatabase("test.db");
 }
 
 } // namespace scudb
@@ -1,6 +1,7 @@
 /**
  * virtual_table_test.cpp
  */
+#include "disk/testing_disk_util.h"
 #include "vtable/testing_vtable_util.h"
 
 namespace scudb {
@@ -11,7 +12,7 @@ TEST(VtableTest, CreateTest) {
   EXPECT_TRUE(sqlite3_threadsafe());
   std::string db_file = "sqlite.db";
   remove(db_file.c_str());
-  remove("vtable.db");
+  RemoveDatabase("vtable.db");
   sqlite3 *db;
   int rc;
   rc = sqlite3_open(db_file.c_str(), &db);
@@ -41,7 +42,7 @@ TEST(VtableTest, CreateTest) {
   EXPECT_EQ(rc, SQLITE_OK);
 
   remove(db_file.c_str());
-  remove("vtable.db");
+  RemoveDatabase("vtable.db");
   return;
 }
 } // namespace scudb